@@ -46,6 +46,10 @@ class FunctionNode final : public AstNode {
 
     const PType *getTypePtr() const { return m_ret_type.get(); }
 
+    // false for a declaration, which is defined elsewhere
+    bool hasBody() const { return m_body != nullptr; }
+    const CompoundStatementNode &getBody() const { return *m_body.get(); }
+
     const SymbolTable *getSymbolTable() const { return m_symbol_table_ptr; }
     void setSymbolTable(const SymbolTable *p_symbol_table) {
         m_symbol_table_ptr = p_symbol_table;
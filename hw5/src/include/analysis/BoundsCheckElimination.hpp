@@ -0,0 +1,149 @@
+#ifndef ANALYSIS_BOUNDS_CHECK_ELIMINATION_H
+#define ANALYSIS_BOUNDS_CHECK_ELIMINATION_H
+
+#include "AST/ast.hpp"
+#include "analysis/SideEffectAnalysis.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * The checks of the array indices (--bounds-check) that can be left out.
+ *
+ * An index whose range is within the dimension needs no check. The range is
+ * taken from the constants and the bounds of the enclosing for loops, through
+ * +, -, *, / and mod.
+ *
+ * An index made of constants and of variables that a loop doesn't assign or
+ * declare, with no calls or array elements, is checked once before the
+ * outermost such loop instead of in every iteration; a global variable also
+ * must not be written by the calls in the loop. The access has to be done in
+ * every iteration, so that the check doesn't trap where the loop wouldn't:
+ * it's neither in an if nor in a nested while loop, and no return comes
+ * before it in the loop. Neither may a print, a read, a call with side
+ * effects or a while loop come before it, whose effects a check trapping
+ * before the loop would skip, nor a check left in the loop, which would trap
+ * first. A for loop always runs at least once. The check of a while loop is
+ * done after its entry test.
+ */
+class BoundsCheckElimination final : public AstNodeVisitor {
+  public:
+    struct HoistedCheck {
+        const ExpressionNode *m_index;
+        uint64_t m_dimension;
+        // the access that traps
+        Location m_location;
+    };
+
+  private:
+    struct Loop {
+        // the variables assigned, read or declared in the loop
+        std::set<const SymbolEntry *> m_variant;
+        bool m_writes_globals = false;
+        // the conditional depth of its body
+        size_t m_body_depth = 0;
+        bool m_returns = false;
+        // an effect observable before a trap, see markEffect()
+        bool m_has_effects = false;
+        // a check is done in every iteration, so the checks after it can't
+        // be hoisted above it
+        bool m_keeps_checks = false;
+        std::vector<HoistedCheck> m_hoisted_checks;
+        // the indices (as text) and dimensions of m_hoisted_checks
+        std::set<std::pair<std::string, uint64_t>> m_hoisted_keys;
+    };
+
+    struct Candidate {
+        HoistedCheck m_check;
+        const VariableReferenceNode *m_variable_ref;
+        size_t m_index;
+        std::string m_key;
+        // the loops that do the access in every iteration, outermost first
+        std::vector<const AstNode *> m_loops;
+        // the loops enclosing the access, outermost first
+        std::vector<const AstNode *> m_enclosing_loops;
+        std::set<const SymbolEntry *> m_referenced;
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+    const SideEffectAnalysis &m_side_effects;
+
+    // (reference, index) of the checks removed or hoisted
+    std::set<std::pair<const VariableReferenceNode *, size_t>> m_unchecked;
+    size_t m_num_of_checks = 0;
+    size_t m_num_of_removed = 0;
+    size_t m_num_of_hoisted = 0;
+
+    std::map<const AstNode *, Loop> m_loops;
+    // the checks not removed, in the order they're done; those with m_loops
+    // may be hoisted
+    std::vector<Candidate> m_candidates;
+
+    std::vector<const AstNode *> m_loop_stack;
+    // [lower bound, upper bound) of the variable of each enclosing for loop
+    std::map<const SymbolEntry *, std::pair<int64_t, int64_t>> m_loop_ranges;
+    // number of ifs and while loops enclosing the node being visited
+    size_t m_depth = 0;
+
+  public:
+    ~BoundsCheckElimination() = default;
+    BoundsCheckElimination(const SymbolManager *const p_symbol_manager,
+                           const SideEffectAnalysis &p_side_effects)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_side_effects(p_side_effects) {}
+
+    // the p_index-th index of p_variable_ref is checked where it's accessed
+    bool isChecked(const VariableReferenceNode &p_variable_ref,
+                   const size_t p_index) const {
+        return m_unchecked.count({&p_variable_ref, p_index}) == 0;
+    }
+
+    // the checks done before p_loop (a WhileNode or a ForNode)
+    const std::vector<HoistedCheck> &
+    getHoistedChecks(const AstNode &p_loop) const;
+
+    size_t getNumOfChecks() const { return m_num_of_checks; }
+    size_t getNumOfRemoved() const { return m_num_of_removed; }
+    size_t getNumOfHoisted() const { return m_num_of_hoisted; }
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    // [p_min, p_max] of the values of p_expr; false if unknown
+    bool getRange(const ExpressionNode &p_expr, int64_t &p_min,
+                  int64_t &p_max) const;
+    // p_expr as text if it can be evaluated before a loop, collecting the
+    // variables it references; false otherwise
+    bool getInvariantKey(const ExpressionNode &p_expr, std::string &p_key,
+                         std::set<const SymbolEntry *> &p_referenced) const;
+    void markVariant(const SymbolEntry *p_entry);
+    // the enclosing loops do something observable, e.g., print, or may not
+    // end, before the accesses visited next
+    void markEffect();
+    bool isInvariant(const Candidate &p_candidate, const Loop &p_loop) const;
+    void selectHoistedChecks();
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef ANALYSIS_CALL_GRAPH_H
+#define ANALYSIS_CALL_GRAPH_H
+
+#include "analysis/PartialEvaluation.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Call graph of a program built from its FunctionInvocationNodes, together
+ * with the global variables each function references. The body of the
+ * program is represented by a nullptr FunctionNode.
+ *
+ * The functions reachable from the body of the program and the globals they
+ * reference are computed once the whole program is visited. The statements
+ * of the body of the program evaluated at compile time don't count.
+ */
+class CallGraph final : public AstNodeVisitor {
+  public:
+    using Functions = std::vector<const FunctionNode *>;
+
+  private:
+    const SymbolManager *m_symbol_manager_ptr;
+    const PartialEvaluation &m_partial_evaluation;
+
+    // in declaration order
+    Functions m_functions;
+    std::map<std::string, const FunctionNode *> m_name_to_function;
+
+    std::map<const FunctionNode *, std::set<std::string>> m_callee_names;
+    std::map<const FunctionNode *, std::set<const SymbolEntry *>>
+        m_referenced_globals;
+    const FunctionNode *m_current_function = nullptr;
+
+    std::set<const FunctionNode *> m_reachable_functions;
+    std::set<const SymbolEntry *> m_reachable_globals;
+
+  public:
+    ~CallGraph() = default;
+    CallGraph(const SymbolManager *const p_symbol_manager,
+              const PartialEvaluation &p_partial_evaluation)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_partial_evaluation(p_partial_evaluation) {}
+
+    const Functions &getFunctions() const { return m_functions; }
+
+    // the defined functions that p_function calls directly, in declaration
+    // order
+    Functions getCallees(const FunctionNode *p_function) const;
+    const std::set<const SymbolEntry *> &
+    getReferencedGlobals(const FunctionNode *p_function) const;
+
+    bool isReachable(const FunctionNode &p_function) const {
+        return m_reachable_functions.count(&p_function) != 0;
+    }
+    bool isReferenced(const SymbolEntry *p_global) const {
+        return m_reachable_globals.count(p_global) != 0;
+    }
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    void computeReachability();
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef ANALYSIS_FUNCTION_ORDERING_H
+#define ANALYSIS_FUNCTION_ORDERING_H
+
+#include "analysis/Profile.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Ordering of the functions in .text after Pettis and Hansen, so that the
+ * functions calling each other the most are adjacent. The body of the
+ * program is represented by a nullptr FunctionNode.
+ *
+ * A call site weighs the count that the profile gives for its compound
+ * statement, or else 10 to the power of its loop depth. Starting with each
+ * function in a chain of its own, the chains of the two ends of the heaviest
+ * call edge are merged, oriented so that the two functions meet, until no
+ * edge joins two chains. The chains are laid out from the one with the
+ * heaviest edge; the functions that the profile tells are never called go
+ * last.
+ */
+class FunctionOrdering final : public AstNodeVisitor {
+  private:
+    using Edge = std::pair<const FunctionNode *, const FunctionNode *>;
+
+    const Profile &m_profile;
+
+    // in declaration order, then the body of the program
+    std::vector<const FunctionNode *> m_functions;
+    std::map<const FunctionNode *, size_t> m_declaration_order;
+    std::map<std::string, const FunctionNode *> m_name_to_function;
+    // the sum of the weights of the calls between the two, in either way
+    std::map<Edge, uint64_t> m_weights;
+
+    const FunctionNode *m_current_function = nullptr;
+    size_t m_loop_depth = 0;
+    // the weight of the calls in the compound statement being visited
+    uint64_t m_current_weight = 1;
+
+    std::vector<const FunctionNode *> m_order;
+
+  public:
+    ~FunctionOrdering() = default;
+    FunctionOrdering(const Profile &p_profile) : m_profile(p_profile) {}
+
+    // every function, and the body of the program as nullptr
+    const std::vector<const FunctionNode *> &getOrder() const {
+        return m_order;
+    }
+
+    // the profile tells that p_function is never called
+    bool isCold(const FunctionNode *p_function) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    void visitLoopBody(const CompoundStatementNode &p_body);
+    void computeOrder();
+};
+
+#endif
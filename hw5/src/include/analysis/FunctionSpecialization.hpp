@@ -0,0 +1,118 @@
+#ifndef ANALYSIS_FUNCTION_SPECIALIZATION_H
+#define ANALYSIS_FUNCTION_SPECIALIZATION_H
+
+#include "analysis/PartialEvaluation.hpp"
+#include "analysis/Profile.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Specialization of functions on the integer constants passed by their call
+ * sites.
+ *
+ * The call sites passing the same constants to the same parameters of a
+ * function share one clone, in which those parameters are bound to the
+ * constants and which takes only the remaining arguments. The clones serving
+ * the most call sites are picked first, as long as the code growth, estimated
+ * by the number of AST nodes in the cloned bodies, stays within the budget.
+ * The call sites that the profile tells are never executed aren't worth the
+ * growth and keep calling the original function, and so do those in the
+ * statements evaluated at compile time, which are never generated.
+ */
+class FunctionSpecialization final : public AstNodeVisitor {
+  public:
+    // (index of the parameter, value) in ascending order of the index
+    using ConstantArguments = std::vector<std::pair<size_t, int32_t>>;
+
+    struct Specialization {
+        const FunctionNode *m_function;
+        ConstantArguments m_arguments;
+        std::string m_name;
+
+        // the value bound to the parameter; false if it's passed by the caller
+        bool getConstantArgument(size_t p_index, int32_t &p_value) const;
+    };
+
+  private:
+    using CallSiteKey = std::pair<const FunctionNode *, ConstantArguments>;
+
+    const SymbolManager *m_symbol_manager_ptr;
+    const size_t m_budget;
+    const Profile &m_profile;
+    const PartialEvaluation &m_partial_evaluation;
+
+    std::vector<const FunctionNode *> m_functions;
+    std::map<std::string, const FunctionNode *> m_name_to_function;
+
+    // number of AST nodes in the body of each function
+    std::map<const FunctionNode *, size_t> m_sizes;
+    size_t *m_current_size = nullptr;
+    // number of the enclosing compound statements never executed
+    size_t m_cold_depth = 0;
+
+    std::map<CallSiteKey, std::vector<const FunctionInvocationNode *>>
+        m_call_sites;
+    std::map<const FunctionNode *, size_t> m_num_of_calls;
+
+    std::vector<std::unique_ptr<Specialization>> m_specializations;
+    std::map<const FunctionInvocationNode *, const Specialization *>
+        m_specialized_calls;
+    std::set<const FunctionNode *> m_fully_specialized;
+
+  public:
+    ~FunctionSpecialization() = default;
+    FunctionSpecialization(const SymbolManager *const p_symbol_manager,
+                           const size_t p_budget, const Profile &p_profile,
+                           const PartialEvaluation &p_partial_evaluation)
+        : m_symbol_manager_ptr(p_symbol_manager), m_budget(p_budget),
+          m_profile(p_profile), m_partial_evaluation(p_partial_evaluation) {}
+
+    // the clones of p_function in the order they were created
+    std::vector<const Specialization *>
+    getSpecializations(const FunctionNode &p_function) const;
+
+    // nullptr if the call goes to the original function
+    const Specialization *
+    getSpecialization(const FunctionInvocationNode &p_func_invocation) const;
+
+    // every call goes to a clone, so the original function isn't needed
+    bool isFullySpecialized(const FunctionNode &p_function) const {
+        return m_fully_specialized.count(&p_function) != 0;
+    }
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(ConstantValueNode &p_constant_value) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    void countNode() {
+        if (m_current_size) {
+            ++*m_current_size;
+        }
+    }
+    void selectSpecializations();
+};
+
+#endif
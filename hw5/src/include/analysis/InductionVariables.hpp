@@ -0,0 +1,120 @@
+#ifndef ANALYSIS_INDUCTION_VARIABLES_H
+#define ANALYSIS_INDUCTION_VARIABLES_H
+
+#include "analysis/BoundsCheckElimination.hpp"
+#include "analysis/LoopInterchange.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+/*
+ * Induction variables of the for loops.
+ *
+ * The loop variable is the basic induction variable, stepping by one. Its
+ * product with an integer constant is a derived one, which can be kept in a
+ * slot of its own and stepped by the constant instead of being multiplied in
+ * every iteration.
+ *
+ * So is the address of an array element whose indices are constants, the
+ * loop variable plus or minus a constant, or the variables of the enclosing
+ * loops, e.g. a[i + 1][j] in the loop of i: it's computed once before the
+ * loop and stepped by the size of what i indexes. The array and the constant
+ * symbols have to be declared outside the loop, and with --bounds-check the
+ * indices must need no check. The loops of an interchanged nest enclose each
+ * other in the order they're generated in.
+ *
+ * A loop variable with no other use only has to count the iterations, or
+ * isn't needed at all if the loop steps an element address, which is then
+ * compared with its value past the last iteration.
+ */
+class InductionVariables final : public AstNodeVisitor {
+  public:
+    struct ElementPointer {
+        // the first reference to the element, which the address before the
+        // loop is computed from
+        const VariableReferenceNode *m_variable_ref;
+        // in bytes
+        int32_t m_stride;
+    };
+
+    struct Loop {
+        // referenced other than in the derived induction variables and the
+        // element addresses
+        bool m_counter_used = false;
+        // the constant factor of each derived induction variable
+        std::set<int32_t> m_strides;
+        // the distinct element addresses it steps
+        std::vector<ElementPointer> m_pointers;
+    };
+
+  private:
+    // the array and, for each index, (loop variable or nullptr, constant)
+    using ElementKey = std::vector<std::pair<const SymbolEntry *, int32_t>>;
+
+    const SymbolManager *m_symbol_manager_ptr;
+    // nullptr without --bounds-check
+    const BoundsCheckElimination *m_bounds_checks;
+    const LoopInterchange &m_interchange;
+
+    std::map<const ForNode *, Loop> m_loops;
+    // derived induction variable -> (loop, stride)
+    std::map<const BinaryOperatorNode *, std::pair<const ForNode *, int32_t>>
+        m_derived;
+    // element reference -> (loop, index in its m_pointers)
+    std::map<const VariableReferenceNode *, std::pair<const ForNode *, size_t>>
+        m_element_pointers;
+    std::map<std::pair<const ForNode *, ElementKey>, size_t> m_pointer_keys;
+
+    // loop variable and loop of the loops being visited, innermost last
+    std::vector<std::pair<const SymbolEntry *, const ForNode *>> m_loop_stack;
+
+  public:
+    ~InductionVariables() = default;
+    InductionVariables(const SymbolManager *const p_symbol_manager,
+                       const BoundsCheckElimination *const p_bounds_checks,
+                       const LoopInterchange &p_interchange)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_bounds_checks(p_bounds_checks), m_interchange(p_interchange) {}
+
+    const Loop &getLoop(const ForNode &p_for) const;
+
+    // false if p_bin_op isn't a derived induction variable
+    bool getDerived(const BinaryOperatorNode &p_bin_op, const ForNode *&p_loop,
+                    int32_t &p_stride) const;
+    // false if the address of p_variable_ref isn't stepped by a loop
+    bool getElementPointer(const VariableReferenceNode &p_variable_ref,
+                           const ForNode *&p_loop, size_t &p_index) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    // the loop whose variable p_variable_ref refers to; nullptr if none
+    const ForNode *
+    getLoopOfVariable(const VariableReferenceNode &p_variable_ref) const;
+    // the position in m_loop_stack of the loop of p_entry; false if none
+    bool getLoopPosition(const SymbolEntry *p_entry, size_t &p_position) const;
+    // false if the address of p_variable_ref can't be stepped by a loop
+    bool addElementPointer(const VariableReferenceNode &p_variable_ref);
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ANALYSIS_INTEGER_CONSTANT_H
+#define ANALYSIS_INTEGER_CONSTANT_H
+
+#include "sema/SymbolTable.hpp"
+
+#include <cstdint>
+
+class ExpressionNode;
+
+// the value of an integer literal, possibly negated, or of an integer
+// constant symbol; false for any other expression
+bool getIntegerConstant(const ExpressionNode &p_expr,
+                        const SymbolManager *p_symbol_manager,
+                        int32_t &p_value);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef ANALYSIS_LOOP_INTERCHANGE_H
+#define ANALYSIS_LOOP_INTERCHANGE_H
+
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <set>
+
+/*
+ * Interchange and tiling of perfectly nested for loops.
+ *
+ * Each entry of a loop pays for initializing its variable and its induction
+ * variables, so of two nested loops the one with fewer iterations is better
+ * put outside. The nest is interchanged only if the order of the iterations
+ * doesn't matter: the inner body consists of reductions adding terms to or
+ * subtracting them from a variable, e.g. `v := v + e1 - e2`, where the terms
+ * are made of constants and of variables the nest doesn't assign, with no
+ * calls. The integer additions wrap, so the sums don't depend on the order
+ * either.
+ *
+ * A nest whose inner body only assigns array elements is reordered for
+ * locality instead. An element is contiguous with the next one if its last
+ * index is the variable of the inner loop, and a row apart if an earlier
+ * index is, e.g. a[j][i] in the loop of j nested in the loop of i. The nest
+ * is interchanged if some references are a row apart and none contiguous.
+ * If there are both, as in a transposition, the inner loop is tiled
+ * instead (--loop-tile): the loop over its tiles goes outside, so that the
+ * rows the tile touches are reused by each iteration of the outer loop.
+ *
+ * Either is legal only if no element written in an iteration is accessed
+ * by a later iteration of the outer loop and an earlier one of the inner
+ * loop, or the other way around. The indices of the accesses to the
+ * written arrays have to be constants or a loop variable plus a constant,
+ * whose distances tell the directions of the dependences; anything else is
+ * assumed to depend in any direction. An array parameter may be any array,
+ * so it's assumed to be every other array accessed.
+ */
+class LoopInterchange final : public AstNodeVisitor {
+  private:
+    const SymbolManager *m_symbol_manager_ptr;
+
+    // iterations of each tile; 0 disables the tiling
+    const size_t m_tile_size;
+
+    // the outer loops of the nests to be interchanged
+    std::set<const ForNode *> m_interchanged;
+    // the outer loops of the nests whose inner loops are tiled
+    std::set<const ForNode *> m_tiled;
+
+  public:
+    ~LoopInterchange() = default;
+    LoopInterchange(const SymbolManager *const p_symbol_manager,
+                    const size_t p_tile_size)
+        : m_symbol_manager_ptr(p_symbol_manager), m_tile_size(p_tile_size) {}
+
+    // the inner loop of the nest p_outer is generated outside of it
+    bool isInterchanged(const ForNode &p_outer) const {
+        return m_interchanged.count(&p_outer) != 0;
+    }
+    // the loop over the tiles of the inner loop of the nest p_outer is
+    // generated outside of it, and the inner loop runs a tile
+    bool isTiled(const ForNode &p_outer) const {
+        return m_tiled.count(&p_outer) != 0;
+    }
+    size_t getTileSize() const { return m_tile_size; }
+
+    // the loop nested in p_outer if the nest is perfect; nullptr otherwise
+    static const ForNode *getInnerLoop(const ForNode &p_outer);
+
+    void visit(ProgramNode &p_program) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+
+  private:
+    bool isInterchangeable(const ForNode &p_outer,
+                           const ForNode &p_inner) const;
+    // interchange or tile the nest if its inner body only assigns array
+    // elements, and that's legal and improves the locality
+    void reorderForLocality(const ForNode &p_outer, const ForNode &p_inner);
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef ANALYSIS_LOOP_UNSWITCHING_H
+#define ANALYSIS_LOOP_UNSWITCHING_H
+
+#include "analysis/Profile.hpp"
+#include "analysis/SideEffectAnalysis.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+ * Loop unswitching: an if statement whose condition doesn't change in an
+ * enclosing loop is tested once before the loop, which is generated once for
+ * each arm of the if.
+ *
+ * The condition has to be a comparison of constants and of variables that
+ * the loop doesn't assign or declare, with no calls; a global variable also
+ * must not be written by the calls in the loop. An if is attached to the
+ * outermost loop it's invariant in. Each if doubles the copies of the loop,
+ * so the ifs are taken in order as long as the AST nodes duplicated stay
+ * within the budget. The loops that the profile tells are never entered
+ * aren't unswitched.
+ */
+class LoopUnswitching final : public AstNodeVisitor {
+  private:
+    struct Loop {
+        // the variables assigned, read or declared in the loop
+        std::set<const SymbolEntry *> m_variant;
+        bool m_writes_globals = false;
+        // number of AST nodes in the loop
+        size_t m_size = 0;
+        // the profile tells that the body is never executed
+        bool m_cold = false;
+        std::vector<const IfNode *> m_unswitched_ifs;
+    };
+
+    struct Candidate {
+        const IfNode *m_if;
+        // the enclosing loops, outermost first
+        std::vector<const AstNode *> m_loops;
+        std::set<const SymbolEntry *> m_referenced;
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+    const SideEffectAnalysis &m_side_effects;
+    const size_t m_budget;
+    const Profile &m_profile;
+
+    std::map<const AstNode *, Loop> m_loops;
+    std::vector<Candidate> m_candidates;
+
+    std::vector<const AstNode *> m_loop_stack;
+    // the condition being visited; nullptr if it can't be hoisted
+    Candidate *m_current_condition = nullptr;
+    bool m_in_condition = false;
+
+  public:
+    ~LoopUnswitching() = default;
+    LoopUnswitching(const SymbolManager *const p_symbol_manager,
+                    const SideEffectAnalysis &p_side_effects,
+                    const size_t p_budget, const Profile &p_profile)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_side_effects(p_side_effects), m_budget(p_budget),
+          m_profile(p_profile) {}
+
+    // the ifs that p_loop (a WhileNode or a ForNode) is unswitched on, in
+    // source order
+    const std::vector<const IfNode *> &
+    getUnswitchedIfs(const AstNode &p_loop) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(ConstantValueNode &p_constant_value) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    void countNode();
+    void markVariant(const SymbolEntry *p_entry);
+    bool isInvariant(const Candidate &p_candidate, const Loop &p_loop) const;
+    void selectUnswitchedIfs();
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef ANALYSIS_PARTIAL_EVALUATION_H
+#define ANALYSIS_PARTIAL_EVALUATION_H
+
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class AstNode;
+class CompoundStatementNode;
+class ExpressionNode;
+class VariableReferenceNode;
+
+/*
+ * Partial evaluation of the body of the program at compile time.
+ *
+ * Its statements are interpreted in order, calls included, until one that
+ * can't be: it reads the input, calls a function without a body, reads a
+ * variable never assigned, indexes an array out of range, uses a type other
+ * than integer, or runs out of the budget of steps (AST nodes interpreted) or
+ * of memory (bytes of the variables alive). Its effects are discarded, and it
+ * and the statements after it are left to be compiled.
+ *
+ * The statements before it are replaced by their results: the values they
+ * print, the values of the globals (initialized in .data) and those of the
+ * variables declared by the body of the program.
+ */
+class PartialEvaluation final : public AstNodeVisitor {
+  private:
+    struct Cell {
+        std::vector<int32_t> m_values;
+        std::vector<bool> m_defined;
+    };
+
+    // the elements of an array from m_offset on, which an array parameter
+    // refers to
+    struct Reference {
+        Cell *m_cell;
+        size_t m_offset;
+    };
+
+    // the variables of a call of a function, or of the body of the program
+    struct Activation {
+        std::map<const SymbolEntry *, Cell> m_variables;
+        std::map<const SymbolEntry *, Reference> m_array_parameters;
+        int32_t m_return_value = 0;
+    };
+
+    enum class Status : uint8_t {
+        kNormal,
+        kReturned,
+        kFailed
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+    const size_t m_step_budget;
+    const size_t m_memory_budget;
+
+    // the entries that the names in the AST refer to
+    std::map<const AstNode *, const SymbolEntry *> m_entries;
+    std::map<std::string, const FunctionNode *> m_name_to_function;
+
+    std::map<const SymbolEntry *, Cell> m_globals;
+    Activation m_body_activation;
+    Activation *m_activation = nullptr;
+    size_t m_num_of_steps = 0;
+    size_t m_memory = 0;
+    size_t m_call_depth = 0;
+    std::vector<int32_t> m_output;
+
+    const CompoundStatementNode *m_body = nullptr;
+    std::set<const AstNode *> m_evaluated;
+
+  public:
+    ~PartialEvaluation() = default;
+    PartialEvaluation(const SymbolManager *const p_symbol_manager,
+                      const size_t p_step_budget, const size_t p_memory_budget)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_step_budget(p_step_budget), m_memory_budget(p_memory_budget) {}
+
+    // p_statement is a statement of the body of the program replaced by its
+    // results
+    bool isEvaluated(const AstNode &p_statement) const {
+        return m_evaluated.count(&p_statement) != 0;
+    }
+    // the body of the program, whose variables are assigned the results
+    bool isEvaluatedBody(const CompoundStatementNode &p_body) const {
+        return &p_body == m_body && !m_evaluated.empty();
+    }
+    size_t getNumOfEvaluated() const { return m_evaluated.size(); }
+    size_t getNumOfSteps() const { return m_num_of_steps; }
+
+    // the values printed by the statements evaluated, in order
+    const std::vector<int32_t> &getOutput() const { return m_output; }
+    // the elements of a global or of a variable of the body of the program
+    // after the statements evaluated, the undefined ones as 0; false if it's
+    // a scalar never assigned
+    bool getValues(const SymbolEntry *p_entry,
+                   std::vector<int32_t> &p_values) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    // the AST is visited to resolve the names, and then interpreted
+    bool step();
+    bool declare(const VariableNode &p_variable);
+    void undeclare(const VariableNode &p_variable);
+    Status execute(const AstNode &p_statement);
+    Status executeCompound(const CompoundStatementNode &p_compound_statement);
+    bool evaluate(const ExpressionNode &p_expr, int32_t &p_value);
+    bool evaluateCondition(const ExpressionNode &p_expr, bool &p_value);
+    bool call(const FunctionInvocationNode &p_func_invocation,
+              int32_t &p_value);
+    // the elements p_variable_ref refers to, from p_reference.m_offset on
+    bool getReference(const VariableReferenceNode &p_variable_ref,
+                      Reference &p_reference, size_t &p_size);
+};
+
+#endif
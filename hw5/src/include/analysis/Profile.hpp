@@ -0,0 +1,43 @@
+#ifndef ANALYSIS_PROFILE_H
+#define ANALYSIS_PROFILE_H
+
+#include "AST/ast.hpp"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+/*
+ * Execution counts of the compound statements, keyed by their source
+ * locations, as dumped at exit by dumpProfile() of the runtime (io.c) for a
+ * program compiled with --profile-generate.
+ *
+ * A profile has one "<line>:<col> <count>" line per compound statement; the
+ * counts of the lines with the same location add up, so the profiles of
+ * several runs can be concatenated. The compound statements missing from
+ * the profile, e.g., those added since it was taken, have unknown counts.
+ */
+class Profile {
+  private:
+    std::map<std::pair<uint32_t, uint32_t>, uint64_t> m_counts;
+
+  public:
+    ~Profile() = default;
+    Profile() = default;
+
+    // false if the file can't be read or has a malformed line
+    bool load(const char *p_path);
+
+    bool empty() const { return m_counts.empty(); }
+
+    // false if the count is unknown
+    bool getCount(const Location &p_location, uint64_t &p_count) const;
+
+    // known to be never executed
+    bool isCold(const Location &p_location) const {
+        uint64_t count = 0;
+        return getCount(p_location, count) && count == 0;
+    }
+};
+
+#endif
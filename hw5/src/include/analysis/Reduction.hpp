@@ -0,0 +1,36 @@
+#ifndef ANALYSIS_REDUCTION_H
+#define ANALYSIS_REDUCTION_H
+
+#include "sema/SymbolTable.hpp"
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+class AssignmentNode;
+class CompoundStatementNode;
+class ExpressionNode;
+class VariableReferenceNode;
+
+// an assignment adding terms to or subtracting them from a scalar integer
+// variable, e.g. `v := v + e1 - e2`
+struct Reduction {
+    const VariableReferenceNode *m_target;
+    // each term and whether it's subtracted, from the variable outward
+    std::vector<std::pair<const ExpressionNode *, bool>> m_terms;
+};
+
+// p_assignment as a reduction whose terms satisfy p_is_term; false if it
+// isn't one
+bool getReduction(const AssignmentNode &p_assignment,
+                  const std::function<bool(const ExpressionNode &)> &p_is_term,
+                  Reduction &p_reduction);
+
+// the statements of p_body as reductions whose terms are made of constants
+// and of variables that p_body doesn't assign, with no calls; false if p_body
+// has declarations or any other statement
+bool getReductions(const CompoundStatementNode &p_body,
+                   const SymbolManager *p_symbol_manager,
+                   std::vector<Reduction> &p_reductions);
+
+#endif
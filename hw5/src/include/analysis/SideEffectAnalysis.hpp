@@ -0,0 +1,129 @@
+#ifndef ANALYSIS_SIDE_EFFECT_ANALYSIS_H
+#define ANALYSIS_SIDE_EFFECT_ANALYSIS_H
+
+#include "analysis/CallGraph.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <map>
+#include <set>
+#include <stack>
+#include <string>
+#include <vector>
+
+// what a call to a function may do, including what its callees do
+struct FunctionSummary {
+    bool reads_globals = false;
+    bool writes_globals = false;
+    // print/read
+    bool does_io = false;
+    // a while loop or recursion: may not return
+    bool may_loop = false;
+    // calls a function that is declared without a body
+    bool calls_unknown = false;
+    // with --bounds-check: indexes an array with an index not known to be in
+    // range, so the check may stop the program
+    bool may_trap = false;
+
+    // the result only depends on the arguments and nothing else is affected
+    bool isPure() const {
+        return !reads_globals && !writes_globals && !does_io &&
+               !calls_unknown;
+    }
+    // nothing observable is affected, apart from the time it takes
+    bool hasNoSideEffect() const {
+        return !writes_globals && !does_io && !calls_unknown;
+    }
+    // a call whose result is unused can be deleted
+    bool isRemovable() const {
+        return hasNoSideEffect() && !may_loop && !may_trap;
+    }
+    // the globals hold the same values after a call
+    bool preservesGlobals() const { return !writes_globals && !calls_unknown; }
+
+    void merge(const FunctionSummary &p_other) {
+        reads_globals |= p_other.reads_globals;
+        writes_globals |= p_other.writes_globals;
+        does_io |= p_other.does_io;
+        may_loop |= p_other.may_loop;
+        calls_unknown |= p_other.calls_unknown;
+        may_trap |= p_other.may_trap;
+    }
+};
+
+/*
+ * Interprocedural side-effect summaries of the functions of a program.
+ *
+ * The effects of each function body are collected first, then propagated
+ * bottom-up over the strongly connected components of the call graph, so
+ * that mutually recursive functions share one summary.
+ */
+class SideEffectAnalysis final : public AstNodeVisitor {
+  private:
+    const SymbolManager *m_symbol_manager_ptr;
+    const CallGraph &m_call_graph;
+    const bool m_bounds_check;
+
+    std::map<const FunctionNode *, FunctionSummary> m_local_summaries;
+    std::map<std::string, FunctionSummary> m_summaries;
+    std::set<const FunctionNode *> m_recursive_functions;
+    FunctionSummary *m_current_summary = nullptr;
+
+    // invocations in the arguments of an invocation
+    std::map<const FunctionInvocationNode *,
+             std::vector<const FunctionInvocationNode *>>
+        m_nested_invocations;
+    // with --bounds-check: invocations whose arguments index an array with
+    // an index not known to be in range
+    std::set<const FunctionInvocationNode *> m_trapping_invocations;
+    std::stack<const FunctionInvocationNode *> m_invocation_stack;
+
+  public:
+    ~SideEffectAnalysis() = default;
+    SideEffectAnalysis(const SymbolManager *const p_symbol_manager,
+                       const CallGraph &p_call_graph, const bool p_bounds_check)
+        : m_symbol_manager_ptr(p_symbol_manager), m_call_graph(p_call_graph),
+          m_bounds_check(p_bounds_check) {}
+
+    // printInt/readInt of io.c only do I/O; nullptr for an unknown function
+    const FunctionSummary *getSummary(const std::string &p_name) const;
+
+    // a clone of a function has the same effects as the function
+    void addClone(const std::string &p_clone, const std::string &p_name) {
+        m_summaries[p_clone] = m_summaries.at(p_name);
+    }
+
+    // in a cycle of the call graph
+    bool isRecursive(const FunctionNode &p_function) const {
+        return m_recursive_functions.count(&p_function) != 0;
+    }
+
+    // the invocation, including its arguments, can be deleted if its result
+    // is unused
+    bool isRemovable(const FunctionInvocationNode &p_func_invocation) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    bool isNonLocal(const VariableReferenceNode &p_variable_ref) const;
+    // an index isn't a constant within its dimension
+    bool mayBeOutOfRange(const VariableReferenceNode &p_variable_ref) const;
+    // the effects of the indices of p_variable_ref
+    void visitIndices(VariableReferenceNode &p_variable_ref);
+    void propagateSummaries();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef ANALYSIS_STACK_SLOT_COLORING_H
+#define ANALYSIS_STACK_SLOT_COLORING_H
+
+#include "analysis/PartialEvaluation.hpp"
+#include "sema/SymbolTable.hpp"
+#include "visitor/AstNodeVisitor.hpp"
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+/*
+ * Frame slots of the local variables and parameters, shared by those never
+ * live at the same time.
+ *
+ * The nodes of each function are numbered in the order they are visited. A
+ * variable is live from its first reference to its last one (a parameter
+ * from the entry), and throughout a loop it's referenced in but declared
+ * outside of, since its value is carried to the next iteration. A loop
+ * variable is live throughout its loop. The variables whose live ranges
+ * overlap interfere, and are colored with the lowest offsets their bytes fit
+ * in, in the order their live ranges begin; an array takes consecutive
+ * slots.
+ *
+ * The statements evaluated at compile time are skipped, and the variables of
+ * the body of the program they assign are live from its beginning.
+ */
+class StackSlotColoring final : public AstNodeVisitor {
+  private:
+    struct LiveRange {
+        const FunctionNode *m_function;
+        size_t m_begin;
+        size_t m_end;
+        size_t m_size;
+        // number of the loops enclosing the declaration
+        size_t m_loop_depth;
+        bool m_referenced = false;
+        // the offset of its first byte from the beginning of the slots
+        size_t m_offset = 0;
+    };
+
+    struct Loop {
+        size_t m_begin;
+        // the variables referenced in the loop
+        std::set<const SymbolEntry *> m_referenced;
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+    const PartialEvaluation &m_partial_evaluation;
+
+    // in the order they're declared
+    std::vector<const SymbolEntry *> m_variables;
+    std::map<const SymbolEntry *, LiveRange> m_live_ranges;
+    // bytes of the slots of each function; nullptr for the body of the
+    // program
+    std::map<const FunctionNode *, size_t> m_frame_sizes;
+
+    const FunctionNode *m_current_function = nullptr;
+    size_t m_position = 0;
+    std::vector<Loop> m_loop_stack;
+
+  public:
+    ~StackSlotColoring() = default;
+    StackSlotColoring(const SymbolManager *const p_symbol_manager,
+                      const PartialEvaluation &p_partial_evaluation)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_partial_evaluation(p_partial_evaluation) {}
+
+    // the offset of the first byte of p_variable from the beginning of the
+    // slots
+    size_t getOffset(const SymbolEntry *p_variable) const;
+    // bytes of the slots of p_function; nullptr for the body of the program
+    size_t getFrameSize(const FunctionNode *p_function) const;
+
+    void visit(ProgramNode &p_program) override;
+    void visit(DeclNode &p_decl) override;
+    void visit(VariableNode &p_variable) override;
+    void visit(FunctionNode &p_function) override;
+    void visit(CompoundStatementNode &p_compound_statement) override;
+    void visit(PrintNode &p_print) override;
+    void visit(BinaryOperatorNode &p_bin_op) override;
+    void visit(UnaryOperatorNode &p_un_op) override;
+    void visit(FunctionInvocationNode &p_func_invocation) override;
+    void visit(VariableReferenceNode &p_variable_ref) override;
+    void visit(AssignmentNode &p_assignment) override;
+    void visit(ReadNode &p_read) override;
+    void visit(IfNode &p_if) override;
+    void visit(WhileNode &p_while) override;
+    void visit(ForNode &p_for) override;
+    void visit(ReturnNode &p_return) override;
+
+  private:
+    void reference(const SymbolEntry *p_variable);
+    void beginLoop();
+    void endLoop();
+    void assignOffsets();
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef CODEGEN_ALIAS_ANALYSIS_H
+#define CODEGEN_ALIAS_ANALYSIS_H
+
+#include "analysis/SideEffectAnalysis.hpp"
+#include "codegen/MachineFunction.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Alias analysis of the loads and stores of a function.
+ *
+ * The address of each access is resolved to its base object: a frame slot
+ * (N(s0)), the expression stack (N(sp)) or a global symbol whose address is
+ * taken by la, at a constant offset if the address arithmetic allows it.
+ * Distinct base objects never alias, nor do disjoint byte ranges of the same
+ * one; the frame is private to the function as long as its address doesn't
+ * escape. P passes the arrays by reference, so a callee can write an array in
+ * the frame of its caller, but passing the address of the array marks the
+ * frame as escaped. The other arguments are passed by value, so a callee
+ * otherwise only reaches the globals, and only writes them (or the arrays
+ * passed to it) if its side-effect summary says so.
+ */
+class AliasAnalysis {
+  public:
+    enum class AliasResult : uint8_t { kNoAlias, kMayAlias, kMustAlias };
+
+    struct MemoryLocation {
+        enum class KindEnum : uint8_t {
+            kNone,  // not a memory access
+            kFrame, // N(s0)
+            kStack, // N(sp)
+            kGlobal,
+            kUnknown
+        };
+
+        KindEnum m_kind = KindEnum::kNone;
+        // the global symbol
+        std::string m_symbol;
+        bool m_offset_known = false;
+        // from s0 or from the symbol
+        int32_t m_offset = 0;
+        // bytes accessed; 0 if unknown, as is the offset, for a vector access
+        int32_t m_size = 0;
+
+        bool operator<(const MemoryLocation &p_other) const;
+        bool operator==(const MemoryLocation &p_other) const;
+    };
+
+  private:
+    // the global symbol, plus an offset if known, held by a register
+    struct Address {
+        std::string m_symbol;
+        bool m_offset_known = false;
+        int32_t m_offset = 0;
+
+        bool operator==(const Address &p_other) const {
+            return m_symbol == p_other.m_symbol &&
+                   m_offset_known == p_other.m_offset_known &&
+                   m_offset == p_other.m_offset;
+        }
+        bool operator!=(const Address &p_other) const {
+            return !(*this == p_other);
+        }
+    };
+    using AddressState = std::map<std::string, Address>;
+
+    const SideEffectAnalysis *m_side_effects;
+    bool m_frame_escaped = false;
+    // one for each instruction of the function
+    std::vector<MemoryLocation> m_locations;
+
+  public:
+    ~AliasAnalysis() = default;
+    AliasAnalysis(const MachineFunction &p_function,
+                  const SideEffectAnalysis *p_side_effects = nullptr);
+
+    // kNone if the p_index-th instruction isn't a (vector) load/store
+    const MemoryLocation &getLocation(const size_t p_index) const {
+        return m_locations[p_index];
+    }
+
+    AliasResult alias(const MemoryLocation &p_lhs,
+                      const MemoryLocation &p_rhs) const;
+
+    // the call may write the location
+    bool mayClobber(const MachineInstruction &p_call,
+                    const MemoryLocation &p_location) const;
+
+  private:
+    static void transfer(const MachineInstruction &p_inst,
+                         AddressState &p_state);
+    static MemoryLocation resolve(const MachineInstruction &p_inst,
+                                  const AddressState &p_state);
+};
+
+#endif
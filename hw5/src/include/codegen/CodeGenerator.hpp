@@ -1,15 +1,33 @@
 #ifndef CODEGEN_CODE_GENERATOR_H
 #define CODEGEN_CODE_GENERATOR_H
 
+#include "analysis/BoundsCheckElimination.hpp"
+#include "analysis/CallGraph.hpp"
+#include "analysis/FunctionOrdering.hpp"
+#include "analysis/FunctionSpecialization.hpp"
+#include "analysis/InductionVariables.hpp"
+#include "analysis/LoopInterchange.hpp"
+#include "analysis/LoopUnswitching.hpp"
+#include "analysis/PartialEvaluation.hpp"
+#include "analysis/SideEffectAnalysis.hpp"
+#include "analysis/StackSlotColoring.hpp"
+#include "codegen/CodegenOptions.hpp"
+#include "codegen/CompareChainLowering.hpp"
+#include "codegen/FunctionEmitter.hpp"
+#include "codegen/LoopVectorization.hpp"
+#include "codegen/MachineFunction.hpp"
+#include "codegen/Memoization.hpp"
+#include "codegen/SizeReport.hpp"
 #include "sema/SymbolTable.hpp"
 #include "visitor/AstNodeVisitor.hpp"
 
+#include <functional>
 #include <map>
 #include <memory>
 
 int fclose(FILE *);
 
-class CodeGenerator final : public AstNodeVisitor {
+class CodeGenerator final : public AstNodeVisitor, private FunctionEmitter {
   private:
     enum class CodegenContext : uint8_t {
         kGlobal,
@@ -26,23 +44,101 @@ class CodeGenerator final : public AstNodeVisitor {
     const SymbolManager *m_symbol_manager_ptr;
     std::string m_source_file_path;
     std::unique_ptr<FILE, FileDeleter> m_output_file;
+    std::string m_size_report_path;
+    CodegenOptions m_options;
+
+    // the statements of the body of the program evaluated at compile time
+    // are replaced by their results
+    std::unique_ptr<PartialEvaluation> m_partial_evaluation;
+    // the initial values of the variables of the body of the program and the
+    // values printed, by their labels in .rodata
+    std::vector<std::pair<std::string, std::vector<int32_t>>> m_rodata_tables;
+
+    // only the reachable functions and referenced globals are emitted
+    std::unique_ptr<CallGraph> m_call_graph;
+    std::vector<std::string> m_removed_symbols;
+    std::unique_ptr<SideEffectAnalysis> m_side_effects;
+    std::unique_ptr<Memoization> m_memoization;
+    std::unique_ptr<CompareChainLowering> m_compare_chains;
+    // nullptr if the target has no vector extension
+    std::unique_ptr<LoopVectorization> m_vectorization;
+    std::unique_ptr<FunctionSpecialization> m_specialization;
+    std::unique_ptr<InductionVariables> m_induction_variables;
+    std::unique_ptr<LoopUnswitching> m_unswitching;
+    std::unique_ptr<LoopInterchange> m_interchange;
+    std::unique_ptr<FunctionOrdering> m_ordering;
+    std::unique_ptr<BoundsCheckElimination> m_bounds_checks;
+    std::unique_ptr<StackSlotColoring> m_slot_coloring;
+
+    // instructions of the function being generated
+    std::unique_ptr<MachineFunction> m_machine_function;
+    // where the frame is extended past the fixed 128 bytes if the locals
+    // need more
+    size_t m_prologue_end = 0;
+    // the most arguments passed by a call in the function (--size-report)
+    size_t m_max_outgoing_arguments = 0;
+    SizeReport m_size_report;
+    // the source line and the estimated executions per call that the
+    // instructions emitted are tagged with (--estimate-cycles)
+    uint32_t m_source_line = 0;
+    double m_frequency = 1;
+    // the cost of each block of the functions generated, printed with them
+    std::map<const MachineFunction *, std::vector<std::string>>
+        m_cycle_annotations;
+    // the node it's generated from; nullptr for the body of the program
+    const FunctionNode *m_current_function = nullptr;
+    // the arms never taken, moved out to .text.unlikely after the function
+    MachineFunction::Instructions m_cold_instructions;
+    // the functions generated from each node, printed in the order of
+    // m_ordering once the whole program is generated
+    std::map<const FunctionNode *,
+             std::vector<std::unique_ptr<MachineFunction>>>
+        m_generated_functions;
 
     std::stack<CodegenContext> m_context_stack;
 
+    // the variables take the slots colored for them, and the temporaries the
+    // ones past them, released at the end of the loop they're used in
     size_t m_local_var_offset = 0;
+    size_t m_max_local_var_offset = 0;
     std::map<const SymbolEntry *, size_t> m_local_var_offset_map;
+    // slot of each derived induction variable, by (loop, stride)
+    std::map<std::pair<const ForNode *, int32_t>, size_t>
+        m_induction_var_offset_map;
+    // slot of each element address stepped by a loop, by (loop, index in
+    // its pointers), while the loop is generated
+    std::map<std::pair<const ForNode *, size_t>, size_t>
+        m_element_pointer_offset_map;
+    // slot of the first value of the tile that each tiled inner loop runs,
+    // while the loop over its tiles is generated
+    std::map<const ForNode *, size_t> m_tile_offset_map;
 
     bool m_ref_to_value = false;
 
+    // the epilogue that the return statements jump to
+    size_t m_return_label = 0;
+
+    // the arm taken by each if that the loop copy being generated is
+    // unswitched on
+    std::map<const IfNode *, bool> m_unswitched_arms;
+
     size_t m_label_sequence = 1;
     size_t m_comp_branch_true_label = 0;
     size_t m_comp_branch_false_label = 0;
+    // the label emitted right after the condition, which the comparison falls
+    // through to; 0 if neither
+    size_t m_comp_branch_next_label = 0;
+
+    // index of the counter of each compound statement, by its location
+    // (--profile-generate)
+    std::map<std::pair<uint32_t, uint32_t>, size_t> m_profile_counters;
 
   public:
     ~CodeGenerator() = default;
     CodeGenerator(const std::string source_file_name,
                   const std::string save_path,
-                  const SymbolManager *const p_symbol_manager);
+                  const SymbolManager *const p_symbol_manager,
+                  const CodegenOptions &p_options = CodegenOptions());
 
     void visit(ProgramNode &p_program) override;
     void visit(DeclNode &p_decl) override;
@@ -69,8 +165,78 @@ class CodeGenerator final : public AstNodeVisitor {
     static bool isInLocal(const std::stack<CodegenContext> &p_context_stack) {
         return p_context_stack.top() == CodegenContext::kLocal;
     }
+    void generateFunction(
+        FunctionNode &p_function,
+        const FunctionSpecialization::Specialization *p_specialization);
+    void storeArgumentsToParameters(
+        const FunctionNode::DeclNodes &p_parameters,
+        const FunctionSpecialization::Specialization *p_specialization);
+    // the declarations and the statements of p_compound_statement, in the
+    // scope already reconstructed
+    void generateStatements(const CompoundStatementNode &p_compound_statement);
+    // test the unswitched ifs of p_loop from the p_index-th on, and generate
+    // a copy of the loop for each combination of their arms
+    void unswitchLoop(const AstNode &p_loop, const size_t p_index,
+                      const std::function<void()> &p_generate_loop);
+    // p_body under p_label in .text.unlikely, jumping back to p_out_label
+    void generateColdArm(const CompoundStatementNode &p_body,
+                         const size_t p_label, const size_t p_out_label);
+    // move the instructions from p_begin on to .text.unlikely
+    void moveToColdSection(const size_t p_begin);
+    void generateWhile(WhileNode &p_while);
+    void generateFor(ForNode &p_for);
+    // the loop itself, with p_generate_body as the body; the symbol table of
+    // p_for should have been reconstructed. If p_tile_offset isn't 0, the
+    // loop only runs the tile starting from the value in that slot
+    void generateForLoop(ForNode &p_for,
+                         const std::function<void()> &p_generate_body,
+                         const size_t p_tile_offset = 0);
+    void loadExpression(const ExpressionNode &p_expr) override;
+    void storeToVariable(const VariableReferenceNode &p_variable_ref,
+                         const char *p_reg) override;
     void
-    storeArgumentsToParameters(const FunctionNode::DeclNodes &p_parameters);
+    emitElementAddress(const VariableReferenceNode &p_variable_ref) override;
+    // trap if the index in t0 isn't in [0, p_dimension) (--bounds-check)
+    void emitBoundsCheck(const uint64_t p_dimension,
+                         const Location &p_location);
+    // the checks hoisted out of p_loop, done before it
+    void emitHoistedBoundsChecks(const AstNode &p_loop);
+
+    // branch on the comparison of t1 with t0 to the true/false labels
+    void emitComparisonBranch(const char *p_op, const char *p_inverse_op);
+
+    // count the executions of the compound statement at p_location
+    void emitProfileCounter(const Location &p_location);
+    // call the runtime to write the counts out, at the exit of main
+    void emitProfileDump();
+    // the table of counters in .bss and their locations in .rodata
+    void emitProfileTables(const ProgramNode &p_program);
+
+    // print the output of the statements evaluated at compile time and
+    // assign their results to the variables of p_body
+    void emitPartialEvaluationResults(const CompoundStatementNode &p_body);
+    // p_values as .word directives, the runs of zeros as .zero
+    void emitWords(const std::vector<int32_t> &p_values);
+
+    size_t allocateTemporarySlot() override;
+    void generateScaled(const double p_factor,
+                        const std::function<void()> &p_generate) override;
+    size_t getNewLabel() override { return m_label_sequence++; }
+    size_t getLocalVariableOffset(const SymbolEntry *p_entry) const override;
+    void emitFrameAccess(const char *p_op, const char *p_reg,
+                         const size_t p_offset) override;
+    // s0 - p_offset into p_reg
+    void emitFrameAddress(const char *p_reg, const size_t p_offset);
+    MachineFunction &getMachineFunction() override {
+        return *m_machine_function;
+    }
+    void generate(AstNode &p_node) override;
+
+    void emitInstructions(const char *format, ...) override
+        __attribute__((format(printf, 2, 3)));
+    void beginFunction(const char *p_name);
+    void endFunction();
+    void printFunctions();
 };
 
 #endif
@@ -0,0 +1,82 @@
+#ifndef CODEGEN_CODEGEN_OPTIONS_H
+#define CODEGEN_CODEGEN_OPTIONS_H
+
+#include "analysis/Profile.hpp"
+#include "codegen/LatencyModel.hpp"
+
+#include <cstddef>
+
+// command-line options that affect the code generation
+struct CodegenOptions {
+    // list the functions and globals removed as unreachable to stderr
+    bool print_removed = false;
+    // print the optimized instructions of each function to stdout, annotated
+    // with the value ranges of the registers
+    bool dump_ir = false;
+
+    // cache the results of pure recursive functions in a table in .bss
+    bool auto_memoize = false;
+    // upper bound of the size of the table of each function in bytes
+    size_t memoize_budget = 4096;
+
+    // upper bound of the AST nodes duplicated by cloning functions for their
+    // constant arguments; 0 disables the specialization
+    size_t specialize_budget = 256;
+
+    // upper bound of the AST nodes duplicated by unswitching each loop on its
+    // invariant if statements; 0 disables the unswitching
+    size_t unswitch_budget = 128;
+
+    // iterations of each tile of the inner loops tiled for locality, e.g.
+    // to fit the rows they touch in the cache; 0 disables the tiling
+    size_t loop_tile = 0;
+
+    // the target has the vector extension (+v), so that the element-wise and
+    // reduction loops are vectorized
+    bool vector = false;
+
+    // emit the compressed forms of the instructions (C extension), and
+    // report the size of each function before and after to stderr
+    bool compress = false;
+
+    // the latencies the instructions are scheduled for
+    LatencyModel latency_model;
+    // report the estimated stalls of each function before and after the
+    // scheduling to stderr
+    bool print_stalls = false;
+
+    // count the executions of each compound statement, and dump the counts
+    // to <program name>.profile at exit
+    bool profile_generate = false;
+    // the counts of an instrumented run, which the layout of the ifs, the
+    // specialization and the unswitching follow; empty if not given
+    Profile profile;
+
+    // trap on the array indices out of range, except those proven in range;
+    // the checks of the indices a loop doesn't change are done once before
+    // it. The number of checks removed is reported to stderr.
+    bool bounds_check = false;
+
+    // upper bound of the AST nodes interpreted to evaluate the statements of
+    // the body of the program at compile time; 0 disables the evaluation
+    size_t partial_eval_budget = 1000000;
+    // upper bound of the bytes of the variables alive during the evaluation
+    size_t partial_eval_memory = 65536;
+
+    // write the code size and the stack usage of each function, as JSON, to
+    // <program name>.size.json next to the assembly
+    bool size_report = false;
+
+    // annotate each basic block with its cycles estimated by the latency
+    // model, and report the cycles of each function and source line per call
+    // to stderr
+    bool estimate_cycles = false;
+    // iterations assumed for each while loop in the estimate
+    size_t while_trip_count = 10;
+
+    // map the instructions to the lines of the source file with .file/.loc,
+    // from which the assembler emits .debug_line
+    bool debug_line = false;
+};
+
+#endif
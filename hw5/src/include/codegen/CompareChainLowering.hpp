@@ -0,0 +1,52 @@
+#ifndef CODEGEN_COMPARE_CHAIN_LOWERING_H
+#define CODEGEN_COMPARE_CHAIN_LOWERING_H
+
+#include "codegen/FunctionEmitter.hpp"
+#include "sema/SymbolTable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CompoundStatementNode;
+class IfNode;
+
+/*
+ * Lowering of the if/else chains comparing one scalar integer variable with
+ * distinct constants, the "case" statement of P.
+ *
+ * The variable is loaded once and dispatched on with a bounds-checked jump
+ * table in .rodata if the values are dense enough, or with a balanced binary
+ * search otherwise. The chain ends at the first if that doesn't compare the
+ * same variable with a new constant, or at an else body that is more than
+ * another if; the rest of it is generated as the default.
+ */
+class CompareChainLowering {
+  private:
+    // a branch of the chain
+    struct Case {
+        int32_t m_value;
+        const CompoundStatementNode *m_body;
+        size_t m_label;
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+
+  public:
+    ~CompareChainLowering() = default;
+    CompareChainLowering(const SymbolManager *p_symbol_manager)
+        : m_symbol_manager_ptr(p_symbol_manager) {}
+
+    // lower the chain starting at p_if; false if it isn't a long enough
+    // chain, and nothing is emitted
+    bool lower(FunctionEmitter &p_emitter, IfNode &p_if) const;
+
+  private:
+    // p_cases[p_begin, p_end) sorted by value
+    void emitBinarySearch(FunctionEmitter &p_emitter,
+                          const std::vector<Case> &p_cases,
+                          const size_t p_begin, const size_t p_end,
+                          const size_t p_default_label) const;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef CODEGEN_CYCLE_ESTIMATOR_H
+#define CODEGEN_CYCLE_ESTIMATOR_H
+
+#include "codegen/LatencyModel.hpp"
+#include "codegen/MachineFunction.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Static estimate of the cycles a function takes per call (--estimate-cycles).
+ *
+ * Each basic block is issued on the in-order, single-issue pipeline that
+ * InstructionScheduler schedules for: an instruction takes a cycle, plus the
+ * stall until its operands are ready, and the operands are assumed to be
+ * ready on entry. The cost of each instruction is weighted by the estimated
+ * executions that CodeGenerator tags it with, which follow the trip counts of
+ * the loops enclosing it and halve at each branch, and summed per function
+ * and per source line it's generated for.
+ */
+class CycleEstimator {
+  public:
+    struct Estimate {
+        double m_cycles = 0;
+        // source line -> cycles; the instructions of no line are left out
+        std::map<uint32_t, double> m_lines;
+        // the cost of each block at its first instruction, one-to-one mapped
+        // to the instructions
+        std::vector<std::string> m_annotations;
+    };
+
+  private:
+    const LatencyModel &m_latency_model;
+
+  public:
+    ~CycleEstimator() = default;
+    CycleEstimator(const LatencyModel &p_latency_model)
+        : m_latency_model(p_latency_model) {}
+
+    Estimate run(const MachineFunction &p_function) const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef CODEGEN_FRAME_SLOT_FORWARDING_H
+#define CODEGEN_FRAME_SLOT_FORWARDING_H
+
+#include "codegen/MachineFunction.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+/*
+ * Dataflow optimization on the frame slots (-N(s0)) of a function:
+ *   - forwards a stored/loaded value to the later loads of the same slot
+ *   - propagates slot-to-slot copies (x := y) into the later loads of x
+ *   - removes the stores whose slot is never reloaded
+ *
+ * It's skipped if the address of the frame escapes (e.g., addi t0, s0, -N),
+ * since the slots may then be accessed through other registers.
+ */
+class FrameSlotForwarding {
+  private:
+    struct SlotState {
+        // (register, slot): the register holds the current value of the slot
+        std::set<std::pair<std::string, int32_t>> m_reg_holds;
+        // slot -> another slot that holds the same value
+        std::map<int32_t, int32_t> m_copy_of;
+
+        bool operator==(const SlotState &p_other) const {
+            return m_reg_holds == p_other.m_reg_holds &&
+                   m_copy_of == p_other.m_copy_of;
+        }
+        bool operator!=(const SlotState &p_other) const {
+            return !(*this == p_other);
+        }
+
+        void meet(const SlotState &p_other);
+        void killRegister(const std::string &p_reg);
+        void killSlot(const int32_t p_slot);
+    };
+
+  public:
+    ~FrameSlotForwarding() = default;
+    FrameSlotForwarding() = default;
+
+    void run(MachineFunction &p_function);
+
+  private:
+    static void foldPushPopPairs(MachineFunction &p_function);
+    static void transfer(const MachineInstruction &p_inst, SlotState &p_state);
+    static void forwardStoredValues(MachineFunction &p_function);
+    static void removeDeadStores(MachineFunction &p_function);
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CODEGEN_FUNCTION_EMITTER_H
+#define CODEGEN_FUNCTION_EMITTER_H
+
+#include "codegen/MachineFunction.hpp"
+#include "sema/SymbolTable.hpp"
+
+#include <cstddef>
+#include <functional>
+
+// the body of a loop starts at a boundary of the fetch width (16 bytes)
+constexpr const char *kLoopHeadAlignment = "    .align 4\n";
+
+class AstNode;
+class ExpressionNode;
+class VariableReferenceNode;
+
+/*
+ * What the lowerings split out of CodeGenerator generate a function through.
+ *
+ * The assembly is appended to the function being generated, tagged with the
+ * source line and the estimated executions that CodeGenerator tracks, and
+ * the statements and expressions nested in the constructs being lowered are
+ * generated by CodeGenerator itself.
+ */
+class FunctionEmitter {
+  public:
+    virtual ~FunctionEmitter() = default;
+
+    // printf-like lines of assembly; written to the output directly between
+    // functions
+    virtual void emitInstructions(const char *format, ...)
+        __attribute__((format(printf, 2, 3))) = 0;
+    virtual size_t getNewLabel() = 0;
+    // the offset of a slot for a temporary, released at the end of the loop
+    // it's used in
+    virtual size_t allocateTemporarySlot() = 0;
+    // the offset of the slot of a local variable or parameter
+    virtual size_t getLocalVariableOffset(const SymbolEntry *p_entry) const = 0;
+    // p_op (lw or sw) of p_reg and the slot p_offset bytes below s0; a slot
+    // past the 12-bit offset is addressed through p_reg for a load and t3
+    // for a store
+    virtual void emitFrameAccess(const char *p_op, const char *p_reg,
+                                 const size_t p_offset) = 0;
+    virtual MachineFunction &getMachineFunction() = 0;
+
+    // a declaration or a statement
+    virtual void generate(AstNode &p_node) = 0;
+    // evaluate p_expr into t0
+    virtual void loadExpression(const ExpressionNode &p_expr) = 0;
+    virtual void storeToVariable(const VariableReferenceNode &p_variable_ref,
+                                 const char *p_reg) = 0;
+    // the address of the element, or of the subarray if there are fewer
+    // indices than dimensions, into t0
+    virtual void
+    emitElementAddress(const VariableReferenceNode &p_variable_ref) = 0;
+    // p_generate with the estimated executions scaled by p_factor
+    virtual void generateScaled(const double p_factor,
+                                const std::function<void()> &p_generate) = 0;
+};
+
+#endif
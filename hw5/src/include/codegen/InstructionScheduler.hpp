@@ -0,0 +1,53 @@
+#ifndef CODEGEN_INSTRUCTION_SCHEDULER_H
+#define CODEGEN_INSTRUCTION_SCHEDULER_H
+
+#include "codegen/AliasAnalysis.hpp"
+#include "codegen/LatencyModel.hpp"
+#include "codegen/MachineFunction.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * List scheduling of the instructions of each basic block for an in-order,
+ * single-issue pipeline, which stalls until the operands of an instruction
+ * are ready.
+ *
+ * The instructions are ordered by their dependences on the registers and,
+ * as told by AliasAnalysis, on the memory. Each cycle the ready instruction
+ * with the longest latency-weighted path to the end of the block is issued,
+ * so that independent loads and arithmetic fill the latency of the others.
+ * The calls, the vector instructions (whose registers aren't tracked) and
+ * the terminators stay in place, and the instructions are scheduled between
+ * them.
+ */
+class InstructionScheduler {
+  public:
+    struct StallReport {
+        size_t m_before = 0;
+        size_t m_after = 0;
+    };
+
+  private:
+    const LatencyModel &m_latency_model;
+
+  public:
+    ~InstructionScheduler() = default;
+    InstructionScheduler(const LatencyModel &p_latency_model)
+        : m_latency_model(p_latency_model) {}
+
+    // return the static estimate of the stalls of the function, each block
+    // counted once, before and after
+    StallReport run(MachineFunction &p_function);
+
+    size_t estimateStalls(const MachineFunction &p_function) const;
+
+  private:
+    // the order to issue p_insts[p_begin, p_end) in
+    std::vector<size_t> schedule(const MachineFunction::Instructions &p_insts,
+                                 const AliasAnalysis &p_alias,
+                                 const size_t p_begin,
+                                 const size_t p_end) const;
+};
+
+#endif
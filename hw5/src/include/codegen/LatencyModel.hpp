@@ -0,0 +1,34 @@
+#ifndef CODEGEN_LATENCY_MODEL_H
+#define CODEGEN_LATENCY_MODEL_H
+
+#include "codegen/MachineFunction.hpp"
+
+#include <map>
+#include <string>
+
+/*
+ * Cycles from the issue of an instruction until its result can be used on
+ * the target core.
+ *
+ * A model file has one "<name> <cycles>" pair per line, where the name is a
+ * mnemonic, one of the classes "load", "mul" and "div" (div/rem and their
+ * unsigned forms), or "default" for the rest; '#' starts a comment. The
+ * mnemonics take precedence over the classes. The built-in model is that of
+ * a short in-order pipeline like Bumblebee's: loads take 2 cycles,
+ * multiplications 3 and divisions 33.
+ */
+class LatencyModel {
+  private:
+    std::map<std::string, unsigned> m_latencies;
+
+  public:
+    ~LatencyModel() = default;
+    LatencyModel();
+
+    // false if the file can't be read or has a malformed line
+    bool load(const char *p_path);
+
+    unsigned getLatency(const MachineInstruction &p_inst) const;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CODEGEN_LOOP_VECTORIZATION_H
+#define CODEGEN_LOOP_VECTORIZATION_H
+
+#include "analysis/BoundsCheckElimination.hpp"
+#include "codegen/FunctionEmitter.hpp"
+#include "sema/SymbolTable.hpp"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CompoundStatementNode;
+class ExpressionNode;
+class ForNode;
+class VariableReferenceNode;
+
+/*
+ * Vectorization of the element-wise and reduction loops for the vector
+ * extension (--target-feature=+v).
+ *
+ * A for loop whose body assigns integer array elements indexed by the loop
+ * variable, e.g. `c[i] := a[i] + b[i]`, or adds terms to or subtracts them
+ * from scalar integer variables, e.g. `s := s + c[i]`, runs as a
+ * strip-mined loop, vl iterations at a time with e32 elements, where the
+ * tail is the last strip with a shorter vl. The elements whose last index is
+ * the loop variable plus or minus a constant are loaded and stored with
+ * vle32/vse32 from the address of the first lane, and the lanes of the loop
+ * variable itself are in v1 if it's used. Each reduced variable gets an
+ * accumulator whose lanes sum their own iterations, summed back with vredsum
+ * after the loop.
+ *
+ * The statements run one after the other for each strip, so an array
+ * written by the loop may only be accessed at the element written, in the
+ * same iteration; an array parameter may be any array, so none other is
+ * accessed along with it. With --bounds-check, the indices must need no
+ * check in the loop.
+ */
+class LoopVectorization {
+  private:
+    // a statement of the body
+    struct Statement {
+        // a scalar variable reduced, or an element stored
+        const VariableReferenceNode *m_target;
+        // stored to the element; nullptr for a reduction
+        const ExpressionNode *m_value;
+        // of the reduction, and whether each is subtracted
+        std::vector<std::pair<const ExpressionNode *, bool>> m_terms;
+    };
+
+    // what the body of the loop being vectorized assigns
+    struct Body {
+        std::string m_loop_var;
+        std::set<const SymbolEntry *> m_reduced;
+        // the element written of each array
+        std::vector<const VariableReferenceNode *> m_written;
+    };
+
+    const SymbolManager *m_symbol_manager_ptr;
+    // nullptr without --bounds-check
+    const BoundsCheckElimination *m_bounds_checks;
+
+  public:
+    ~LoopVectorization() = default;
+    LoopVectorization(const SymbolManager *p_symbol_manager,
+                      const BoundsCheckElimination *p_bounds_checks)
+        : m_symbol_manager_ptr(p_symbol_manager),
+          m_bounds_checks(p_bounds_checks) {}
+
+    // generate p_for running p_body in vector registers; false if it can't
+    // be vectorized, and nothing is emitted. The symbol table of p_for
+    // should have been reconstructed
+    bool generate(FunctionEmitter &p_emitter, ForNode &p_for,
+                  const CompoundStatementNode &p_body) const;
+
+  private:
+    // p_body as statements that p_for can run in vector registers
+    bool getStatements(const ForNode &p_for,
+                       const CompoundStatementNode &p_body,
+                       std::vector<Statement> &p_statements) const;
+    // an integer expression each lane can evaluate
+    bool isVectorizable(const ExpressionNode &p_expr,
+                        const Body &p_body) const;
+    // doesn't depend on the iteration
+    bool isInvariant(const ExpressionNode &p_expr, const Body &p_body) const;
+    // an integer element whose last index is the loop variable plus or minus
+    // a constant, and whose other indices are invariant
+    bool isContiguous(const VariableReferenceNode &p_variable_ref,
+                      const Body &p_body) const;
+    // evaluate p_expr for each lane into v<p_reg>, using the registers above
+    // it as temporaries; return the register holding the result
+    unsigned emitExpression(FunctionEmitter &p_emitter,
+                            const ExpressionNode &p_expr,
+                            const std::string &p_loop_var,
+                            const unsigned p_reg) const;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef CODEGEN_MACHINE_FUNCTION_H
+#define CODEGEN_MACHINE_FUNCTION_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// "offset(base)" operand of loads and stores
+struct MemoryOperand {
+    int32_t offset;
+    std::string base;
+};
+
+bool parseMemoryOperand(const std::string &p_operand, MemoryOperand &p_mem);
+// false for a symbolic immediate
+bool parseImmediate(const std::string &p_operand, int32_t &p_imm);
+// the register-register form of an instruction with an immediate operand,
+// e.g. add for addi; "" if there's none
+std::string getRegisterForm(const std::string &p_op);
+bool isCallerSavedRegister(const std::string &p_reg);
+
+class MachineInstruction {
+  public:
+    enum class KindEnum : uint8_t { kLabel, kDirective, kInstruction };
+    using Operands = std::vector<std::string>;
+
+  private:
+    KindEnum m_kind;
+    // label name, the whole directive line or the mnemonic
+    std::string m_opcode;
+    Operands m_operands;
+    // the source line it's generated for; 0 if unknown
+    uint32_t m_line = 0;
+    // estimated executions per call of the function
+    double m_frequency = 1;
+
+  public:
+    ~MachineInstruction() = default;
+    MachineInstruction(const KindEnum kind, const std::string &p_opcode,
+                       const Operands &p_operands = {})
+        : m_kind(kind), m_opcode(p_opcode), m_operands(p_operands) {}
+
+    // parse one line of the assembly that CodeGenerator emits
+    static MachineInstruction parse(const std::string &p_line);
+
+    KindEnum getKind() const { return m_kind; }
+    bool isLabel() const { return m_kind == KindEnum::kLabel; }
+    bool isDirective() const { return m_kind == KindEnum::kDirective; }
+    bool isInstruction() const { return m_kind == KindEnum::kInstruction; }
+
+    const std::string &getOpcode() const { return m_opcode; }
+    const Operands &getOperands() const { return m_operands; }
+
+    void setOpcode(const std::string &p_opcode) { m_opcode = p_opcode; }
+    void setOperands(const Operands &p_operands) { m_operands = p_operands; }
+    // replace the instruction, keeping the source it's generated for
+    void rewrite(const std::string &p_opcode, const Operands &p_operands) {
+        m_opcode = p_opcode;
+        m_operands = p_operands;
+    }
+
+    uint32_t getLine() const { return m_line; }
+    double getFrequency() const { return m_frequency; }
+    void setSource(const uint32_t p_line, const double p_frequency) {
+        m_line = p_line;
+        m_frequency = p_frequency;
+    }
+
+    bool isLoad() const;
+    bool isStore() const;
+    // unit-stride vector load/store, e.g. vle32.v vd, (rs1); the vl elements
+    // from the address in rs1 are accessed, so the extent isn't known here
+    bool isVectorLoad() const;
+    bool isVectorStore() const;
+    bool isBranch() const;
+    bool isJump() const;
+    bool isCall() const;
+    bool isReturn() const;
+    // jr through a jump table
+    bool isIndirectJump() const;
+    // vsetvli; it also sets the vector length for the vector instructions
+    // that follow, which don't name the registers they use
+    bool isVectorConfiguration() const;
+    bool isTerminator() const {
+        return isBranch() || isJump() || isReturn() || isIndirectJump();
+    }
+
+    // label that a branch/jump/call transfers control to
+    const std::string &getTarget() const { return m_operands.back(); }
+
+    // "" if the instruction doesn't write any register
+    std::string getDefinedRegister() const;
+    std::vector<std::string> getUsedRegisters() const;
+
+    std::string toString() const;
+    void print(FILE *p_out_file) const;
+};
+
+struct MachineBasicBlock {
+    // [begin, end) in MachineFunction::getInstructions()
+    size_t begin;
+    size_t end;
+    std::vector<size_t> successors;
+    std::vector<size_t> predecessors;
+};
+
+class MachineFunction {
+  public:
+    using Instructions = std::vector<MachineInstruction>;
+    using BasicBlocks = std::vector<MachineBasicBlock>;
+
+  private:
+    std::string m_name;
+    Instructions m_instructions;
+    // label of the table -> the label of each entry; emitted in .rodata
+    // after the function
+    std::map<std::string, std::vector<std::string>> m_jump_tables;
+
+  public:
+    ~MachineFunction() = default;
+    MachineFunction(const std::string &p_name) : m_name(p_name) {}
+
+    const std::string &getName() const { return m_name; }
+
+    Instructions &getInstructions() { return m_instructions; }
+    const Instructions &getInstructions() const { return m_instructions; }
+
+    // split the text into lines and parse each of them
+    void appendAssembly(const std::string &p_text);
+
+    void addJumpTable(const std::string &p_label,
+                      const std::vector<std::string> &p_targets) {
+        m_jump_tables[p_label] = p_targets;
+    }
+
+    // remove the instructions whose flag is set, and the jump tables no
+    // longer referenced
+    void removeInstructions(const std::vector<bool> &p_removed);
+
+    // a .loc of file p_file before each instruction whose source line isn't
+    // the one before it in layout order, restated after a section changes
+    void addLineDirectives(const unsigned p_file);
+
+    // blocks are split at labels and after terminators, in layout order; an
+    // indirect jump may go to any entry of the jump tables
+    BasicBlocks computeBasicBlocks() const;
+
+    // true if s0 is used other than as the base of a scalar load/store, in
+    // which case the frame slots may be accessed through other registers
+    bool isFrameAddressEscaped() const;
+
+    void print(FILE *p_out_file) const;
+    // with a comment after each instruction that has a non-empty annotation
+    void print(FILE *p_out_file,
+               const std::vector<std::string> &p_annotations) const;
+
+  private:
+    void printJumpTables(FILE *p_out_file) const;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef CODEGEN_MEMOIZATION_H
+#define CODEGEN_MEMOIZATION_H
+
+#include "analysis/SideEffectAnalysis.hpp"
+#include "codegen/FunctionEmitter.hpp"
+
+#include <cstddef>
+#include <string>
+
+class FunctionNode;
+
+/*
+ * Memoization of the pure recursive functions (--auto-memoize).
+ *
+ * The results of a function are cached in a table in .bss, indexed by its
+ * arguments in row-major order, with a byte for each entry telling it's
+ * valid. Only the calls whose arguments are all in [0, dimension) are
+ * cached, for the largest dimension whose table fits in the budget. A
+ * function that accesses globals, does I/O, calls a function without a body
+ * or takes anything but scalar integers isn't memoized.
+ */
+class Memoization {
+  private:
+    const SideEffectAnalysis &m_side_effects;
+    // upper bound of the size of each table in bytes
+    const size_t m_budget;
+
+    // of the function being generated; 0 if it isn't memoized
+    size_t m_dimension = 0;
+    std::string m_name;
+    // the slot of the index of the entry, -1 if it isn't cached
+    size_t m_index_offset = 0;
+    size_t m_done_label = 0;
+
+  public:
+    ~Memoization() = default;
+    Memoization(const SideEffectAnalysis &p_side_effects,
+                const size_t p_budget)
+        : m_side_effects(p_side_effects), m_budget(p_budget) {}
+
+    // decide whether p_function is memoized, reporting why to stderr, and
+    // declare its table; before the function is begun
+    bool begin(FunctionEmitter &p_emitter, const FunctionNode &p_function);
+    // return the cached result if it's valid; after the arguments are stored
+    // to the parameters
+    void emitLookup(FunctionEmitter &p_emitter,
+                    const FunctionNode &p_function);
+    // cache the result in a0, at the epilogue of the function, which isn't
+    // memoized past it
+    void end(FunctionEmitter &p_emitter);
+
+    bool isMemoizing() const { return m_dimension != 0; }
+
+  private:
+    // 0 if the function isn't worth/safe to memoize, and p_reason tells why
+    size_t getDimension(const FunctionNode &p_function,
+                        const char *&p_reason) const;
+};
+
+#endif
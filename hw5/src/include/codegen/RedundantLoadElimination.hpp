@@ -0,0 +1,39 @@
+#ifndef CODEGEN_REDUNDANT_LOAD_ELIMINATION_H
+#define CODEGEN_REDUNDANT_LOAD_ELIMINATION_H
+
+#include "analysis/SideEffectAnalysis.hpp"
+#include "codegen/AliasAnalysis.hpp"
+#include "codegen/MachineFunction.hpp"
+
+#include <set>
+#include <string>
+#include <utility>
+
+/*
+ * Redundant load elimination on the global variables of a function: a load
+ * of a word that a register still holds, since it was loaded or stored, is
+ * replaced with a move. The stores and calls that may write the word are
+ * told by AliasAnalysis. (The frame slots are left to FrameSlotForwarding.)
+ */
+class RedundantLoadElimination {
+  private:
+    // (register, location): the register holds the word at the location
+    using Facts = std::set<std::pair<std::string, AliasAnalysis::MemoryLocation>>;
+
+    const SideEffectAnalysis *m_side_effects;
+
+  public:
+    ~RedundantLoadElimination() = default;
+    RedundantLoadElimination(const SideEffectAnalysis *p_side_effects = nullptr)
+        : m_side_effects(p_side_effects) {}
+
+    // return true if the function is changed
+    bool run(MachineFunction &p_function);
+
+  private:
+    static void transfer(const MachineInstruction &p_inst,
+                         const AliasAnalysis::MemoryLocation &p_location,
+                         const AliasAnalysis &p_alias, Facts &p_facts);
+};
+
+#endif
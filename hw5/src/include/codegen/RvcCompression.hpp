@@ -0,0 +1,51 @@
+#ifndef CODEGEN_RVC_COMPRESSION_H
+#define CODEGEN_RVC_COMPRESSION_H
+
+#include "codegen/MachineFunction.hpp"
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Rewriting of a function into the compressed (C extension) forms, as the
+ * last step before it's printed:
+ *   - each of the temporaries t0-t2 is renamed to a5-a3 respectively, which
+ *     the 3-bit register fields of most compressed forms can encode, unless
+ *     one of the two is written where the other is live
+ *   - the frame slots are accessed through sp at non-negative offsets, which
+ *     c.lwsp/c.swsp can encode, wherever sp is a known distance from s0
+ *   - each instruction that has a compressed form is replaced with it
+ *   - so is each branch on a register compared with zero and each jump
+ *     whose label is in the reach of the compressed offset, measured with
+ *     the largest padding of each .align in between
+ *
+ * The sizes reported are an upper bound, since the assembler and the linker
+ * may still shorten the pseudo-instructions.
+ */
+class RvcCompression {
+  public:
+    struct SizeReport {
+        size_t m_uncompressed = 0;
+        size_t m_compressed = 0;
+    };
+
+    ~RvcCompression() = default;
+    RvcCompression() = default;
+
+    // return the size of the function in bytes before and after
+    SizeReport run(MachineFunction &p_function);
+
+    // bytes of the instructions, the pseudo-instructions expanded
+    static size_t getSize(const MachineFunction &p_function);
+
+  private:
+    static void renameTemporaries(MachineFunction &p_function);
+    static void rewriteFrameAccesses(MachineFunction &p_function);
+    // false if p_inst has no compressed form
+    static bool compress(MachineInstruction &p_inst);
+    // the branches and jumps whose labels are close enough
+    static void compressBranches(MachineFunction &p_function);
+    static size_t getSize(const MachineInstruction &p_inst);
+};
+
+#endif
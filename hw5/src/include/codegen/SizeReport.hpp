@@ -0,0 +1,64 @@
+#ifndef CODEGEN_SIZE_REPORT_H
+#define CODEGEN_SIZE_REPORT_H
+
+#include "codegen/MachineFunction.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Code size and stack usage of the generated functions (--size-report),
+ * printed as JSON.
+ *
+ * Each function is measured once it's optimized: its instructions and their
+ * bytes (the pseudo-instructions expanded, the compressed ones 2 bytes), the
+ * values still spilled to the expression stack, and the bytes pushed below
+ * its frame, at most and at each call. The instructions are scanned in
+ * layout order, which keeps the pushes of each statement balanced.
+ *
+ * The worst-case stack depth of a function is its frame plus the most it
+ * pushes, or plus what it pushes at a call and the depth of the callee; the
+ * runtime functions take none. It's unbounded for a function that can reach
+ * a recursive one.
+ */
+class SizeReport {
+  public:
+    struct Function {
+        std::string m_name;
+        size_t m_num_of_instructions = 0;
+        size_t m_bytes = 0;
+        size_t m_frame_size = 0;
+        // stores to the expression stack, the arguments passed on it included
+        size_t m_num_of_spills = 0;
+        size_t m_max_outgoing_arguments = 0;
+        size_t m_max_pushed = 0;
+        // callee -> the most bytes pushed when it's called
+        std::map<std::string, size_t> m_calls;
+    };
+
+  private:
+    // in the order they're generated
+    std::vector<Function> m_functions;
+
+  public:
+    ~SizeReport() = default;
+    SizeReport() = default;
+
+    Function &addFunction(const MachineFunction &p_function,
+                          const size_t p_frame_size,
+                          const size_t p_max_outgoing_arguments);
+
+    void print(FILE *p_out_file) const;
+
+  private:
+    // false if unbounded; the depths found are cached in p_depths
+    bool getStackDepth(const std::string &p_name,
+                       std::map<std::string, size_t> &p_depths,
+                       std::set<std::string> &p_visiting) const;
+};
+
+#endif
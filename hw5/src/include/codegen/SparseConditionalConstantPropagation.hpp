@@ -0,0 +1,97 @@
+#ifndef CODEGEN_SPARSE_CONDITIONAL_CONSTANT_PROPAGATION_H
+#define CODEGEN_SPARSE_CONDITIONAL_CONSTANT_PROPAGATION_H
+
+#include "analysis/SideEffectAnalysis.hpp"
+#include "codegen/MachineFunction.hpp"
+
+#include <map>
+#include <string>
+#include <utility>
+
+/*
+ * Conditional constant propagation over the CFG of a function:
+ *   - tracks the constants held by the registers, the frame slots (including
+ *     the expression stack) and the globals, along the executable edges only
+ *   - replaces the instructions producing a constant with li
+ *   - folds the branches whose outcome is known and deletes the blocks that
+ *     are never reached
+ *   - removes the register definitions that become dead
+ *
+ * A block only contributes to its successors once it's proven reachable, so
+ * a value carried around a loop stays constant unless some executable path
+ * changes it.
+ */
+class SparseConditionalConstantPropagation {
+  private:
+    // a constant or the address of a symbol plus a constant
+    struct Value {
+        std::string m_symbol;
+        int32_t m_constant = 0;
+
+        bool isConstant() const { return m_symbol.empty(); }
+        bool operator==(const Value &p_other) const {
+            return m_symbol == p_other.m_symbol &&
+                   m_constant == p_other.m_constant;
+        }
+        bool operator!=(const Value &p_other) const {
+            return !(*this == p_other);
+        }
+    };
+
+    // (base, offset): base is "s0" for the frame or the name of a global
+    using MemoryLocation = std::pair<std::string, int32_t>;
+
+    struct LatticeState {
+        // a register/location absent from the maps isn't a known constant
+        std::map<std::string, Value> m_registers;
+        std::map<MemoryLocation, Value> m_memory;
+        // sp == s0 + m_sp_offset
+        bool m_sp_known = false;
+        int32_t m_sp_offset = 0;
+
+        bool operator==(const LatticeState &p_other) const {
+            return m_registers == p_other.m_registers &&
+                   m_memory == p_other.m_memory &&
+                   m_sp_known == p_other.m_sp_known &&
+                   m_sp_offset == p_other.m_sp_offset;
+        }
+        bool operator!=(const LatticeState &p_other) const {
+            return !(*this == p_other);
+        }
+
+        void meet(const LatticeState &p_other);
+        bool getValue(const std::string &p_reg, Value &p_value) const;
+        void setValue(const std::string &p_reg, const Value *p_value);
+    };
+
+    enum class BranchOutcome : uint8_t { kUnknown, kTaken, kNotTaken };
+
+    // the globals survive a call to a function that doesn't write them
+    const SideEffectAnalysis *m_side_effects;
+    bool m_frame_escaped = false;
+
+  public:
+    ~SparseConditionalConstantPropagation() = default;
+    SparseConditionalConstantPropagation(
+        const SideEffectAnalysis *p_side_effects = nullptr)
+        : m_side_effects(p_side_effects) {}
+
+    // return true if the function is changed
+    bool run(MachineFunction &p_function);
+
+  private:
+    bool resolveAddress(const std::string &p_operand,
+                        const LatticeState &p_state,
+                        MemoryLocation &p_location) const;
+    void transfer(const MachineInstruction &p_inst,
+                  LatticeState &p_state) const;
+    static bool evaluate(const MachineInstruction &p_inst,
+                         const LatticeState &p_state, Value &p_value);
+    static BranchOutcome evaluateBranch(const MachineInstruction &p_inst,
+                                        const LatticeState &p_state);
+
+    static bool removeRedundantJumps(MachineFunction &p_function);
+    static bool removeDeadDefinitions(MachineFunction &p_function);
+};
+
+#endif
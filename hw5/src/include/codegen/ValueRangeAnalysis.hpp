@@ -0,0 +1,146 @@
+#ifndef CODEGEN_VALUE_RANGE_ANALYSIS_H
+#define CODEGEN_VALUE_RANGE_ANALYSIS_H
+
+#include "codegen/MachineFunction.hpp"
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Interval analysis over the CFG of a function:
+ *   - tracks the signed range of the registers and the frame slots
+ *     (including the expression stack), narrowed by the condition of a
+ *     branch on each of its edges
+ *   - folds the branches whose outcome follows from the ranges
+ *   - replaces the divisions of non-negative values with shifts, masks or
+ *     their unsigned forms
+ *
+ * The ranges flowing around a loop are widened after a few rounds so that
+ * the analysis terminates, stepping through the constants of the function
+ * before giving up a bound; the exit condition still bounds the loop
+ * variable inside the loop.
+ */
+class ValueRangeAnalysis {
+  public:
+    // [m_min, m_max] of a signed 32-bit value
+    struct ValueRange {
+        int64_t m_min = INT32_MIN;
+        int64_t m_max = INT32_MAX;
+
+        static ValueRange of(const int64_t p_min, const int64_t p_max);
+
+        bool isFull() const { return m_min == INT32_MIN && m_max == INT32_MAX; }
+        bool isEmpty() const { return m_min > m_max; }
+        bool isConstant() const { return m_min == m_max; }
+        bool isNonNegative() const { return m_min >= 0; }
+        bool contains(const int64_t p_value) const {
+            return m_min <= p_value && p_value <= m_max;
+        }
+
+        ValueRange hull(const ValueRange &p_other) const;
+        ValueRange intersect(const ValueRange &p_other) const;
+
+        bool operator==(const ValueRange &p_other) const {
+            return m_min == p_other.m_min && m_max == p_other.m_max;
+        }
+        bool operator!=(const ValueRange &p_other) const {
+            return !(*this == p_other);
+        }
+    };
+
+  private:
+    struct LatticeState {
+        // a register/slot absent from the maps may hold any value
+        std::map<std::string, ValueRange> m_registers;
+        // frame slots by their offset from s0
+        std::map<int32_t, ValueRange> m_slots;
+        // registers known to hold the current value of a slot, so that a
+        // condition on the register narrows the slot as well
+        std::map<std::string, int32_t> m_copies;
+        // registers holding a copy of another register not copying a slot,
+        // e.g. the forwarded value of a variable moved out of a0
+        std::map<std::string, std::string> m_register_copies;
+        // slots holding a copy of another slot, e.g. a variable pushed onto
+        // the expression stack
+        std::map<int32_t, int32_t> m_aliases;
+        // sp == s0 + m_sp_offset
+        bool m_sp_known = false;
+        int32_t m_sp_offset = 0;
+
+        bool operator==(const LatticeState &p_other) const {
+            return m_registers == p_other.m_registers &&
+                   m_slots == p_other.m_slots &&
+                   m_copies == p_other.m_copies &&
+                   m_register_copies == p_other.m_register_copies &&
+                   m_aliases == p_other.m_aliases &&
+                   m_sp_known == p_other.m_sp_known &&
+                   m_sp_offset == p_other.m_sp_offset;
+        }
+        bool operator!=(const LatticeState &p_other) const {
+            return !(*this == p_other);
+        }
+
+        void join(const LatticeState &p_other);
+        // the bounds still growing since p_previous go to the nearest
+        // threshold beyond them, or to the extremes
+        void widen(const LatticeState &p_previous,
+                   const std::set<int64_t> &p_thresholds);
+
+        ValueRange getRange(const std::string &p_reg) const;
+        void setRange(const std::string &p_reg, const ValueRange &p_range);
+        // mv p_reg, p_src
+        void copyRegister(const std::string &p_reg, const std::string &p_src);
+        // p_reg and the registers holding the same value
+        std::set<std::string> getSameRegisters(const std::string &p_reg) const;
+        // false if the register can't be in the range; the registers and
+        // the slots holding the same value are narrowed as well
+        bool narrow(const std::string &p_reg, const ValueRange &p_range);
+        void narrowSlot(const int32_t p_slot, const ValueRange &p_range);
+        // the slot that p_slot is a copy of, or p_slot itself
+        int32_t getOrigin(const int32_t p_slot) const;
+        void storeSlot(const int32_t p_slot, const std::string &p_reg);
+        void killSlot(const int32_t p_slot);
+        void killSlots(const int32_t p_below);
+    };
+
+    bool m_frame_escaped = false;
+
+    // states at the beginning of the blocks of the last analysis; the
+    // blocks never reached have no state
+    MachineFunction::BasicBlocks m_blocks;
+    std::vector<LatticeState> m_in_states;
+    std::vector<bool> m_reached;
+
+  public:
+    ~ValueRangeAnalysis() = default;
+    ValueRangeAnalysis() = default;
+
+    // return true if the function is changed
+    bool run(MachineFunction &p_function);
+
+    // print the function with the range of each register it defines
+    void dump(const MachineFunction &p_function, FILE *p_out_file);
+
+  private:
+    void analyze(const MachineFunction &p_function);
+
+    bool resolveSlot(const std::string &p_operand, const LatticeState &p_state,
+                     int32_t &p_slot) const;
+    void transfer(const MachineInstruction &p_inst,
+                  LatticeState &p_state) const;
+    static ValueRange evaluate(const MachineInstruction &p_inst,
+                               const LatticeState &p_state);
+    // narrow p_state to the edge of the branch; false if it's never taken
+    static bool narrowBranch(const MachineInstruction &p_inst,
+                             const bool p_taken, LatticeState &p_state);
+
+    static bool rewriteDivision(MachineInstruction &p_inst,
+                                const LatticeState &p_state);
+};
+
+#endif
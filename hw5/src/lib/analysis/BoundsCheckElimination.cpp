@@ -0,0 +1,402 @@
+#include "analysis/BoundsCheckElimination.hpp"
+#include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+const std::vector<BoundsCheckElimination::HoistedCheck> &
+BoundsCheckElimination::getHoistedChecks(const AstNode &p_loop) const {
+    static const std::vector<HoistedCheck> kNoChecks;
+    auto search = m_loops.find(&p_loop);
+    return (search == m_loops.end()) ? kNoChecks
+                                     : search->second.m_hoisted_checks;
+}
+
+bool BoundsCheckElimination::getRange(const ExpressionNode &p_expr,
+                                      int64_t &p_min, int64_t &p_max) const {
+    int32_t value = 0;
+    if (getIntegerConstant(p_expr, m_symbol_manager_ptr, value)) {
+        p_min = p_max = value;
+        return true;
+    }
+
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        if (!variable_ref->getIndices().empty()) {
+            return false;
+        }
+        auto search = m_loop_ranges.find(
+            m_symbol_manager_ptr->lookup(variable_ref->getName()));
+        if (search == m_loop_ranges.end()) {
+            return false;
+        }
+        p_min = search->second.first;
+        p_max = search->second.second - 1;
+        return true;
+    }
+
+    int64_t lhs_min = 0, lhs_max = 0, rhs_min = 0, rhs_max = 0;
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        if (un_op->getOp() != Operator::kNegOp ||
+            !getRange(un_op->getOperand(), lhs_min, lhs_max)) {
+            return false;
+        }
+        p_min = -lhs_max;
+        p_max = -lhs_min;
+    } else if (const auto *bin_op =
+                   dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        if (!getRange(bin_op->getLeftOperand(), lhs_min, lhs_max) ||
+            !getRange(bin_op->getRightOperand(), rhs_min, rhs_max)) {
+            return false;
+        }
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+            p_min = lhs_min + rhs_min;
+            p_max = lhs_max + rhs_max;
+            break;
+        case Operator::kMinusOp:
+            p_min = lhs_min - rhs_max;
+            p_max = lhs_max - rhs_min;
+            break;
+        case Operator::kMultiplyOp: {
+            const auto products = {lhs_min * rhs_min, lhs_min * rhs_max,
+                                   lhs_max * rhs_min, lhs_max * rhs_max};
+            p_min = std::min(products);
+            p_max = std::max(products);
+            break;
+        }
+        case Operator::kDivideOp:
+            // by a positive constant, which truncates monotonically
+            if (rhs_min != rhs_max || rhs_min <= 0) {
+                return false;
+            }
+            p_min = lhs_min / rhs_min;
+            p_max = lhs_max / rhs_min;
+            break;
+        case Operator::kModOp:
+            if (rhs_min != rhs_max || rhs_min <= 0 || lhs_min < 0) {
+                return false;
+            }
+            p_min = 0;
+            p_max = std::min(lhs_max, rhs_min - 1);
+            break;
+        default:
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    // out of 32 bits, the operations wrap around
+    return p_min >= INT32_MIN && p_max <= INT32_MAX;
+}
+
+bool BoundsCheckElimination::getInvariantKey(
+    const ExpressionNode &p_expr, std::string &p_key,
+    std::set<const SymbolEntry *> &p_referenced) const {
+    int32_t value = 0;
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        if (!variable_ref->getIndices().empty()) {
+            return false;
+        }
+        // a constant too, which is out of scope before the loop declaring it
+        p_referenced.insert(
+            m_symbol_manager_ptr->lookup(variable_ref->getName()));
+        p_key = getIntegerConstant(p_expr, m_symbol_manager_ptr, value)
+                    ? std::to_string(value)
+                    : variable_ref->getName();
+        return true;
+    }
+
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        std::string operand;
+        if (un_op->getOp() != Operator::kNegOp ||
+            !getInvariantKey(un_op->getOperand(), operand, p_referenced)) {
+            return false;
+        }
+        p_key = "(-" + operand + ")";
+        return true;
+    }
+
+    if (getIntegerConstant(p_expr, m_symbol_manager_ptr, value)) {
+        p_key = std::to_string(value);
+        return true;
+    }
+
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+        case Operator::kMinusOp:
+        case Operator::kMultiplyOp:
+        case Operator::kDivideOp:
+        case Operator::kModOp:
+            break;
+        default:
+            return false;
+        }
+        std::string lhs, rhs;
+        if (!getInvariantKey(bin_op->getLeftOperand(), lhs, p_referenced) ||
+            !getInvariantKey(bin_op->getRightOperand(), rhs, p_referenced)) {
+            return false;
+        }
+        p_key = "(" + lhs + " " + bin_op->getOpCString() + " " + rhs + ")";
+        return true;
+    }
+    return false;
+}
+
+void BoundsCheckElimination::markVariant(const SymbolEntry *p_entry) {
+    for (const auto *loop : m_loop_stack) {
+        m_loops[loop].m_variant.insert(p_entry);
+    }
+}
+
+void BoundsCheckElimination::markEffect() {
+    for (const auto *loop : m_loop_stack) {
+        m_loops[loop].m_has_effects = true;
+    }
+}
+
+bool BoundsCheckElimination::isInvariant(const Candidate &p_candidate,
+                                         const Loop &p_loop) const {
+    for (const auto *entry : p_candidate.m_referenced) {
+        if (p_loop.m_variant.count(entry)) {
+            return false;
+        }
+        if (p_loop.m_writes_globals && entry->getLevel() == 0 &&
+            entry->getKind() == SymbolEntry::KindEnum::kVariableKind) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BoundsCheckElimination::selectHoistedChecks() {
+    for (const auto &candidate : m_candidates) {
+        const AstNode *hoisted_before = nullptr;
+        for (const auto *loop_node : candidate.m_loops) {
+            auto &loop = m_loops[loop_node];
+            if (loop.m_keeps_checks || !isInvariant(candidate, loop)) {
+                continue;
+            }
+
+            m_unchecked.insert(
+                {candidate.m_variable_ref, candidate.m_index});
+            ++m_num_of_hoisted;
+            // the same index of the same dimension is checked once
+            if (loop.m_hoisted_keys
+                    .insert({candidate.m_key, candidate.m_check.m_dimension})
+                    .second) {
+                loop.m_hoisted_checks.push_back(candidate.m_check);
+            }
+            hoisted_before = loop_node;
+            break;
+        }
+
+        // the loops the check is still done in
+        for (const auto *loop_node : candidate.m_enclosing_loops) {
+            if (loop_node == hoisted_before) {
+                break;
+            }
+            m_loops[loop_node].m_keeps_checks = true;
+        }
+    }
+}
+
+void BoundsCheckElimination::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    selectHoistedChecks();
+}
+
+void BoundsCheckElimination::visit(DeclNode &p_decl) {
+    p_decl.visitChildNodes(*this);
+}
+
+void BoundsCheckElimination::visit(VariableNode &p_variable) {
+    markVariant(m_symbol_manager_ptr->lookup(p_variable.getName()));
+}
+
+void BoundsCheckElimination::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void BoundsCheckElimination::visit(
+    CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void BoundsCheckElimination::visit(PrintNode &p_print) {
+    p_print.visitChildNodes(*this);
+    markEffect();
+}
+
+void BoundsCheckElimination::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void BoundsCheckElimination::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void BoundsCheckElimination::visit(FunctionInvocationNode &p_func_invocation) {
+    p_func_invocation.visitChildNodes(*this);
+
+    const auto *summary = m_side_effects.getSummary(p_func_invocation.getName());
+    if (!summary || !summary->preservesGlobals()) {
+        for (const auto *loop : m_loop_stack) {
+            m_loops[loop].m_writes_globals = true;
+        }
+    }
+    if (!summary || !summary->isRemovable()) {
+        markEffect();
+    }
+}
+
+void BoundsCheckElimination::visit(VariableReferenceNode &p_variable_ref) {
+    p_variable_ref.visitChildNodes(*this);
+
+    const auto &indices = p_variable_ref.getIndices();
+    if (indices.empty()) {
+        return;
+    }
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    assert(entry_ptr && "Should have been defined before use");
+    const auto &dimensions = entry_ptr->getTypePtr()->getDimensions();
+    assert(indices.size() <= dimensions.size() &&
+           "Should have been checked by the semantic analyzer");
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+        ++m_num_of_checks;
+
+        int64_t min = 0, max = 0;
+        if (getRange(*indices[i], min, max) && min >= 0 &&
+            static_cast<uint64_t>(max) < dimensions[i]) {
+            m_unchecked.insert({&p_variable_ref, i});
+            ++m_num_of_removed;
+            continue;
+        }
+
+        Candidate candidate{
+            HoistedCheck{indices[i].get(), dimensions[i],
+                         p_variable_ref.getLocation()},
+            &p_variable_ref,
+            i,
+            "",
+            {},
+            m_loop_stack,
+            {}};
+        if (getInvariantKey(*indices[i], candidate.m_key,
+                            candidate.m_referenced)) {
+            for (const auto *loop_node : m_loop_stack) {
+                const auto &loop = m_loops[loop_node];
+                if (!loop.m_returns && !loop.m_has_effects &&
+                    loop.m_body_depth == m_depth) {
+                    candidate.m_loops.push_back(loop_node);
+                }
+            }
+        }
+        if (!candidate.m_enclosing_loops.empty()) {
+            m_candidates.push_back(std::move(candidate));
+        }
+    }
+}
+
+void BoundsCheckElimination::visit(AssignmentNode &p_assignment) {
+    // in the order they're evaluated
+    const_cast<ExpressionNode &>(p_assignment.getExpr()).accept(*this);
+    const_cast<VariableReferenceNode &>(p_assignment.getLvalue())
+        .accept(*this);
+    markVariant(
+        m_symbol_manager_ptr->lookup(p_assignment.getLvalue().getName()));
+}
+
+void BoundsCheckElimination::visit(ReadNode &p_read) {
+    // the target is checked after the input is read
+    markEffect();
+    p_read.visitChildNodes(*this);
+    markVariant(m_symbol_manager_ptr->lookup(p_read.getTarget().getName()));
+}
+
+void BoundsCheckElimination::visit(IfNode &p_if) {
+    const_cast<ExpressionNode &>(p_if.getCondition()).accept(*this);
+
+    ++m_depth;
+    const_cast<CompoundStatementNode &>(p_if.getIfBody()).accept(*this);
+    if (p_if.getElseBodyPtr()) {
+        const_cast<CompoundStatementNode *>(p_if.getElseBodyPtr())
+            ->accept(*this);
+    }
+    --m_depth;
+}
+
+void BoundsCheckElimination::visit(WhileNode &p_while) {
+    // the entry test is done before the checks of the loop
+    const_cast<ExpressionNode &>(p_while.getCondition()).accept(*this);
+
+    // the body may not run at all
+    ++m_depth;
+    m_loop_stack.push_back(&p_while);
+    m_loops[&p_while].m_body_depth = m_depth;
+    const_cast<CompoundStatementNode &>(p_while.getBody()).accept(*this);
+    m_loop_stack.pop_back();
+    --m_depth;
+
+    // it may not end
+    markEffect();
+}
+
+void BoundsCheckElimination::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_for.getLoopVarName());
+    m_loop_ranges[entry_ptr] = {
+        p_for.getLowerBound().getConstantPtr()->integer(),
+        p_for.getUpperBound().getConstantPtr()->integer()};
+
+    // the body runs at least once
+    m_loop_stack.push_back(&p_for);
+    m_loops[&p_for].m_body_depth = m_depth;
+    p_for.visitChildNodes(*this);
+    m_loop_stack.pop_back();
+
+    m_loop_ranges.erase(entry_ptr);
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void BoundsCheckElimination::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+
+    // the accesses after it may not be done in the first iteration
+    for (const auto *loop : m_loop_stack) {
+        m_loops[loop].m_returns = true;
+    }
+}
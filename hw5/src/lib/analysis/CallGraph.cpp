@@ -0,0 +1,159 @@
+#include "analysis/CallGraph.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+CallGraph::Functions
+CallGraph::getCallees(const FunctionNode *p_function) const {
+    Functions callees;
+    auto search = m_callee_names.find(p_function);
+    if (search == m_callee_names.end()) {
+        return callees;
+    }
+
+    for (const auto *function : m_functions) {
+        if (search->second.count(function->getName())) {
+            callees.push_back(function);
+        }
+    }
+    return callees;
+}
+
+const std::set<const SymbolEntry *> &
+CallGraph::getReferencedGlobals(const FunctionNode *p_function) const {
+    static const std::set<const SymbolEntry *> kNoGlobals;
+    auto search = m_referenced_globals.find(p_function);
+    return (search == m_referenced_globals.end()) ? kNoGlobals
+                                                  : search->second;
+}
+
+void CallGraph::computeReachability() {
+    // start from the body of the program
+    std::vector<const FunctionNode *> worklist{nullptr};
+    while (!worklist.empty()) {
+        const auto *function = worklist.back();
+        worklist.pop_back();
+
+        const auto &globals = getReferencedGlobals(function);
+        m_reachable_globals.insert(globals.begin(), globals.end());
+
+        for (const auto *callee : getCallees(function)) {
+            if (m_reachable_functions.insert(callee).second) {
+                worklist.push_back(callee);
+            }
+        }
+    }
+}
+
+void CallGraph::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    for (const auto &func_node : p_program.getFuncNodes()) {
+        m_functions.push_back(func_node.get());
+        m_name_to_function.emplace(func_node->getName(), func_node.get());
+    }
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+
+    m_current_function = nullptr;
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    computeReachability();
+}
+
+void CallGraph::visit(DeclNode &p_decl) {
+    // declarations don't reference any other symbol
+}
+
+void CallGraph::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    m_current_function = &p_function;
+    // make sure that a leaf function has an entry
+    m_callee_names[&p_function];
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void CallGraph::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_compound_statement.getDeclNodes().begin(),
+             p_compound_statement.getDeclNodes().end(), visit_ast_node);
+    for (const auto &stmt_node : p_compound_statement.getStmtNodes()) {
+        if (!m_partial_evaluation.isEvaluated(*stmt_node)) {
+            stmt_node->accept(*this);
+        }
+    }
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void CallGraph::visit(PrintNode &p_print) { p_print.visitChildNodes(*this); }
+
+void CallGraph::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void CallGraph::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void CallGraph::visit(FunctionInvocationNode &p_func_invocation) {
+    // only the defined functions are in the graph
+    if (m_name_to_function.count(p_func_invocation.getName())) {
+        m_callee_names[m_current_function].insert(
+            p_func_invocation.getName());
+    }
+
+    p_func_invocation.visitChildNodes(*this);
+}
+
+void CallGraph::visit(VariableReferenceNode &p_variable_ref) {
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    assert(entry_ptr && "Should have been defined before use");
+
+    if (entry_ptr->getLevel() == 0 &&
+        entry_ptr->getKind() == SymbolEntry::KindEnum::kVariableKind) {
+        m_referenced_globals[m_current_function].insert(entry_ptr);
+    }
+
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void CallGraph::visit(AssignmentNode &p_assignment) {
+    p_assignment.visitChildNodes(*this);
+}
+
+void CallGraph::visit(ReadNode &p_read) { p_read.visitChildNodes(*this); }
+
+void CallGraph::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void CallGraph::visit(WhileNode &p_while) { p_while.visitChildNodes(*this); }
+
+void CallGraph::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    p_for.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void CallGraph::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
@@ -0,0 +1,189 @@
+#include "analysis/FunctionOrdering.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <list>
+
+// 10^kMaxLoopDepth at most, so that the weights don't overflow
+constexpr size_t kMaxLoopDepth = 4;
+
+bool FunctionOrdering::isCold(const FunctionNode *p_function) const {
+    return p_function && m_profile.isCold(p_function->getLocation());
+}
+
+void FunctionOrdering::computeOrder() {
+    std::vector<std::pair<Edge, uint64_t>> edges(m_weights.begin(),
+                                                 m_weights.end());
+    // the heaviest first, then in declaration order, so that the result
+    // doesn't depend on the addresses of the nodes
+    auto get_order = [&](const Edge &p_edge) {
+        return std::make_pair(m_declaration_order[p_edge.first],
+                              m_declaration_order[p_edge.second]);
+    };
+    std::sort(edges.begin(), edges.end(),
+              [&](const auto &p_lhs, const auto &p_rhs) {
+                  if (p_lhs.second != p_rhs.second) {
+                      return p_lhs.second > p_rhs.second;
+                  }
+                  return get_order(p_lhs.first) < get_order(p_rhs.first);
+              });
+
+    using Chain = std::list<const FunctionNode *>;
+    std::list<Chain> chains;
+    std::map<const FunctionNode *, std::list<Chain>::iterator> chain_of;
+    for (const auto *function : m_functions) {
+        if (isCold(function)) {
+            continue;
+        }
+        chains.emplace_back(Chain{function});
+        chain_of[function] = std::prev(chains.end());
+    }
+    // the heaviest edge of each chain, by which the chains are laid out
+    std::map<const Chain *, uint64_t> chain_weights;
+
+    for (const auto &edge : edges) {
+        auto lhs_search = chain_of.find(edge.first.first);
+        auto rhs_search = chain_of.find(edge.first.second);
+        if (lhs_search == chain_of.end() || rhs_search == chain_of.end() ||
+            lhs_search->second == rhs_search->second) {
+            continue;
+        }
+        auto lhs = lhs_search->second;
+        auto rhs = rhs_search->second;
+
+        // ... lhs_function][rhs_function ...
+        if (lhs->front() == edge.first.first && lhs->size() > 1) {
+            lhs->reverse();
+        }
+        if (rhs->back() == edge.first.second && rhs->size() > 1) {
+            rhs->reverse();
+        }
+        for (const auto *function : *rhs) {
+            chain_of[function] = lhs;
+        }
+        chain_weights[&*lhs] = std::max(
+            {chain_weights[&*lhs], chain_weights[&*rhs], edge.second});
+        chain_weights.erase(&*rhs);
+        lhs->splice(lhs->end(), *rhs);
+        chains.erase(rhs);
+    }
+
+    std::vector<const Chain *> sorted;
+    for (const auto &chain : chains) {
+        sorted.push_back(&chain);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&](const Chain *p_lhs, const Chain *p_rhs) {
+                         return chain_weights[p_lhs] > chain_weights[p_rhs];
+                     });
+    for (const auto *chain : sorted) {
+        m_order.insert(m_order.end(), chain->begin(), chain->end());
+    }
+    for (const auto *function : m_functions) {
+        if (isCold(function)) {
+            m_order.push_back(function);
+        }
+    }
+}
+
+void FunctionOrdering::visit(ProgramNode &p_program) {
+    for (const auto &func_node : p_program.getFuncNodes()) {
+        m_declaration_order.emplace(func_node.get(), m_functions.size());
+        m_functions.push_back(func_node.get());
+        m_name_to_function.emplace(func_node->getName(), func_node.get());
+    }
+    m_declaration_order.emplace(nullptr, m_functions.size());
+    m_functions.push_back(nullptr);
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    m_current_function = nullptr;
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    computeOrder();
+}
+
+void FunctionOrdering::visit(FunctionNode &p_function) {
+    m_current_function = &p_function;
+    m_loop_depth = 0;
+    m_current_weight = 1;
+    p_function.visitBodyChildNodes(*this);
+}
+
+void FunctionOrdering::visit(CompoundStatementNode &p_compound_statement) {
+    const auto saved_weight = m_current_weight;
+    uint64_t count = 0;
+    if (m_profile.getCount(p_compound_statement.getLocation(), count)) {
+        m_current_weight = count;
+    } else {
+        m_current_weight = 1;
+        for (size_t i = 0; i < std::min(m_loop_depth, kMaxLoopDepth); ++i) {
+            m_current_weight *= 10;
+        }
+    }
+    p_compound_statement.visitChildNodes(*this);
+    m_current_weight = saved_weight;
+}
+
+void FunctionOrdering::visitLoopBody(const CompoundStatementNode &p_body) {
+    ++m_loop_depth;
+    const_cast<CompoundStatementNode &>(p_body).accept(*this);
+    --m_loop_depth;
+}
+
+void FunctionOrdering::visit(PrintNode &p_print) {
+    p_print.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(FunctionInvocationNode &p_func_invocation) {
+    p_func_invocation.visitChildNodes(*this);
+
+    auto search = m_name_to_function.find(p_func_invocation.getName());
+    if (search == m_name_to_function.end() || !search->second->hasBody() ||
+        search->second == m_current_function) {
+        return;
+    }
+    // keyed in declaration order, as the calls in either way add up
+    const auto *caller = m_current_function;
+    const auto *callee = search->second;
+    if (m_declaration_order[callee] < m_declaration_order[caller]) {
+        std::swap(caller, callee);
+    }
+    m_weights[Edge(caller, callee)] += m_current_weight;
+}
+
+void FunctionOrdering::visit(VariableReferenceNode &p_variable_ref) {
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(AssignmentNode &p_assignment) {
+    p_assignment.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(ReadNode &p_read) {
+    p_read.visitChildNodes(*this);
+}
+
+void FunctionOrdering::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void FunctionOrdering::visit(WhileNode &p_while) {
+    const_cast<ExpressionNode &>(p_while.getCondition()).accept(*this);
+    visitLoopBody(p_while.getBody());
+}
+
+void FunctionOrdering::visit(ForNode &p_for) {
+    visitLoopBody(p_for.getBody());
+}
+
+void FunctionOrdering::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
@@ -0,0 +1,246 @@
+#include "analysis/FunctionSpecialization.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+bool FunctionSpecialization::Specialization::getConstantArgument(
+    size_t p_index, int32_t &p_value) const {
+    for (const auto &argument : m_arguments) {
+        if (argument.first == p_index) {
+            p_value = argument.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<const FunctionSpecialization::Specialization *>
+FunctionSpecialization::getSpecializations(
+    const FunctionNode &p_function) const {
+    std::vector<const Specialization *> specializations;
+    for (const auto &specialization : m_specializations) {
+        if (specialization->m_function == &p_function) {
+            specializations.push_back(specialization.get());
+        }
+    }
+    return specializations;
+}
+
+const FunctionSpecialization::Specialization *
+FunctionSpecialization::getSpecialization(
+    const FunctionInvocationNode &p_func_invocation) const {
+    auto search = m_specialized_calls.find(&p_func_invocation);
+    return (search == m_specialized_calls.end()) ? nullptr : search->second;
+}
+
+void FunctionSpecialization::selectSpecializations() {
+    std::map<const FunctionNode *, size_t> declaration_order;
+    for (const auto *function : m_functions) {
+        declaration_order.emplace(function, declaration_order.size());
+    }
+
+    // the clones serving the most call sites first, then the smallest ones,
+    // so that the result doesn't depend on the addresses of the nodes
+    std::vector<const decltype(m_call_sites)::value_type *> candidates;
+    for (const auto &call_sites : m_call_sites) {
+        candidates.push_back(&call_sites);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [&](const auto *p_lhs, const auto *p_rhs) {
+                  const auto *lhs_function = p_lhs->first.first;
+                  const auto *rhs_function = p_rhs->first.first;
+                  if (p_lhs->second.size() != p_rhs->second.size()) {
+                      return p_lhs->second.size() > p_rhs->second.size();
+                  }
+                  if (m_sizes[lhs_function] != m_sizes[rhs_function]) {
+                      return m_sizes[lhs_function] < m_sizes[rhs_function];
+                  }
+                  if (lhs_function != rhs_function) {
+                      return declaration_order[lhs_function] <
+                             declaration_order[rhs_function];
+                  }
+                  return p_lhs->first.second < p_rhs->first.second;
+              });
+
+    size_t growth = 0;
+    std::map<const FunctionNode *, size_t> num_of_clones;
+    std::map<const FunctionNode *, size_t> num_of_specialized_calls;
+    for (const auto *candidate : candidates) {
+        const auto *function = candidate->first.first;
+        if (growth + m_sizes[function] > m_budget) {
+            continue;
+        }
+        growth += m_sizes[function];
+
+        m_specializations.emplace_back(new Specialization{
+            function, candidate->first.second,
+            function->getName() + ".spec" +
+                std::to_string(num_of_clones[function]++)});
+        for (const auto *call_site : candidate->second) {
+            m_specialized_calls[call_site] = m_specializations.back().get();
+        }
+        num_of_specialized_calls[function] += candidate->second.size();
+    }
+
+    for (const auto &specialized_calls : num_of_specialized_calls) {
+        if (specialized_calls.second == m_num_of_calls[specialized_calls.first]) {
+            m_fully_specialized.insert(specialized_calls.first);
+        }
+    }
+}
+
+void FunctionSpecialization::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    for (const auto &func_node : p_program.getFuncNodes()) {
+        m_functions.push_back(func_node.get());
+        m_name_to_function.emplace(func_node->getName(), func_node.get());
+    }
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+
+    m_current_size = nullptr;
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    selectSpecializations();
+}
+
+void FunctionSpecialization::visit(DeclNode &p_decl) {
+    p_decl.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(VariableNode &p_variable) { countNode(); }
+
+void FunctionSpecialization::visit(ConstantValueNode &p_constant_value) {
+    countNode();
+}
+
+void FunctionSpecialization::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    m_current_size = &m_sizes[&p_function];
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void FunctionSpecialization::visit(
+    CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    const bool cold = m_profile.isCold(p_compound_statement.getLocation());
+    m_cold_depth += cold;
+    countNode();
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_compound_statement.getDeclNodes().begin(),
+             p_compound_statement.getDeclNodes().end(), visit_ast_node);
+    for (const auto &stmt_node : p_compound_statement.getStmtNodes()) {
+        if (!m_partial_evaluation.isEvaluated(*stmt_node)) {
+            stmt_node->accept(*this);
+        }
+    }
+    m_cold_depth -= cold;
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void FunctionSpecialization::visit(PrintNode &p_print) {
+    countNode();
+    p_print.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(BinaryOperatorNode &p_bin_op) {
+    countNode();
+    p_bin_op.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(UnaryOperatorNode &p_un_op) {
+    countNode();
+    p_un_op.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(FunctionInvocationNode &p_func_invocation) {
+    countNode();
+    p_func_invocation.visitChildNodes(*this);
+
+    // only the defined functions can be cloned
+    auto search = m_name_to_function.find(p_func_invocation.getName());
+    if (search == m_name_to_function.end() || !search->second->hasBody()) {
+        return;
+    }
+    const auto *function = search->second;
+    ++m_num_of_calls[function];
+
+    std::vector<const PType *> parameter_types;
+    for (const auto &parameter : function->getParameters()) {
+        for (const auto &var_node : parameter->getVariables()) {
+            parameter_types.push_back(var_node->getTypePtr());
+        }
+    }
+
+    ConstantArguments constant_arguments;
+    const auto &arguments = p_func_invocation.getArguments();
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        int32_t value = 0;
+        if (parameter_types[i]->isInteger() &&
+            getIntegerConstant(*arguments[i], m_symbol_manager_ptr, value)) {
+            constant_arguments.emplace_back(i, value);
+        }
+    }
+    if (!constant_arguments.empty() && !m_cold_depth) {
+        m_call_sites[CallSiteKey(function, constant_arguments)].push_back(
+            &p_func_invocation);
+    }
+}
+
+void FunctionSpecialization::visit(VariableReferenceNode &p_variable_ref) {
+    countNode();
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(AssignmentNode &p_assignment) {
+    countNode();
+    p_assignment.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(ReadNode &p_read) {
+    countNode();
+    p_read.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(IfNode &p_if) {
+    countNode();
+    p_if.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(WhileNode &p_while) {
+    countNode();
+    p_while.visitChildNodes(*this);
+}
+
+void FunctionSpecialization::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    countNode();
+    p_for.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void FunctionSpecialization::visit(ReturnNode &p_return) {
+    countNode();
+    p_return.visitChildNodes(*this);
+}
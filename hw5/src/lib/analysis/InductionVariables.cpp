@@ -0,0 +1,347 @@
+#include "analysis/InductionVariables.hpp"
+#include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <iterator>
+
+const InductionVariables::Loop &
+InductionVariables::getLoop(const ForNode &p_for) const {
+    auto search = m_loops.find(&p_for);
+    assert(search != m_loops.end() && "Should have been visited");
+    return search->second;
+}
+
+bool InductionVariables::getDerived(const BinaryOperatorNode &p_bin_op,
+                                    const ForNode *&p_loop,
+                                    int32_t &p_stride) const {
+    auto search = m_derived.find(&p_bin_op);
+    if (search == m_derived.end()) {
+        return false;
+    }
+    p_loop = search->second.first;
+    p_stride = search->second.second;
+    return true;
+}
+
+bool InductionVariables::getElementPointer(
+    const VariableReferenceNode &p_variable_ref, const ForNode *&p_loop,
+    size_t &p_index) const {
+    auto search = m_element_pointers.find(&p_variable_ref);
+    if (search == m_element_pointers.end()) {
+        return false;
+    }
+    p_loop = search->second.first;
+    p_index = search->second.second;
+    return true;
+}
+
+const ForNode *InductionVariables::getLoopOfVariable(
+    const VariableReferenceNode &p_variable_ref) const {
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    assert(entry_ptr && "Should have been defined before use");
+
+    for (const auto &loop : m_loop_stack) {
+        if (loop.first == entry_ptr) {
+            return loop.second;
+        }
+    }
+    return nullptr;
+}
+
+bool InductionVariables::getLoopPosition(const SymbolEntry *p_entry,
+                                         size_t &p_position) const {
+    for (size_t i = 0; i < m_loop_stack.size(); ++i) {
+        if (m_loop_stack[i].first == p_entry) {
+            p_position = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InductionVariables::addElementPointer(
+    const VariableReferenceNode &p_variable_ref) {
+    const auto &indices = p_variable_ref.getIndices();
+    if (indices.empty()) {
+        return false;
+    }
+    if (m_bounds_checks) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (m_bounds_checks->isChecked(p_variable_ref, i)) {
+                return false;
+            }
+        }
+    }
+
+    const auto *array_entry =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    // the highest level of the symbols that the address is computed from,
+    // besides the loop variables
+    size_t level = array_entry->getLevel();
+    auto get_constant = [&](const ExpressionNode &p_expr, int32_t &p_value) {
+        if (!getIntegerConstant(p_expr, m_symbol_manager_ptr, p_value)) {
+            return false;
+        }
+        if (const auto *constant_ref =
+                dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+            level = std::max(
+                level, m_symbol_manager_ptr->lookup(constant_ref->getName())
+                           ->getLevel());
+        }
+        return true;
+    };
+    auto get_loop_variable = [&](const ExpressionNode &p_expr,
+                                 const SymbolEntry *&p_entry) {
+        const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr);
+        if (!variable_ref) {
+            return false;
+        }
+        const auto *entry_ptr =
+            m_symbol_manager_ptr->lookup(variable_ref->getName());
+        size_t position = 0;
+        if (!getLoopPosition(entry_ptr, position)) {
+            return false;
+        }
+        p_entry = entry_ptr;
+        return true;
+    };
+    // constant, loop variable, loop variable +/- constant or constant + loop
+    // variable
+    auto get_index = [&](const ExpressionNode &p_index,
+                         const SymbolEntry *&p_variable, int32_t &p_constant) {
+        if (get_constant(p_index, p_constant) ||
+            get_loop_variable(p_index, p_variable)) {
+            return true;
+        }
+        const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&p_index);
+        if (!bin_op) {
+            return false;
+        }
+        const auto op = bin_op->getOp();
+        if (op == Operator::kPlusOp &&
+            get_constant(bin_op->getLeftOperand(), p_constant) &&
+            get_loop_variable(bin_op->getRightOperand(), p_variable)) {
+            return true;
+        }
+        if ((op == Operator::kPlusOp || op == Operator::kMinusOp) &&
+            get_loop_variable(bin_op->getLeftOperand(), p_variable) &&
+            get_constant(bin_op->getRightOperand(), p_constant)) {
+            if (op == Operator::kMinusOp) {
+                p_constant =
+                    static_cast<int32_t>(-static_cast<uint32_t>(p_constant));
+            }
+            return true;
+        }
+        return false;
+    };
+
+    ElementKey key{{array_entry, 0}};
+    // stepped by the innermost loop whose variable it uses
+    bool uses_loop = false;
+    size_t innermost = 0;
+    for (const auto &index : indices) {
+        const SymbolEntry *variable = nullptr;
+        int32_t constant = 0;
+        if (!get_index(*index, variable, constant)) {
+            return false;
+        }
+        size_t position = 0;
+        if (variable && getLoopPosition(variable, position)) {
+            innermost = uses_loop ? std::max(innermost, position) : position;
+            uses_loop = true;
+        }
+        key.emplace_back(variable, constant);
+    }
+    if (!uses_loop) {
+        return false;
+    }
+    const auto *loop_var = m_loop_stack[innermost].first;
+    const auto *loop = m_loop_stack[innermost].second;
+    if (level >= loop_var->getLevel()) {
+        return false;
+    }
+
+    // of the elements or subarrays each index counts
+    const auto &dimensions = array_entry->getTypePtr()->getDimensions();
+    int64_t stride = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (key[i + 1].first != loop_var) {
+            continue;
+        }
+        int64_t size = 4;
+        for (size_t j = i + 1; j < dimensions.size(); ++j) {
+            size *= static_cast<int64_t>(dimensions[j]);
+        }
+        stride += size;
+    }
+    if (stride > INT32_MAX) {
+        return false;
+    }
+
+    // the variables of the enclosing loops are read before the loop
+    for (auto it = std::next(key.begin()); it != key.end(); ++it) {
+        size_t position = 0;
+        if (it->first != loop_var && it->first &&
+            getLoopPosition(it->first, position)) {
+            m_loops[m_loop_stack[position].second].m_counter_used = true;
+        }
+    }
+
+    auto &pointers = m_loops[loop].m_pointers;
+    auto inserted =
+        m_pointer_keys.emplace(std::make_pair(loop, key), pointers.size());
+    if (inserted.second) {
+        pointers.push_back(
+            ElementPointer{&p_variable_ref, static_cast<int32_t>(stride)});
+    }
+    m_element_pointers.emplace(&p_variable_ref,
+                               std::make_pair(loop, inserted.first->second));
+    return true;
+}
+
+void InductionVariables::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+}
+
+void InductionVariables::visit(DeclNode &p_decl) {}
+
+void InductionVariables::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void InductionVariables::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void InductionVariables::visit(PrintNode &p_print) {
+    p_print.visitChildNodes(*this);
+}
+
+// loop variable * constant or constant * loop variable
+void InductionVariables::visit(BinaryOperatorNode &p_bin_op) {
+    if (p_bin_op.getOp() == Operator::kMultiplyOp) {
+        const auto *left_ref = dynamic_cast<const VariableReferenceNode *>(
+            &p_bin_op.getLeftOperand());
+        const auto *right_ref = dynamic_cast<const VariableReferenceNode *>(
+            &p_bin_op.getRightOperand());
+        int32_t stride = 0;
+
+        const ForNode *loop = nullptr;
+        if (left_ref && getIntegerConstant(p_bin_op.getRightOperand(),
+                                           m_symbol_manager_ptr, stride)) {
+            loop = getLoopOfVariable(*left_ref);
+        } else if (right_ref &&
+                   getIntegerConstant(p_bin_op.getLeftOperand(),
+                                      m_symbol_manager_ptr, stride)) {
+            loop = getLoopOfVariable(*right_ref);
+        }
+        if (loop) {
+            m_loops[loop].m_strides.insert(stride);
+            m_derived.emplace(&p_bin_op, std::make_pair(loop, stride));
+            return;
+        }
+    }
+
+    p_bin_op.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(FunctionInvocationNode &p_func_invocation) {
+    p_func_invocation.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(VariableReferenceNode &p_variable_ref) {
+    if (addElementPointer(p_variable_ref)) {
+        return;
+    }
+
+    const auto *loop = getLoopOfVariable(p_variable_ref);
+    if (loop) {
+        m_loops[loop].m_counter_used = true;
+    }
+
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(AssignmentNode &p_assignment) {
+    p_assignment.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(ReadNode &p_read) {
+    p_read.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void InductionVariables::visit(WhileNode &p_while) {
+    p_while.visitChildNodes(*this);
+}
+
+void InductionVariables::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    // the initialization and the test of the loop variable are the loop's own
+    m_loops[&p_for];
+    m_loop_stack.emplace_back(
+        m_symbol_manager_ptr->lookup(p_for.getLoopVarName()), &p_for);
+    if (m_interchange.isInterchanged(p_for)) {
+        // the inner loop goes outside
+        const auto &inner = *LoopInterchange::getInnerLoop(p_for);
+        m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+            p_for.getBody().getSymbolTable());
+        m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+            inner.getSymbolTable());
+
+        m_loops[&inner];
+        m_loop_stack.emplace(
+            std::prev(m_loop_stack.end()),
+            m_symbol_manager_ptr->lookup(inner.getLoopVarName()), &inner);
+        const_cast<CompoundStatementNode &>(inner.getBody()).accept(*this);
+        m_loop_stack.erase(std::prev(m_loop_stack.end(), 2));
+
+        m_symbol_manager_ptr->removeSymbolsFromHashTable(
+            inner.getSymbolTable());
+        m_symbol_manager_ptr->removeSymbolsFromHashTable(
+            p_for.getBody().getSymbolTable());
+    } else {
+        const_cast<CompoundStatementNode &>(p_for.getBody()).accept(*this);
+    }
+    m_loop_stack.pop_back();
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void InductionVariables::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
@@ -0,0 +1,41 @@
+#include "analysis/IntegerConstant.hpp"
+#include "AST/operator.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <cassert>
+
+bool getIntegerConstant(const ExpressionNode &p_expr,
+                        const SymbolManager *p_symbol_manager,
+                        int32_t &p_value) {
+    if (const auto *constant_value =
+            dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+        if (!constant_value->getTypePtr()->isInteger()) {
+            return false;
+        }
+        p_value = constant_value->getConstantPtr()->integer();
+        return true;
+    }
+
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        if (un_op->getOp() != Operator::kNegOp ||
+            !getIntegerConstant(un_op->getOperand(), p_symbol_manager,
+                                p_value)) {
+            return false;
+        }
+        p_value = -p_value;
+        return true;
+    }
+
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        const auto *entry_ptr = p_symbol_manager->lookup(variable_ref->getName());
+        assert(entry_ptr && "Should have been defined before use");
+        if (entry_ptr->getKind() != SymbolEntry::KindEnum::kConstantKind ||
+            !entry_ptr->getTypePtr()->isInteger()) {
+            return false;
+        }
+        p_value = entry_ptr->getAttribute().constant()->integer();
+        return true;
+    }
+    return false;
+}
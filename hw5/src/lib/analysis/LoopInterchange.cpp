@@ -0,0 +1,361 @@
+#include "analysis/LoopInterchange.hpp"
+#include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "analysis/Reduction.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// an index of an array element, the loop variable (nullptr if none) plus a
+// constant
+struct Subscript {
+    const SymbolEntry *m_variable;
+    int64_t m_constant;
+};
+
+struct Access {
+    const SymbolEntry *m_array;
+    bool m_written;
+    // false if an index isn't a Subscript, and then m_subscripts is partial
+    bool m_analyzed;
+    std::vector<Subscript> m_subscripts;
+};
+
+// the distance of a loop variable between two accesses to the same element;
+// any if the accesses don't tell
+struct Distance {
+    bool m_any = true;
+    int64_t m_value = 0;
+
+    bool mayBePositive() const { return m_any || m_value > 0; }
+    bool mayBeNegative() const { return m_any || m_value < 0; }
+};
+
+class AccessCollector {
+  private:
+    const SymbolManager *m_symbol_manager_ptr;
+    const SymbolEntry *m_outer_var;
+    const SymbolEntry *m_inner_var;
+
+  public:
+    std::vector<Access> m_accesses;
+
+    AccessCollector(const SymbolManager *p_symbol_manager,
+                    const SymbolEntry *p_outer_var,
+                    const SymbolEntry *p_inner_var)
+        : m_symbol_manager_ptr(p_symbol_manager), m_outer_var(p_outer_var),
+          m_inner_var(p_inner_var) {}
+
+    // false if p_expr has calls
+    bool collect(const ExpressionNode &p_expr) {
+        if (dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+            return true;
+        }
+        if (const auto *variable_ref =
+                dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+            return collect(*variable_ref, false);
+        }
+        if (const auto *un_op =
+                dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+            return collect(un_op->getOperand());
+        }
+        if (const auto *bin_op =
+                dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+            return collect(bin_op->getLeftOperand()) &&
+                   collect(bin_op->getRightOperand());
+        }
+        // function invocations
+        return false;
+    }
+
+    bool collect(const VariableReferenceNode &p_variable_ref,
+                 const bool p_written) {
+        const auto &indices = p_variable_ref.getIndices();
+        if (indices.empty()) {
+            return true;
+        }
+        Access access{m_symbol_manager_ptr->lookup(p_variable_ref.getName()),
+                      p_written, true, {}};
+        for (const auto &index : indices) {
+            if (!collect(*index)) {
+                return false;
+            }
+            Subscript subscript{nullptr, 0};
+            access.m_analyzed &= getSubscript(*index, subscript);
+            access.m_subscripts.push_back(subscript);
+        }
+        m_accesses.push_back(std::move(access));
+        return true;
+    }
+
+  private:
+    bool getLoopVariable(const ExpressionNode &p_expr,
+                         const SymbolEntry *&p_variable) const {
+        const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr);
+        if (!variable_ref || !variable_ref->getIndices().empty()) {
+            return false;
+        }
+        const auto *entry_ptr =
+            m_symbol_manager_ptr->lookup(variable_ref->getName());
+        if (entry_ptr != m_outer_var && entry_ptr != m_inner_var) {
+            return false;
+        }
+        p_variable = entry_ptr;
+        return true;
+    }
+
+    // constant, loop variable, loop variable +/- constant or constant + loop
+    // variable
+    bool getSubscript(const ExpressionNode &p_index,
+                      Subscript &p_subscript) const {
+        int32_t constant = 0;
+        if (getIntegerConstant(p_index, m_symbol_manager_ptr, constant)) {
+            p_subscript = Subscript{nullptr, constant};
+            return true;
+        }
+        if (getLoopVariable(p_index, p_subscript.m_variable)) {
+            return true;
+        }
+        const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&p_index);
+        if (!bin_op) {
+            return false;
+        }
+        const auto op = bin_op->getOp();
+        if (op == Operator::kPlusOp &&
+            getIntegerConstant(bin_op->getLeftOperand(), m_symbol_manager_ptr,
+                               constant) &&
+            getLoopVariable(bin_op->getRightOperand(),
+                            p_subscript.m_variable)) {
+            p_subscript.m_constant = constant;
+            return true;
+        }
+        if ((op == Operator::kPlusOp || op == Operator::kMinusOp) &&
+            getLoopVariable(bin_op->getLeftOperand(),
+                            p_subscript.m_variable) &&
+            getIntegerConstant(bin_op->getRightOperand(),
+                               m_symbol_manager_ptr, constant)) {
+            p_subscript.m_constant =
+                op == Operator::kMinusOp ? -static_cast<int64_t>(constant)
+                                       : constant;
+            return true;
+        }
+        return false;
+    }
+};
+
+// whether p_first and p_second may access the same element in two
+// iterations ordered one way by the outer loop and the other by the inner
+bool mayReverse(const Access &p_first, const Access &p_second,
+                const SymbolEntry *p_outer_var) {
+    if (!p_first.m_analyzed || !p_second.m_analyzed) {
+        return true;
+    }
+
+    Distance outer;
+    Distance inner;
+    for (size_t i = 0; i < p_first.m_subscripts.size(); ++i) {
+        const auto &first = p_first.m_subscripts[i];
+        const auto &second = p_second.m_subscripts[i];
+        if (!first.m_variable && !second.m_variable) {
+            if (first.m_constant != second.m_constant) {
+                // never the same element
+                return false;
+            }
+            continue;
+        }
+        if (first.m_variable != second.m_variable) {
+            if (first.m_variable && second.m_variable) {
+                // a[i] and a[j] are the same element along a diagonal
+                return true;
+            }
+            // fixes one loop variable, not the distance
+            continue;
+        }
+        // the second access is to the element of the first one if the
+        // variable is first.m_constant - second.m_constant past it
+        auto &distance = first.m_variable == p_outer_var ? outer : inner;
+        const auto value = first.m_constant - second.m_constant;
+        if (!distance.m_any && distance.m_value != value) {
+            return false;
+        }
+        distance = Distance{false, value};
+    }
+    return (outer.mayBePositive() && inner.mayBeNegative()) ||
+           (outer.mayBeNegative() && inner.mayBePositive());
+}
+
+} // namespace
+
+const ForNode *LoopInterchange::getInnerLoop(const ForNode &p_outer) {
+    const auto &body = p_outer.getBody();
+    if (!body.getDeclNodes().empty() || body.getStmtNodes().size() != 1) {
+        return nullptr;
+    }
+    return dynamic_cast<const ForNode *>(body.getStmtNodes().front().get());
+}
+
+bool LoopInterchange::isInterchangeable(const ForNode &p_outer,
+                                        const ForNode &p_inner) const {
+    if (p_outer.getLoopVarName() == p_inner.getLoopVarName()) {
+        return false;
+    }
+
+    const auto trip_count = [](const ForNode &p_for) {
+        return static_cast<int64_t>(
+                   p_for.getUpperBound().getConstantPtr()->integer()) -
+               p_for.getLowerBound().getConstantPtr()->integer();
+    };
+    if (trip_count(p_inner) >= trip_count(p_outer)) {
+        return false;
+    }
+
+    std::vector<Reduction> reductions;
+    return getReductions(p_inner.getBody(), m_symbol_manager_ptr, reductions);
+}
+
+void LoopInterchange::reorderForLocality(const ForNode &p_outer,
+                                         const ForNode &p_inner) {
+    const auto &body = p_inner.getBody();
+    if (!body.getDeclNodes().empty() ||
+        p_outer.getLoopVarName() == p_inner.getLoopVarName()) {
+        return;
+    }
+
+    const auto *outer_var =
+        m_symbol_manager_ptr->lookup(p_outer.getLoopVarName());
+    const auto *inner_var =
+        m_symbol_manager_ptr->lookup(p_inner.getLoopVarName());
+    AccessCollector collector(m_symbol_manager_ptr, outer_var, inner_var);
+    for (const auto &stmt : body.getStmtNodes()) {
+        const auto *assignment =
+            dynamic_cast<const AssignmentNode *>(stmt.get());
+        if (!assignment || assignment->getLvalue().getIndices().empty() ||
+            !collector.collect(assignment->getLvalue(), true) ||
+            !collector.collect(assignment->getExpr())) {
+            return;
+        }
+    }
+    const auto &accesses = collector.m_accesses;
+
+    // an element written in an iteration, and accessed in another one
+    for (const auto &written : accesses) {
+        if (!written.m_written) {
+            continue;
+        }
+        for (const auto &access : accesses) {
+            if (access.m_array != written.m_array) {
+                if (written.m_array->getKind() ==
+                        SymbolEntry::KindEnum::kParameterKind ||
+                    access.m_array->getKind() ==
+                        SymbolEntry::KindEnum::kParameterKind) {
+                    return;
+                }
+                continue;
+            }
+            if (mayReverse(written, access, outer_var)) {
+                return;
+            }
+        }
+    }
+
+    // contiguous and a row apart from the previous iteration of the inner
+    // loop
+    size_t contiguous = 0;
+    size_t strided = 0;
+    for (const auto &access : accesses) {
+        const auto &subscripts = access.m_subscripts;
+        if (subscripts.size() !=
+            access.m_array->getTypePtr()->getDimensions().size()) {
+            continue;
+        }
+        if (subscripts.back().m_variable == inner_var) {
+            ++contiguous;
+        } else if (std::any_of(subscripts.begin(), std::prev(subscripts.end()),
+                               [&](const Subscript &p_subscript) {
+                                   return p_subscript.m_variable == inner_var;
+                               })) {
+            ++strided;
+        }
+    }
+    if (!strided) {
+        return;
+    }
+    if (!contiguous) {
+        m_interchanged.insert(&p_outer);
+        return;
+    }
+
+    const auto trip_count =
+        static_cast<int64_t>(
+            p_inner.getUpperBound().getConstantPtr()->integer()) -
+        p_inner.getLowerBound().getConstantPtr()->integer();
+    if (m_tile_size > 1 && static_cast<int64_t>(m_tile_size) < trip_count &&
+        trip_count % static_cast<int64_t>(m_tile_size) == 0) {
+        m_tiled.insert(&p_outer);
+    }
+}
+
+void LoopInterchange::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+}
+
+void LoopInterchange::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void LoopInterchange::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void LoopInterchange::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void LoopInterchange::visit(WhileNode &p_while) {
+    p_while.visitChildNodes(*this);
+}
+
+void LoopInterchange::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    const auto *inner = getInnerLoop(p_for);
+    if (inner) {
+        m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+            inner->getSymbolTable());
+        if (isInterchangeable(p_for, *inner)) {
+            m_interchanged.insert(&p_for);
+        } else {
+            reorderForLocality(p_for, *inner);
+        }
+        m_symbol_manager_ptr->removeSymbolsFromHashTable(
+            inner->getSymbolTable());
+    }
+    const_cast<CompoundStatementNode &>(p_for.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
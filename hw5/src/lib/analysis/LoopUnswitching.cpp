@@ -0,0 +1,222 @@
+#include "analysis/LoopUnswitching.hpp"
+#include "AST/operator.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+const std::vector<const IfNode *> &
+LoopUnswitching::getUnswitchedIfs(const AstNode &p_loop) const {
+    static const std::vector<const IfNode *> kNoIfs;
+    auto search = m_loops.find(&p_loop);
+    return (search == m_loops.end()) ? kNoIfs : search->second.m_unswitched_ifs;
+}
+
+void LoopUnswitching::countNode() {
+    for (const auto *loop : m_loop_stack) {
+        ++m_loops[loop].m_size;
+    }
+}
+
+void LoopUnswitching::markVariant(const SymbolEntry *p_entry) {
+    for (const auto *loop : m_loop_stack) {
+        m_loops[loop].m_variant.insert(p_entry);
+    }
+}
+
+bool LoopUnswitching::isInvariant(const Candidate &p_candidate,
+                                  const Loop &p_loop) const {
+    for (const auto *entry : p_candidate.m_referenced) {
+        if (p_loop.m_variant.count(entry)) {
+            return false;
+        }
+        if (p_loop.m_writes_globals && entry->getLevel() == 0 &&
+            entry->getKind() == SymbolEntry::KindEnum::kVariableKind) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LoopUnswitching::selectUnswitchedIfs() {
+    for (const auto &candidate : m_candidates) {
+        for (const auto *loop_node : candidate.m_loops) {
+            auto &loop = m_loops[loop_node];
+            if (loop.m_cold || !isInvariant(candidate, loop)) {
+                continue;
+            }
+
+            // the copies of the loop double with each if
+            const size_t num_of_ifs = loop.m_unswitched_ifs.size() + 1;
+            if (num_of_ifs < 16 &&
+                loop.m_size * ((size_t(1) << num_of_ifs) - 1) <= m_budget) {
+                loop.m_unswitched_ifs.push_back(candidate.m_if);
+            }
+            break;
+        }
+    }
+}
+
+void LoopUnswitching::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    selectUnswitchedIfs();
+}
+
+void LoopUnswitching::visit(DeclNode &p_decl) { p_decl.visitChildNodes(*this); }
+
+void LoopUnswitching::visit(VariableNode &p_variable) {
+    countNode();
+    markVariant(m_symbol_manager_ptr->lookup(p_variable.getName()));
+}
+
+void LoopUnswitching::visit(ConstantValueNode &p_constant_value) {
+    countNode();
+}
+
+void LoopUnswitching::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void LoopUnswitching::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    countNode();
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void LoopUnswitching::visit(PrintNode &p_print) {
+    countNode();
+    p_print.visitChildNodes(*this);
+}
+
+void LoopUnswitching::visit(BinaryOperatorNode &p_bin_op) {
+    countNode();
+    p_bin_op.visitChildNodes(*this);
+}
+
+void LoopUnswitching::visit(UnaryOperatorNode &p_un_op) {
+    countNode();
+    p_un_op.visitChildNodes(*this);
+}
+
+void LoopUnswitching::visit(FunctionInvocationNode &p_func_invocation) {
+    countNode();
+    p_func_invocation.visitChildNodes(*this);
+
+    const auto *summary = m_side_effects.getSummary(p_func_invocation.getName());
+    if (!summary || !summary->preservesGlobals()) {
+        for (const auto *loop : m_loop_stack) {
+            m_loops[loop].m_writes_globals = true;
+        }
+    }
+    if (m_in_condition) {
+        m_current_condition = nullptr;
+    }
+}
+
+void LoopUnswitching::visit(VariableReferenceNode &p_variable_ref) {
+    countNode();
+    p_variable_ref.visitChildNodes(*this);
+
+    if (m_in_condition && m_current_condition) {
+        if (!p_variable_ref.getIndices().empty()) {
+            m_current_condition = nullptr;
+            return;
+        }
+        m_current_condition->m_referenced.insert(
+            m_symbol_manager_ptr->lookup(p_variable_ref.getName()));
+    }
+}
+
+void LoopUnswitching::visit(AssignmentNode &p_assignment) {
+    countNode();
+    p_assignment.visitChildNodes(*this);
+    markVariant(
+        m_symbol_manager_ptr->lookup(p_assignment.getLvalue().getName()));
+}
+
+void LoopUnswitching::visit(ReadNode &p_read) {
+    countNode();
+    p_read.visitChildNodes(*this);
+    markVariant(m_symbol_manager_ptr->lookup(p_read.getTarget().getName()));
+}
+
+void LoopUnswitching::visit(IfNode &p_if) {
+    countNode();
+
+    // only a comparison is lowered to a branch
+    const auto *bin_op =
+        dynamic_cast<const BinaryOperatorNode *>(&p_if.getCondition());
+    Candidate candidate{&p_if, m_loop_stack, {}};
+    const bool is_comparison =
+        bin_op && (bin_op->getOp() == Operator::kLessOp ||
+                   bin_op->getOp() == Operator::kLessOrEqualOp ||
+                   bin_op->getOp() == Operator::kGreaterOp ||
+                   bin_op->getOp() == Operator::kGreaterOrEqualOp ||
+                   bin_op->getOp() == Operator::kEqualOp ||
+                   bin_op->getOp() == Operator::kNotEqualOp);
+
+    m_in_condition = true;
+    m_current_condition =
+        (is_comparison && !m_loop_stack.empty()) ? &candidate : nullptr;
+    const_cast<ExpressionNode &>(p_if.getCondition()).accept(*this);
+    if (m_current_condition) {
+        m_candidates.push_back(candidate);
+    }
+    m_current_condition = nullptr;
+    m_in_condition = false;
+
+    const_cast<CompoundStatementNode &>(p_if.getIfBody()).accept(*this);
+    if (p_if.getElseBodyPtr()) {
+        const_cast<CompoundStatementNode *>(p_if.getElseBodyPtr())
+            ->accept(*this);
+    }
+}
+
+void LoopUnswitching::visit(WhileNode &p_while) {
+    m_loop_stack.push_back(&p_while);
+    m_loops[&p_while].m_cold =
+        m_profile.isCold(p_while.getBody().getLocation());
+    countNode();
+    p_while.visitChildNodes(*this);
+    m_loop_stack.pop_back();
+}
+
+void LoopUnswitching::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    m_loop_stack.push_back(&p_for);
+    m_loops[&p_for].m_cold =
+        m_profile.isCold(p_for.getBody().getLocation());
+    countNode();
+    p_for.visitChildNodes(*this);
+    m_loop_stack.pop_back();
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void LoopUnswitching::visit(ReturnNode &p_return) {
+    countNode();
+    p_return.visitChildNodes(*this);
+}
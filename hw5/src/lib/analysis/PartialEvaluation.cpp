@@ -0,0 +1,605 @@
+#include "analysis/PartialEvaluation.hpp"
+#include "AST/operator.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// deeper recursion is left to run on the target
+constexpr size_t kMaxCallDepth = 1000;
+// the code generator passes the rest of the arguments on the stack, and
+// evaluates them in reverse
+constexpr size_t kNumOfArgumentRegister = 8;
+
+bool PartialEvaluation::getValues(const SymbolEntry *p_entry,
+                                  std::vector<int32_t> &p_values) const {
+    const Cell *cell = nullptr;
+    auto global_search = m_globals.find(p_entry);
+    auto body_search = m_body_activation.m_variables.find(p_entry);
+    if (global_search != m_globals.end()) {
+        cell = &global_search->second;
+    } else if (body_search != m_body_activation.m_variables.end()) {
+        cell = &body_search->second;
+    } else {
+        return false;
+    }
+    if (std::none_of(cell->m_defined.begin(), cell->m_defined.end(),
+                     [](const bool p_defined) { return p_defined; })) {
+        return false;
+    }
+
+    p_values.resize(cell->m_values.size());
+    for (size_t i = 0; i < p_values.size(); ++i) {
+        p_values[i] = cell->m_defined[i] ? cell->m_values[i] : 0;
+    }
+    return true;
+}
+
+bool PartialEvaluation::step() { return ++m_num_of_steps <= m_step_budget; }
+
+bool PartialEvaluation::declare(const VariableNode &p_variable) {
+    // constants are taken from their entries, and the variables of other
+    // types are never accessed
+    const auto *type = p_variable.getTypePtr();
+    if (p_variable.getConstantPtr() || !type->isPrimitiveInteger()) {
+        return true;
+    }
+    size_t size = 1;
+    for (const auto dimension : type->getDimensions()) {
+        size *= dimension;
+    }
+    if (m_memory + 4 * size > m_memory_budget) {
+        return false;
+    }
+
+    m_memory += 4 * size;
+    m_activation->m_variables[m_entries.at(&p_variable)] =
+        Cell{std::vector<int32_t>(size), std::vector<bool>(size)};
+    return true;
+}
+
+void PartialEvaluation::undeclare(const VariableNode &p_variable) {
+    auto search = m_activation->m_variables.find(m_entries.at(&p_variable));
+    if (search != m_activation->m_variables.end()) {
+        m_memory -= 4 * search->second.m_values.size();
+        m_activation->m_variables.erase(search);
+    }
+}
+
+bool PartialEvaluation::getReference(
+    const VariableReferenceNode &p_variable_ref, Reference &p_reference,
+    size_t &p_size) {
+    const auto *entry_ptr = m_entries.at(&p_variable_ref);
+    auto variable_search = m_activation->m_variables.find(entry_ptr);
+    auto parameter_search = m_activation->m_array_parameters.find(entry_ptr);
+    auto global_search = m_globals.find(entry_ptr);
+    if (variable_search != m_activation->m_variables.end()) {
+        p_reference = Reference{&variable_search->second, 0};
+    } else if (parameter_search != m_activation->m_array_parameters.end()) {
+        p_reference = parameter_search->second;
+    } else if (global_search != m_globals.end()) {
+        p_reference = Reference{&global_search->second, 0};
+    } else {
+        return false;
+    }
+
+    // row-major, as the code generator lays the arrays out
+    const auto &dimensions = entry_ptr->getTypePtr()->getDimensions();
+    p_size = 1;
+    for (const auto dimension : dimensions) {
+        p_size *= dimension;
+    }
+    const auto &indices = p_variable_ref.getIndices();
+    for (size_t i = 0; i < indices.size(); ++i) {
+        int32_t index = 0;
+        if (!evaluate(*indices[i], index) || index < 0 ||
+            static_cast<uint64_t>(index) >= dimensions[i]) {
+            return false;
+        }
+        p_size /= dimensions[i];
+        p_reference.m_offset += index * p_size;
+    }
+    return true;
+}
+
+bool PartialEvaluation::call(const FunctionInvocationNode &p_func_invocation,
+                             int32_t &p_value) {
+    auto search = m_name_to_function.find(p_func_invocation.getName());
+    if (search == m_name_to_function.end() || !search->second->hasBody() ||
+        m_call_depth == kMaxCallDepth) {
+        return false;
+    }
+    const auto &function = *search->second;
+
+    std::vector<const VariableNode *> parameters;
+    for (const auto &parameter : function.getParameters()) {
+        for (const auto &var_node : parameter->getVariables()) {
+            parameters.push_back(var_node.get());
+        }
+    }
+    const auto &arguments = p_func_invocation.getArguments();
+    assert(arguments.size() == parameters.size() &&
+           "Should have been checked by the semantic analyzer");
+    std::vector<size_t> order;
+    for (size_t i = 0; i < std::min(arguments.size(), kNumOfArgumentRegister);
+         ++i) {
+        order.push_back(i);
+    }
+    for (size_t i = arguments.size(); i > kNumOfArgumentRegister; --i) {
+        order.push_back(i - 1);
+    }
+
+    Activation activation;
+    size_t memory = 0;
+    for (const auto i : order) {
+        const auto *entry_ptr = m_entries.at(parameters[i]);
+        if (!entry_ptr->getTypePtr()->isPrimitiveInteger()) {
+            return false;
+        }
+        if (!entry_ptr->getTypePtr()->getDimensions().empty()) {
+            // passed by reference
+            const auto *variable_ref =
+                dynamic_cast<const VariableReferenceNode *>(arguments[i].get());
+            Reference reference{nullptr, 0};
+            size_t size = 0;
+            if (!variable_ref || !getReference(*variable_ref, reference, size)) {
+                return false;
+            }
+            activation.m_array_parameters[entry_ptr] = reference;
+            continue;
+        }
+        int32_t value = 0;
+        if (!evaluate(*arguments[i], value) ||
+            m_memory + memory + 4 > m_memory_budget) {
+            return false;
+        }
+        memory += 4;
+        activation.m_variables[entry_ptr] = Cell{{value}, {true}};
+    }
+
+    auto *caller = m_activation;
+    m_activation = &activation;
+    m_memory += memory;
+    ++m_call_depth;
+    const auto status = executeCompound(function.getBody());
+    --m_call_depth;
+    m_memory -= memory;
+    m_activation = caller;
+
+    if (status == Status::kFailed) {
+        return false;
+    }
+    if (status == Status::kReturned) {
+        p_value = activation.m_return_value;
+        return true;
+    }
+    // the result of a function falling off its end is undefined
+    p_value = 0;
+    return function.getTypePtr()->isVoid();
+}
+
+bool PartialEvaluation::evaluate(const ExpressionNode &p_expr,
+                                 int32_t &p_value) {
+    if (!step()) {
+        return false;
+    }
+
+    if (const auto *constant_value =
+            dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+        if (!constant_value->getTypePtr()->isInteger()) {
+            return false;
+        }
+        p_value = constant_value->getConstantPtr()->integer();
+        return true;
+    }
+
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        const auto *entry_ptr = m_entries.at(variable_ref);
+        if (entry_ptr->getKind() == SymbolEntry::KindEnum::kConstantKind) {
+            if (!entry_ptr->getTypePtr()->isInteger()) {
+                return false;
+            }
+            p_value = entry_ptr->getAttribute().constant()->integer();
+            return true;
+        }
+        Reference reference{nullptr, 0};
+        size_t size = 0;
+        if (variable_ref->getIndices().size() !=
+                entry_ptr->getTypePtr()->getDimensions().size() ||
+            !getReference(*variable_ref, reference, size) ||
+            !reference.m_cell->m_defined[reference.m_offset]) {
+            return false;
+        }
+        p_value = reference.m_cell->m_values[reference.m_offset];
+        return true;
+    }
+
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        int32_t operand = 0;
+        if (un_op->getOp() != Operator::kNegOp ||
+            !evaluate(un_op->getOperand(), operand)) {
+            return false;
+        }
+        p_value = static_cast<int32_t>(0u - static_cast<uint32_t>(operand));
+        return true;
+    }
+
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        int32_t lhs = 0, rhs = 0;
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+        case Operator::kMinusOp:
+        case Operator::kMultiplyOp:
+        case Operator::kDivideOp:
+        case Operator::kModOp:
+            break;
+        default:
+            return false;
+        }
+        if (!evaluate(bin_op->getLeftOperand(), lhs) ||
+            !evaluate(bin_op->getRightOperand(), rhs)) {
+            return false;
+        }
+
+        // as the RISC-V instructions compute them: wrapping around, and
+        // without trapping on a zero divisor
+        const auto lhs_bits = static_cast<uint32_t>(lhs);
+        const auto rhs_bits = static_cast<uint32_t>(rhs);
+        const bool overflow = lhs == INT32_MIN && rhs == -1;
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+            p_value = static_cast<int32_t>(lhs_bits + rhs_bits);
+            break;
+        case Operator::kMinusOp:
+            p_value = static_cast<int32_t>(lhs_bits - rhs_bits);
+            break;
+        case Operator::kMultiplyOp:
+            p_value = static_cast<int32_t>(lhs_bits * rhs_bits);
+            break;
+        case Operator::kDivideOp:
+            p_value = (rhs == 0) ? -1 : overflow ? lhs : lhs / rhs;
+            break;
+        default:
+            p_value = (rhs == 0) ? lhs : overflow ? 0 : lhs % rhs;
+            break;
+        }
+        return true;
+    }
+
+    if (const auto *func_invocation =
+            dynamic_cast<const FunctionInvocationNode *>(&p_expr)) {
+        return call(*func_invocation, p_value);
+    }
+    return false;
+}
+
+bool PartialEvaluation::evaluateCondition(const ExpressionNode &p_expr,
+                                          bool &p_value) {
+    // only a comparison is lowered to a branch
+    const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&p_expr);
+    int32_t lhs = 0, rhs = 0;
+    if (!bin_op || !step()) {
+        return false;
+    }
+    switch (bin_op->getOp()) {
+    case Operator::kLessOp:
+    case Operator::kLessOrEqualOp:
+    case Operator::kGreaterOp:
+    case Operator::kGreaterOrEqualOp:
+    case Operator::kEqualOp:
+    case Operator::kNotEqualOp:
+        break;
+    default:
+        return false;
+    }
+    if (!evaluate(bin_op->getLeftOperand(), lhs) ||
+        !evaluate(bin_op->getRightOperand(), rhs)) {
+        return false;
+    }
+
+    switch (bin_op->getOp()) {
+    case Operator::kLessOp:
+        p_value = lhs < rhs;
+        break;
+    case Operator::kLessOrEqualOp:
+        p_value = lhs <= rhs;
+        break;
+    case Operator::kGreaterOp:
+        p_value = lhs > rhs;
+        break;
+    case Operator::kGreaterOrEqualOp:
+        p_value = lhs >= rhs;
+        break;
+    case Operator::kEqualOp:
+        p_value = lhs == rhs;
+        break;
+    default:
+        p_value = lhs != rhs;
+        break;
+    }
+    return true;
+}
+
+PartialEvaluation::Status PartialEvaluation::executeCompound(
+    const CompoundStatementNode &p_compound_statement) {
+    auto status = Status::kNormal;
+    std::vector<const VariableNode *> variables;
+    for (const auto &decl : p_compound_statement.getDeclNodes()) {
+        for (const auto &var_node : decl->getVariables()) {
+            variables.push_back(var_node.get());
+            if (!declare(*var_node)) {
+                status = Status::kFailed;
+                break;
+            }
+        }
+    }
+
+    for (const auto &stmt_node : p_compound_statement.getStmtNodes()) {
+        if (status != Status::kNormal) {
+            break;
+        }
+        status = execute(*stmt_node);
+    }
+
+    for (const auto *variable : variables) {
+        undeclare(*variable);
+    }
+    return status;
+}
+
+PartialEvaluation::Status PartialEvaluation::execute(const AstNode &p_statement) {
+    if (!step()) {
+        return Status::kFailed;
+    }
+
+    if (const auto *print = dynamic_cast<const PrintNode *>(&p_statement)) {
+        int32_t value = 0;
+        if (!evaluate(print->getTarget(), value)) {
+            return Status::kFailed;
+        }
+        m_output.push_back(value);
+        return Status::kNormal;
+    }
+
+    if (const auto *assignment =
+            dynamic_cast<const AssignmentNode *>(&p_statement)) {
+        // the value first, as the code generator does
+        int32_t value = 0;
+        const auto &lvalue = assignment->getLvalue();
+        Reference reference{nullptr, 0};
+        size_t size = 0;
+        if (!evaluate(assignment->getExpr(), value) ||
+            lvalue.getIndices().size() !=
+                m_entries.at(&lvalue)->getTypePtr()->getDimensions().size() ||
+            !getReference(lvalue, reference, size)) {
+            return Status::kFailed;
+        }
+        reference.m_cell->m_values[reference.m_offset] = value;
+        reference.m_cell->m_defined[reference.m_offset] = true;
+        return Status::kNormal;
+    }
+
+    if (const auto *if_node = dynamic_cast<const IfNode *>(&p_statement)) {
+        bool condition = false;
+        if (!evaluateCondition(if_node->getCondition(), condition)) {
+            return Status::kFailed;
+        }
+        if (condition) {
+            return executeCompound(if_node->getIfBody());
+        }
+        return if_node->getElseBodyPtr()
+                   ? executeCompound(*if_node->getElseBodyPtr())
+                   : Status::kNormal;
+    }
+
+    if (const auto *while_node =
+            dynamic_cast<const WhileNode *>(&p_statement)) {
+        for (;;) {
+            bool condition = false;
+            if (!evaluateCondition(while_node->getCondition(), condition)) {
+                return Status::kFailed;
+            }
+            if (!condition) {
+                return Status::kNormal;
+            }
+            const auto status = executeCompound(while_node->getBody());
+            if (status != Status::kNormal) {
+                return status;
+            }
+        }
+    }
+
+    if (const auto *for_node = dynamic_cast<const ForNode *>(&p_statement)) {
+        // [lower bound, upper bound)
+        auto &loop_var_decl = const_cast<DeclNode &>(for_node->getLoopVarDecl());
+        const auto &loop_var = *loop_var_decl.getVariables()[0];
+        if (!declare(loop_var)) {
+            return Status::kFailed;
+        }
+        auto &cell = m_activation->m_variables[m_entries.at(&loop_var)];
+        auto status = Status::kNormal;
+        for (auto i = for_node->getLowerBound().getConstantPtr()->integer();
+             i < for_node->getUpperBound().getConstantPtr()->integer() &&
+             status == Status::kNormal;
+             ++i) {
+            cell.m_values[0] = i;
+            cell.m_defined[0] = true;
+            status = executeCompound(for_node->getBody());
+        }
+        undeclare(loop_var);
+        return status;
+    }
+
+    if (const auto *return_node =
+            dynamic_cast<const ReturnNode *>(&p_statement)) {
+        if (!evaluate(return_node->getReturnValue(),
+                      m_activation->m_return_value)) {
+            return Status::kFailed;
+        }
+        return Status::kReturned;
+    }
+
+    if (const auto *func_invocation =
+            dynamic_cast<const FunctionInvocationNode *>(&p_statement)) {
+        int32_t value = 0;
+        return call(*func_invocation, value) ? Status::kNormal
+                                             : Status::kFailed;
+    }
+
+    if (const auto *compound_statement =
+            dynamic_cast<const CompoundStatementNode *>(&p_statement)) {
+        return executeCompound(*compound_statement);
+    }
+
+    // reads the input
+    return Status::kFailed;
+}
+
+void PartialEvaluation::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    for (const auto &func_node : p_program.getFuncNodes()) {
+        m_name_to_function.emplace(func_node->getName(), func_node.get());
+    }
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getDeclNodes().begin(), p_program.getDeclNodes().end(),
+             visit_ast_node);
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    m_body = &p_program.getBody();
+    m_activation = &m_body_activation;
+    if (m_step_budget == 0) {
+        return;
+    }
+
+    // the globals are zero-initialized in .bss
+    for (const auto &decl : p_program.getDeclNodes()) {
+        for (const auto &var_node : decl->getVariables()) {
+            if (!var_node->getTypePtr()->isPrimitiveInteger() ||
+                var_node->getConstantPtr()) {
+                continue;
+            }
+            if (!declare(*var_node)) {
+                return;
+            }
+            auto search = m_body_activation.m_variables.find(
+                m_entries.at(var_node.get()));
+            std::fill(search->second.m_defined.begin(),
+                      search->second.m_defined.end(), true);
+            m_globals.insert(*search);
+            m_body_activation.m_variables.erase(search);
+        }
+    }
+    for (const auto &decl : m_body->getDeclNodes()) {
+        for (const auto &var_node : decl->getVariables()) {
+            if (!declare(*var_node)) {
+                return;
+            }
+        }
+    }
+
+    // a statement that can't be evaluated is undone
+    for (const auto &stmt_node : m_body->getStmtNodes()) {
+        const auto globals = m_globals;
+        const auto variables = m_body_activation.m_variables;
+        const auto memory = m_memory;
+        const auto output_size = m_output.size();
+        if (execute(*stmt_node) == Status::kNormal) {
+            m_evaluated.insert(stmt_node.get());
+            continue;
+        }
+        m_globals = globals;
+        m_body_activation.m_variables = variables;
+        m_memory = memory;
+        m_output.resize(output_size);
+        break;
+    }
+}
+
+void PartialEvaluation::visit(DeclNode &p_decl) {
+    p_decl.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(VariableNode &p_variable) {
+    m_entries[&p_variable] = m_symbol_manager_ptr->lookup(p_variable.getName());
+}
+
+void PartialEvaluation::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_function.getParameters().begin(),
+             p_function.getParameters().end(), visit_ast_node);
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void PartialEvaluation::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void PartialEvaluation::visit(PrintNode &p_print) {
+    p_print.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(FunctionInvocationNode &p_func_invocation) {
+    p_func_invocation.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(VariableReferenceNode &p_variable_ref) {
+    m_entries[&p_variable_ref] =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(AssignmentNode &p_assignment) {
+    p_assignment.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(ReadNode &p_read) {
+    p_read.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void PartialEvaluation::visit(WhileNode &p_while) {
+    p_while.visitChildNodes(*this);
+}
+
+void PartialEvaluation::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    p_for.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void PartialEvaluation::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
@@ -0,0 +1,45 @@
+#include "analysis/Profile.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+bool Profile::load(const char *const p_path) {
+    std::ifstream file(p_path);
+    if (!file) {
+        return false;
+    }
+
+    decltype(m_counts) counts;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        uint32_t source_line = 0;
+        uint32_t source_col = 0;
+        char colon = '\0';
+        uint64_t count = 0;
+        std::string rest;
+        if (!(fields >> source_line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            return false;
+        }
+        if (!(fields >> colon >> source_col >> count) || colon != ':' ||
+            (fields >> rest)) {
+            return false;
+        }
+        counts[{source_line, source_col}] += count;
+    }
+    m_counts.swap(counts);
+    return true;
+}
+
+bool Profile::getCount(const Location &p_location, uint64_t &p_count) const {
+    auto search = m_counts.find({p_location.line, p_location.col});
+    if (search == m_counts.end()) {
+        return false;
+    }
+    p_count = search->second;
+    return true;
+}
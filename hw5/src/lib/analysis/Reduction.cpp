@@ -0,0 +1,144 @@
+#include "analysis/Reduction.hpp"
+#include "AST/operator.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <set>
+
+namespace {
+
+using AssignedSet = std::set<const SymbolEntry *>;
+
+bool isInvariant(const ExpressionNode &p_expr,
+                 const SymbolManager *p_symbol_manager,
+                 const AssignedSet &p_assigned) {
+    if (!p_expr.getInferredType() || !p_expr.getInferredType()->isInteger()) {
+        return false;
+    }
+
+    if (dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+        return true;
+    }
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        return variable_ref->getIndices().empty() &&
+               p_assigned.count(p_symbol_manager->lookup(
+                   variable_ref->getName())) == 0;
+    }
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return un_op->getOp() == Operator::kNegOp &&
+               isInvariant(un_op->getOperand(), p_symbol_manager, p_assigned);
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+        case Operator::kMinusOp:
+        case Operator::kMultiplyOp:
+        case Operator::kDivideOp:
+        case Operator::kModOp:
+            return isInvariant(bin_op->getLeftOperand(), p_symbol_manager,
+                               p_assigned) &&
+                   isInvariant(bin_op->getRightOperand(), p_symbol_manager,
+                               p_assigned);
+        default:
+            return false;
+        }
+    }
+    // function invocations
+    return false;
+}
+
+// p_expr is the target plus or minus terms satisfying p_is_term, which are
+// appended to p_reduction
+bool collectTerms(const ExpressionNode &p_expr,
+                  const std::function<bool(const ExpressionNode &)> &p_is_term,
+                  Reduction &p_reduction) {
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        return variable_ref->getIndices().empty() &&
+               variable_ref->getName() == p_reduction.m_target->getName();
+    }
+
+    const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&p_expr);
+    if (!bin_op) {
+        return false;
+    }
+    const auto &left = bin_op->getLeftOperand();
+    const auto &right = bin_op->getRightOperand();
+    auto &terms = p_reduction.m_terms;
+    const auto num_of_terms = terms.size();
+    switch (bin_op->getOp()) {
+    case Operator::kPlusOp:
+        if (collectTerms(left, p_is_term, p_reduction) && p_is_term(right)) {
+            terms.emplace_back(&right, false);
+            return true;
+        }
+        terms.resize(num_of_terms);
+        if (collectTerms(right, p_is_term, p_reduction) && p_is_term(left)) {
+            terms.emplace_back(&left, false);
+            return true;
+        }
+        terms.resize(num_of_terms);
+        return false;
+    case Operator::kMinusOp:
+        if (collectTerms(left, p_is_term, p_reduction) && p_is_term(right)) {
+            terms.emplace_back(&right, true);
+            return true;
+        }
+        terms.resize(num_of_terms);
+        return false;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+bool getReduction(const AssignmentNode &p_assignment,
+                  const std::function<bool(const ExpressionNode &)> &p_is_term,
+                  Reduction &p_reduction) {
+    p_reduction = Reduction{&p_assignment.getLvalue(), {}};
+    return collectTerms(p_assignment.getExpr(), p_is_term, p_reduction);
+}
+
+bool getReductions(const CompoundStatementNode &p_body,
+                   const SymbolManager *p_symbol_manager,
+                   std::vector<Reduction> &p_reductions) {
+    if (!p_body.getDeclNodes().empty() || p_body.getStmtNodes().empty()) {
+        return false;
+    }
+
+    std::vector<const AssignmentNode *> assignments;
+    AssignedSet assigned;
+    for (const auto &stmt : p_body.getStmtNodes()) {
+        const auto *assignment =
+            dynamic_cast<const AssignmentNode *>(stmt.get());
+        if (!assignment || !assignment->getLvalue().getIndices().empty()) {
+            return false;
+        }
+        const auto *entry_ptr =
+            p_symbol_manager->lookup(assignment->getLvalue().getName());
+        if (!entry_ptr ||
+            (entry_ptr->getKind() != SymbolEntry::KindEnum::kVariableKind &&
+             entry_ptr->getKind() != SymbolEntry::KindEnum::kParameterKind) ||
+            !entry_ptr->getTypePtr()->isInteger() ||
+            !entry_ptr->getTypePtr()->isScalar()) {
+            return false;
+        }
+        assignments.push_back(assignment);
+        assigned.insert(entry_ptr);
+    }
+
+    const auto is_term = [&](const ExpressionNode &p_expr) {
+        return isInvariant(p_expr, p_symbol_manager, assigned);
+    };
+    std::vector<Reduction> reductions;
+    for (const auto *assignment : assignments) {
+        reductions.emplace_back();
+        if (!getReduction(*assignment, is_term, reductions.back())) {
+            return false;
+        }
+    }
+    p_reductions.swap(reductions);
+    return true;
+}
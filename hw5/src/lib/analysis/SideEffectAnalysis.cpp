@@ -0,0 +1,269 @@
+#include "analysis/SideEffectAnalysis.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <set>
+
+const FunctionSummary *
+SideEffectAnalysis::getSummary(const std::string &p_name) const {
+    // functions provided by io.c
+    static const std::map<std::string, FunctionSummary> kRuntimeSummaries = {
+        {"printInt", FunctionSummary{false, false, true, false, false, false}},
+        {"readInt", FunctionSummary{false, false, true, false, false, false}},
+        {"boundsError",
+         FunctionSummary{false, false, true, false, false, false}}};
+
+    auto search = m_summaries.find(p_name);
+    if (search != m_summaries.end()) {
+        return &search->second;
+    }
+    auto runtime_search = kRuntimeSummaries.find(p_name);
+    if (runtime_search != kRuntimeSummaries.end()) {
+        return &runtime_search->second;
+    }
+    return nullptr;
+}
+
+// globals, and arrays passed by reference to the function
+bool SideEffectAnalysis::isNonLocal(
+    const VariableReferenceNode &p_variable_ref) const {
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    assert(entry_ptr && "Should have been defined before use");
+
+    if (entry_ptr->getLevel() == 0 &&
+        entry_ptr->getKind() == SymbolEntry::KindEnum::kVariableKind) {
+        return true;
+    }
+    return !p_variable_ref.getIndices().empty() &&
+           entry_ptr->getKind() == SymbolEntry::KindEnum::kParameterKind;
+}
+
+bool SideEffectAnalysis::mayBeOutOfRange(
+    const VariableReferenceNode &p_variable_ref) const {
+    const auto &indices = p_variable_ref.getIndices();
+    if (indices.empty()) {
+        return false;
+    }
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    assert(entry_ptr && "Should have been defined before use");
+    const auto &dimensions = entry_ptr->getTypePtr()->getDimensions();
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+        int32_t index = 0;
+        if (!getIntegerConstant(*indices[i], m_symbol_manager_ptr, index) ||
+            index < 0 || static_cast<uint64_t>(index) >= dimensions[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SideEffectAnalysis::visitIndices(VariableReferenceNode &p_variable_ref) {
+    const bool may_trap = m_bounds_check && mayBeOutOfRange(p_variable_ref);
+    m_current_summary->may_trap |= may_trap;
+    if (may_trap && !m_invocation_stack.empty()) {
+        // the check is done with the arguments, even if the callee is pure
+        m_trapping_invocations.insert(m_invocation_stack.top());
+    }
+    p_variable_ref.visitChildNodes(*this);
+}
+
+void SideEffectAnalysis::propagateSummaries() {
+    std::map<const FunctionNode *, size_t> index;
+    std::map<const FunctionNode *, size_t> lowlink;
+    std::vector<const FunctionNode *> stack;
+    std::set<const FunctionNode *> on_stack;
+    size_t next_index = 0;
+
+    // Tarjan's algorithm completes the callees' components first
+    std::function<void(const FunctionNode *)> connect =
+        [&](const FunctionNode *p_function) {
+            index[p_function] = lowlink[p_function] = next_index++;
+            stack.push_back(p_function);
+            on_stack.insert(p_function);
+
+            for (const auto *callee : m_call_graph.getCallees(p_function)) {
+                if (!index.count(callee)) {
+                    connect(callee);
+                    lowlink[p_function] =
+                        std::min(lowlink[p_function], lowlink[callee]);
+                } else if (on_stack.count(callee)) {
+                    lowlink[p_function] =
+                        std::min(lowlink[p_function], index[callee]);
+                }
+            }
+
+            if (lowlink[p_function] != index[p_function]) {
+                return;
+            }
+
+            std::set<const FunctionNode *> component;
+            const FunctionNode *member = nullptr;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack.erase(member);
+                component.insert(member);
+            } while (member != p_function);
+
+            FunctionSummary summary;
+            bool recursive = component.size() > 1;
+            for (const auto *function : component) {
+                summary.merge(m_local_summaries[function]);
+                for (const auto *callee : m_call_graph.getCallees(function)) {
+                    if (component.count(callee)) {
+                        recursive = true;
+                    } else {
+                        summary.merge(m_summaries.at(callee->getName()));
+                    }
+                }
+            }
+            summary.may_loop |= recursive;
+
+            for (const auto *function : component) {
+                m_summaries[function->getName()] = summary;
+                if (recursive) {
+                    m_recursive_functions.insert(function);
+                }
+            }
+        };
+
+    for (const auto *function : m_call_graph.getFunctions()) {
+        if (!index.count(function)) {
+            connect(function);
+        }
+    }
+}
+
+bool SideEffectAnalysis::isRemovable(
+    const FunctionInvocationNode &p_func_invocation) const {
+    const auto *summary = getSummary(p_func_invocation.getName());
+    if (!summary || !summary->isRemovable() ||
+        m_trapping_invocations.count(&p_func_invocation)) {
+        return false;
+    }
+
+    auto search = m_nested_invocations.find(&p_func_invocation);
+    if (search == m_nested_invocations.end()) {
+        return true;
+    }
+    return std::all_of(search->second.begin(), search->second.end(),
+                       [&](const FunctionInvocationNode *p_nested) {
+                           return isRemovable(*p_nested);
+                       });
+}
+
+void SideEffectAnalysis::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+
+    // only for the invocations in the body
+    FunctionSummary body_summary;
+    m_current_summary = &body_summary;
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    propagateSummaries();
+}
+
+void SideEffectAnalysis::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    m_current_summary = &m_local_summaries[&p_function];
+    // nothing is known about a function defined elsewhere
+    m_current_summary->calls_unknown = !p_function.hasBody();
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void SideEffectAnalysis::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    p_compound_statement.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void SideEffectAnalysis::visit(PrintNode &p_print) {
+    m_current_summary->does_io = true;
+    p_print.visitChildNodes(*this);
+}
+
+void SideEffectAnalysis::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void SideEffectAnalysis::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void SideEffectAnalysis::visit(FunctionInvocationNode &p_func_invocation) {
+    if (!m_invocation_stack.empty()) {
+        m_nested_invocations[m_invocation_stack.top()].push_back(
+            &p_func_invocation);
+    }
+
+    // the effects of the callee are propagated over the call graph
+    m_invocation_stack.push(&p_func_invocation);
+    p_func_invocation.visitChildNodes(*this);
+    m_invocation_stack.pop();
+}
+
+void SideEffectAnalysis::visit(VariableReferenceNode &p_variable_ref) {
+    m_current_summary->reads_globals |= isNonLocal(p_variable_ref);
+    visitIndices(p_variable_ref);
+}
+
+void SideEffectAnalysis::visit(AssignmentNode &p_assignment) {
+    auto &lvalue = const_cast<VariableReferenceNode &>(p_assignment.getLvalue());
+    m_current_summary->writes_globals |= isNonLocal(lvalue);
+    visitIndices(lvalue);
+
+    const_cast<ExpressionNode &>(p_assignment.getExpr()).accept(*this);
+}
+
+void SideEffectAnalysis::visit(ReadNode &p_read) {
+    auto &target = const_cast<VariableReferenceNode &>(p_read.getTarget());
+    m_current_summary->does_io = true;
+    m_current_summary->writes_globals |= isNonLocal(target);
+    visitIndices(target);
+}
+
+void SideEffectAnalysis::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void SideEffectAnalysis::visit(WhileNode &p_while) {
+    m_current_summary->may_loop = true;
+    p_while.visitChildNodes(*this);
+}
+
+void SideEffectAnalysis::visit(ForNode &p_for) {
+    // the bounds are constant and the loop variable can't be assigned, so a
+    // for loop always terminates
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    p_for.visitChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void SideEffectAnalysis::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
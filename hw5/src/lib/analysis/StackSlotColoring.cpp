@@ -0,0 +1,258 @@
+#include "analysis/StackSlotColoring.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+size_t StackSlotColoring::getOffset(const SymbolEntry *p_variable) const {
+    auto search = m_live_ranges.find(p_variable);
+    assert(search != m_live_ranges.end() && "Should have been visited");
+    return search->second.m_offset;
+}
+
+size_t StackSlotColoring::getFrameSize(const FunctionNode *p_function) const {
+    auto search = m_frame_sizes.find(p_function);
+    return (search == m_frame_sizes.end()) ? 0 : search->second;
+}
+
+void StackSlotColoring::reference(const SymbolEntry *p_variable) {
+    // globals and constants have no slots
+    auto search = m_live_ranges.find(p_variable);
+    if (search == m_live_ranges.end()) {
+        return;
+    }
+
+    auto &live_range = search->second;
+    const bool is_parameter =
+        p_variable->getKind() == SymbolEntry::KindEnum::kParameterKind;
+    ++m_position;
+    if (!live_range.m_referenced && !is_parameter) {
+        live_range.m_begin = m_position;
+    }
+    live_range.m_end = m_position;
+    live_range.m_referenced = true;
+    if (!m_loop_stack.empty()) {
+        m_loop_stack.back().m_referenced.insert(p_variable);
+    }
+}
+
+void StackSlotColoring::beginLoop() {
+    m_loop_stack.push_back(Loop{++m_position, {}});
+}
+
+void StackSlotColoring::endLoop() {
+    auto loop = std::move(m_loop_stack.back());
+    m_loop_stack.pop_back();
+    ++m_position;
+
+    // live throughout the loop if declared outside of it
+    for (const auto *variable : loop.m_referenced) {
+        auto &live_range = m_live_ranges.at(variable);
+        if (live_range.m_loop_depth <= m_loop_stack.size()) {
+            live_range.m_begin = std::min(live_range.m_begin, loop.m_begin);
+            live_range.m_end = std::max(live_range.m_end, m_position);
+        }
+    }
+    if (!m_loop_stack.empty()) {
+        m_loop_stack.back().m_referenced.insert(loop.m_referenced.begin(),
+                                                loop.m_referenced.end());
+    }
+}
+
+void StackSlotColoring::assignOffsets() {
+    std::map<const FunctionNode *, std::vector<LiveRange *>> functions;
+    for (const auto *variable : m_variables) {
+        auto &live_range = m_live_ranges.at(variable);
+        functions[live_range.m_function].push_back(&live_range);
+    }
+
+    for (auto &function : functions) {
+        auto &live_ranges = function.second;
+        std::stable_sort(live_ranges.begin(), live_ranges.end(),
+                         [](const LiveRange *p_lhs, const LiveRange *p_rhs) {
+                             return p_lhs->m_begin < p_rhs->m_begin;
+                         });
+
+        size_t frame_size = 0;
+        for (size_t i = 0; i < live_ranges.size(); ++i) {
+            auto &live_range = *live_ranges[i];
+
+            // [offset, offset + size) of the interfering ones colored
+            std::vector<std::pair<size_t, size_t>> taken;
+            for (size_t j = 0; j < i; ++j) {
+                const auto &other = *live_ranges[j];
+                if (other.m_end >= live_range.m_begin &&
+                    live_range.m_end >= other.m_begin) {
+                    taken.emplace_back(other.m_offset,
+                                       other.m_offset + other.m_size);
+                }
+            }
+            std::sort(taken.begin(), taken.end());
+
+            size_t offset = 0;
+            for (const auto &bytes : taken) {
+                if (offset + live_range.m_size <= bytes.first) {
+                    break;
+                }
+                offset = std::max(offset, bytes.second);
+            }
+            live_range.m_offset = offset;
+            frame_size = std::max(frame_size, offset + live_range.m_size);
+        }
+        m_frame_sizes[function.first] = frame_size;
+    }
+}
+
+void StackSlotColoring::visit(ProgramNode &p_program) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_program.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
+             visit_ast_node);
+
+    m_current_function = nullptr;
+    const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_program.getSymbolTable());
+
+    assignOffsets();
+}
+
+void StackSlotColoring::visit(DeclNode &p_decl) {
+    p_decl.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(VariableNode &p_variable) {
+    if (p_variable.getConstantPtr()) {
+        return;
+    }
+
+    // an array parameter is passed by reference
+    const auto *entry_ptr = m_symbol_manager_ptr->lookup(p_variable.getName());
+    size_t size = 4;
+    if (entry_ptr->getKind() != SymbolEntry::KindEnum::kParameterKind) {
+        for (const auto dimension : p_variable.getTypePtr()->getDimensions()) {
+            size *= dimension;
+        }
+    }
+
+    ++m_position;
+    m_variables.push_back(entry_ptr);
+    m_live_ranges.emplace(entry_ptr,
+                          LiveRange{m_current_function, m_position, m_position,
+                                    size, m_loop_stack.size()});
+}
+
+void StackSlotColoring::visit(FunctionNode &p_function) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_function.getSymbolTable());
+
+    m_current_function = &p_function;
+    const auto begin = ++m_position;
+    const auto num_of_variables = m_variables.size();
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_function.getParameters().begin(),
+             p_function.getParameters().end(), visit_ast_node);
+    // the arguments are all stored at the entry
+    for (size_t i = num_of_variables; i < m_variables.size(); ++i) {
+        auto &live_range = m_live_ranges.at(m_variables[i]);
+        live_range.m_begin = begin;
+        live_range.m_end = m_position;
+    }
+    p_function.visitBodyChildNodes(*this);
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_function.getSymbolTable());
+}
+
+void StackSlotColoring::visit(CompoundStatementNode &p_compound_statement) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_compound_statement.getSymbolTable());
+
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_compound_statement.getDeclNodes().begin(),
+             p_compound_statement.getDeclNodes().end(), visit_ast_node);
+
+    // the results of the statements evaluated are assigned at the beginning
+    if (m_partial_evaluation.isEvaluatedBody(p_compound_statement)) {
+        for (const auto &decl : p_compound_statement.getDeclNodes()) {
+            for (const auto &var_node : decl->getVariables()) {
+                const auto *entry_ptr =
+                    m_symbol_manager_ptr->lookup(var_node->getName());
+                std::vector<int32_t> values;
+                if (m_partial_evaluation.getValues(entry_ptr, values)) {
+                    reference(entry_ptr);
+                }
+            }
+        }
+    }
+
+    for (const auto &stmt_node : p_compound_statement.getStmtNodes()) {
+        if (!m_partial_evaluation.isEvaluated(*stmt_node)) {
+            stmt_node->accept(*this);
+        }
+    }
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(
+        p_compound_statement.getSymbolTable());
+}
+
+void StackSlotColoring::visit(PrintNode &p_print) {
+    p_print.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(BinaryOperatorNode &p_bin_op) {
+    p_bin_op.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(UnaryOperatorNode &p_un_op) {
+    p_un_op.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(FunctionInvocationNode &p_func_invocation) {
+    p_func_invocation.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(VariableReferenceNode &p_variable_ref) {
+    p_variable_ref.visitChildNodes(*this);
+    reference(m_symbol_manager_ptr->lookup(p_variable_ref.getName()));
+}
+
+void StackSlotColoring::visit(AssignmentNode &p_assignment) {
+    p_assignment.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(ReadNode &p_read) {
+    p_read.visitChildNodes(*this);
+}
+
+void StackSlotColoring::visit(IfNode &p_if) { p_if.visitChildNodes(*this); }
+
+void StackSlotColoring::visit(WhileNode &p_while) {
+    // the condition is evaluated in every iteration
+    beginLoop();
+    p_while.visitChildNodes(*this);
+    endLoop();
+}
+
+void StackSlotColoring::visit(ForNode &p_for) {
+    m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+        p_for.getSymbolTable());
+
+    // the loop variable is declared outside of the loop, so that it's live
+    // throughout it
+    const_cast<DeclNode &>(p_for.getLoopVarDecl()).accept(*this);
+    beginLoop();
+    const_cast<AssignmentNode &>(p_for.getLoopVarInitStmt()).accept(*this);
+    const_cast<CompoundStatementNode &>(p_for.getBody()).accept(*this);
+    endLoop();
+
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void StackSlotColoring::visit(ReturnNode &p_return) {
+    p_return.visitChildNodes(*this);
+}
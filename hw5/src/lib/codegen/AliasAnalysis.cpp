@@ -0,0 +1,259 @@
+#include "codegen/AliasAnalysis.hpp"
+
+#include <cassert>
+#include <tuple>
+
+static int32_t getAccessSize(const std::string &p_op) {
+    switch (p_op[1]) {
+    case 'b':
+        return 1;
+    case 'h':
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// ===========================================
+// > MemoryLocation
+// ===========================================
+bool AliasAnalysis::MemoryLocation::operator<(
+    const MemoryLocation &p_other) const {
+    return std::tie(m_kind, m_symbol, m_offset_known, m_offset, m_size) <
+           std::tie(p_other.m_kind, p_other.m_symbol, p_other.m_offset_known,
+                    p_other.m_offset, p_other.m_size);
+}
+
+bool AliasAnalysis::MemoryLocation::operator==(
+    const MemoryLocation &p_other) const {
+    return m_kind == p_other.m_kind && m_symbol == p_other.m_symbol &&
+           m_offset_known == p_other.m_offset_known &&
+           m_offset == p_other.m_offset && m_size == p_other.m_size;
+}
+
+// ===========================================
+// > AliasAnalysis
+// ===========================================
+AliasAnalysis::AliasAnalysis(const MachineFunction &p_function,
+                             const SideEffectAnalysis *p_side_effects)
+    : m_side_effects(p_side_effects),
+      m_frame_escaped(p_function.isFrameAddressEscaped()) {
+    const auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+    m_locations.assign(insts.size(), MemoryLocation{});
+
+    // the addresses held by the registers at the end of each block; a
+    // register keeps its address only if all the predecessors agree
+    std::vector<AddressState> out_states(blocks.size());
+    std::vector<bool> visited(blocks.size(), false);
+    auto compute_in_state = [&](const size_t b) {
+        AddressState state;
+        bool first = true;
+        for (const auto pred : blocks[b].predecessors) {
+            if (!visited[pred]) {
+                continue;
+            }
+            if (first) {
+                state = out_states[pred];
+                first = false;
+                continue;
+            }
+            for (auto it = state.begin(); it != state.end();) {
+                auto search = out_states[pred].find(it->first);
+                const bool same = search != out_states[pred].end() &&
+                                  search->second == it->second;
+                it = same ? std::next(it) : state.erase(it);
+            }
+        }
+        return state;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            auto state = (b == 0) ? AddressState{} : compute_in_state(b);
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+                m_locations[i] = resolve(insts[i], state);
+                transfer(insts[i], state);
+            }
+            if (!visited[b] || state != out_states[b]) {
+                visited[b] = true;
+                out_states[b].swap(state);
+                changed = true;
+            }
+        }
+    }
+}
+
+void AliasAnalysis::transfer(const MachineInstruction &p_inst,
+                             AddressState &p_state) {
+    if (!p_inst.isInstruction()) {
+        return;
+    }
+
+    if (p_inst.isCall()) {
+        for (auto it = p_state.begin(); it != p_state.end();) {
+            it = isCallerSavedRegister(it->first) ? p_state.erase(it)
+                                                  : std::next(it);
+        }
+        return;
+    }
+
+    const auto defined = p_inst.getDefinedRegister();
+    if (defined.empty()) {
+        return;
+    }
+
+    const auto &op = p_inst.getOpcode();
+    const auto &operands = p_inst.getOperands();
+    Address address;
+    bool is_address = false;
+    if (op == "la") {
+        address.m_symbol = operands[1];
+        address.m_offset_known = true;
+        is_address = true;
+    } else if (op == "mv" || op == "addi") {
+        auto search = p_state.find(operands[1]);
+        int32_t imm = 0;
+        if (search != p_state.end() &&
+            (op == "mv" || parseImmediate(operands[2], imm))) {
+            address = search->second;
+            address.m_offset += imm;
+            is_address = true;
+        }
+    } else if (op == "add") {
+        // base + index
+        auto lhs = p_state.find(operands[1]);
+        auto rhs = p_state.find(operands[2]);
+        if ((lhs != p_state.end()) != (rhs != p_state.end())) {
+            address = (lhs != p_state.end()) ? lhs->second : rhs->second;
+            address.m_offset_known = false;
+            is_address = true;
+        }
+    }
+
+    if (is_address) {
+        p_state[defined] = address;
+    } else {
+        p_state.erase(defined);
+    }
+}
+
+AliasAnalysis::MemoryLocation
+AliasAnalysis::resolve(const MachineInstruction &p_inst,
+                       const AddressState &p_state) {
+    MemoryLocation location;
+    MemoryOperand mem;
+    const bool vector = p_inst.isVectorLoad() || p_inst.isVectorStore();
+    if ((!p_inst.isLoad() && !p_inst.isStore() && !vector) ||
+        !parseMemoryOperand(p_inst.getOperands()[1], mem)) {
+        return location;
+    }
+
+    // a vector access covers vl elements from the address
+    location.m_size = vector ? 0 : getAccessSize(p_inst.getOpcode());
+    location.m_offset = mem.offset;
+    location.m_offset_known = !vector;
+    if (mem.base == "s0") {
+        location.m_kind = MemoryLocation::KindEnum::kFrame;
+        return location;
+    }
+    if (mem.base == "sp") {
+        location.m_kind = MemoryLocation::KindEnum::kStack;
+        return location;
+    }
+
+    auto search = p_state.find(mem.base);
+    if (search == p_state.end()) {
+        location.m_kind = MemoryLocation::KindEnum::kUnknown;
+        location.m_offset_known = false;
+        return location;
+    }
+    location.m_kind = MemoryLocation::KindEnum::kGlobal;
+    location.m_symbol = search->second.m_symbol;
+    location.m_offset_known = !vector && search->second.m_offset_known;
+    location.m_offset += search->second.m_offset;
+    return location;
+}
+
+AliasAnalysis::AliasResult
+AliasAnalysis::alias(const MemoryLocation &p_lhs,
+                     const MemoryLocation &p_rhs) const {
+    using KindEnum = MemoryLocation::KindEnum;
+    if (p_lhs.m_kind == KindEnum::kNone || p_rhs.m_kind == KindEnum::kNone) {
+        return AliasResult::kNoAlias;
+    }
+
+    // the byte ranges of two accesses to the same base object
+    auto compare_ranges = [&]() {
+        if (!p_lhs.m_offset_known || !p_rhs.m_offset_known) {
+            return AliasResult::kMayAlias;
+        }
+        if (p_lhs.m_offset == p_rhs.m_offset &&
+            p_lhs.m_size == p_rhs.m_size) {
+            return AliasResult::kMustAlias;
+        }
+        const bool disjoint =
+            p_lhs.m_offset + p_lhs.m_size <= p_rhs.m_offset ||
+            p_rhs.m_offset + p_rhs.m_size <= p_lhs.m_offset;
+        return disjoint ? AliasResult::kNoAlias : AliasResult::kMayAlias;
+    };
+
+    if (p_lhs.m_kind == KindEnum::kUnknown ||
+        p_rhs.m_kind == KindEnum::kUnknown) {
+        const auto &other =
+            (p_lhs.m_kind == KindEnum::kUnknown) ? p_rhs : p_lhs;
+        return (other.m_kind == KindEnum::kFrame && !m_frame_escaped)
+                   ? AliasResult::kNoAlias
+                   : AliasResult::kMayAlias;
+    }
+    if (p_lhs.m_kind != p_rhs.m_kind) {
+        // the expression stack lies below the slots of the frame
+        const bool frame_and_stack = p_lhs.m_kind != KindEnum::kGlobal &&
+                                     p_rhs.m_kind != KindEnum::kGlobal;
+        return (frame_and_stack && m_frame_escaped) ? AliasResult::kMayAlias
+                                                    : AliasResult::kNoAlias;
+    }
+
+    switch (p_lhs.m_kind) {
+    case KindEnum::kFrame:
+        return compare_ranges();
+    case KindEnum::kStack:
+        // sp moves, so the same offset isn't the same slot
+        return AliasResult::kMayAlias;
+    case KindEnum::kGlobal:
+        return (p_lhs.m_symbol == p_rhs.m_symbol) ? compare_ranges()
+                                                  : AliasResult::kNoAlias;
+    default:
+        assert(false && "Shouldn't reach here");
+        return AliasResult::kMayAlias;
+    }
+}
+
+bool AliasAnalysis::mayClobber(const MachineInstruction &p_call,
+                               const MemoryLocation &p_location) const {
+    assert(p_call.isCall() && "Should be a call");
+
+    using KindEnum = MemoryLocation::KindEnum;
+    switch (p_location.m_kind) {
+    case KindEnum::kNone:
+        return false;
+    case KindEnum::kFrame:
+        return m_frame_escaped;
+    case KindEnum::kGlobal: {
+        // the tables that the code generator indexes, e.g. of a memoized
+        // function, aren't in the side-effect summaries
+        if (!p_location.m_offset_known) {
+            return true;
+        }
+        const auto *summary = m_side_effects
+                                  ? m_side_effects->getSummary(p_call.getTarget())
+                                  : nullptr;
+        return !summary || !summary->preservesGlobals();
+    }
+    default:
+        // the callee may write the stack below sp
+        return true;
+    }
+}
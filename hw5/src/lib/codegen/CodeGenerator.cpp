@@ -1,20 +1,37 @@
 #include "codegen/CodeGenerator.hpp"
 #include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "codegen/CycleEstimator.hpp"
+#include "codegen/FrameSlotForwarding.hpp"
+#include "codegen/InstructionScheduler.hpp"
+#include "codegen/RedundantLoadElimination.hpp"
+#include "codegen/RvcCompression.hpp"
+#include "codegen/SparseConditionalConstantPropagation.hpp"
+#include "codegen/ValueRangeAnalysis.hpp"
 #include "visitor/AstNodeInclude.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
 
 // -4: return address, -8: frame pointer of the last stack
 constexpr const size_t kLocalVariableStartOffset = 12;
+// the frame that the prologue allocates
+constexpr const size_t kFixedFrameSize = 128;
+// of the source file in the .loc directives (-g)
+constexpr const unsigned kSourceFileNumber = 1;
 
 CodeGenerator::CodeGenerator(const std::string source_file_name,
                              const std::string save_path,
-                             const SymbolManager *const p_symbol_manager)
+                             const SymbolManager *const p_symbol_manager,
+                             const CodegenOptions &p_options)
     : m_symbol_manager_ptr(p_symbol_manager),
-      m_source_file_path(source_file_name) {
+      m_source_file_path(source_file_name), m_options(p_options) {
     // FIXME: assume that the source file is always xxxx.p
     const std::string &real_path =
         (save_path == "") ? std::string{"."} : save_path;
@@ -26,20 +43,14 @@ CodeGenerator::CodeGenerator(const std::string source_file_name,
     } else {
         slash_pos = 0;
     }
-    std::string output_file_path(
+    const std::string output_file_base_path(
         real_path + "/" +
-        source_file_name.substr(slash_pos, dot_pos - slash_pos) + ".S");
-    m_output_file.reset(fopen(output_file_path.c_str(), "w"));
+        source_file_name.substr(slash_pos, dot_pos - slash_pos));
+    m_output_file.reset(fopen((output_file_base_path + ".S").c_str(), "w"));
+    m_size_report_path = output_file_base_path + ".size.json";
     assert(m_output_file.get() && "Failed to open output file");
 }
 
-static void emitInstructions(FILE *p_out_file, const char *format, ...) {
-    va_list args;
-    va_start(args, format);
-    vfprintf(p_out_file, format, args);
-    va_end(args);
-}
-
 // clang-format off
 static constexpr const char*const kFixedFunctionPrologue =
     "    .globl %s\n"
@@ -58,6 +69,230 @@ static constexpr const char*const kFixedFunctionEpilogue =
     "    .size %s, .-%s\n";
 // clang-format on
 
+void CodeGenerator::emitInstructions(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!m_machine_function) {
+        vfprintf(m_output_file.get(), format, args);
+        va_end(args);
+        return;
+    }
+
+    // buffer the instructions of a function for the optimizations
+    va_list args_copy;
+    va_copy(args_copy, args);
+    const int length = vsnprintf(nullptr, 0, format, args_copy);
+    va_end(args_copy);
+
+    std::string text(length + 1, '\0');
+    vsnprintf(&text[0], text.size(), format, args);
+    va_end(args);
+
+    text.pop_back();
+    auto &insts = m_machine_function->getInstructions();
+    const auto begin = insts.size();
+    m_machine_function->appendAssembly(text);
+    for (size_t i = begin; i < insts.size(); ++i) {
+        insts[i].setSource(m_source_line, m_frequency);
+    }
+}
+
+void CodeGenerator::beginFunction(const char *p_name) {
+    m_machine_function.reset(new MachineFunction(p_name));
+    m_return_label = m_label_sequence++;
+    emitInstructions(kFixedFunctionPrologue, p_name, p_name, p_name);
+    m_prologue_end = m_machine_function->getInstructions().size();
+    m_max_outgoing_arguments = 0;
+    m_frequency = 1;
+
+    // start from 8 since 0-4, 4-8 are for return addr, last stack addr
+    m_local_var_offset = kLocalVariableStartOffset +
+                         m_slot_coloring->getFrameSize(m_current_function);
+    m_max_local_var_offset = m_local_var_offset;
+}
+
+void CodeGenerator::generateScaled(const double p_factor,
+                                   const std::function<void()> &p_generate) {
+    const auto frequency = m_frequency;
+    m_frequency *= p_factor;
+    p_generate();
+    m_frequency = frequency;
+}
+
+size_t
+CodeGenerator::getLocalVariableOffset(const SymbolEntry *p_entry) const {
+    auto search = m_local_var_offset_map.find(p_entry);
+    assert(search != m_local_var_offset_map.end() &&
+           "Should have been defined before use");
+    return search->second;
+}
+
+void CodeGenerator::emitFrameAccess(const char *p_op, const char *p_reg,
+                                    const size_t p_offset) {
+    if (p_offset <= 2048) {
+        emitInstructions("    %s %s, -%zu(s0)\n", p_op, p_reg, p_offset);
+        return;
+    }
+    // out of the range of the 12-bit offset; nothing else uses t3, so that
+    // it can't clobber a value live across the store
+    const char *base = strcmp(p_op, "sw") == 0 ? "t3" : p_reg;
+    emitFrameAddress(base, p_offset);
+    emitInstructions("    %s %s, 0(%s)\n", p_op, p_reg, base);
+}
+
+void CodeGenerator::emitFrameAddress(const char *p_reg,
+                                     const size_t p_offset) {
+    if (p_offset <= 2048) {
+        emitInstructions("    addi %s, s0, -%zu\n", p_reg, p_offset);
+    } else {
+        emitInstructions("    li %s, -%zu\n"
+                         "    add %s, s0, %s\n",
+                         p_reg, p_offset, p_reg, p_reg);
+    }
+}
+
+void CodeGenerator::generate(AstNode &p_node) { p_node.accept(*this); }
+
+size_t CodeGenerator::allocateTemporarySlot() {
+    const auto offset = m_local_var_offset;
+    m_local_var_offset += 4;
+    m_max_local_var_offset =
+        std::max(m_max_local_var_offset, m_local_var_offset);
+    return offset;
+}
+
+void CodeGenerator::endFunction() {
+    const char *name = m_machine_function->getName().c_str();
+    emitInstructions("L%zu:\n", m_return_label);
+    if (m_memoization->isMemoizing()) {
+        m_memoization->end(*this);
+    }
+
+    // the slots take [s0 - m_max_local_var_offset + 4, s0 - 8); sp stays
+    // 16-byte aligned
+    const size_t frame_size = (m_max_local_var_offset - 4 + 15) / 16 * 16;
+    if (frame_size > kFixedFrameSize) {
+        const auto extension = frame_size - kFixedFrameSize;
+        MachineFunction::Instructions allocation;
+        if (extension < 2048) {
+            allocation.push_back(MachineInstruction::parse(
+                "    addi sp, sp, -" + std::to_string(extension)));
+            emitInstructions("    addi sp, sp, %zu\n", extension);
+        } else {
+            allocation.push_back(MachineInstruction::parse(
+                "    li t0, " + std::to_string(extension)));
+            allocation.push_back(
+                MachineInstruction::parse("    sub sp, sp, t0"));
+            emitInstructions("    li t0, %zu\n"
+                             "    add sp, sp, t0\n",
+                             extension);
+        }
+        auto &insts = m_machine_function->getInstructions();
+        for (auto &inst : allocation) {
+            inst.setSource(insts.front().getLine(), 1);
+        }
+        insts.insert(insts.begin() + m_prologue_end, allocation.begin(),
+                     allocation.end());
+    }
+    emitInstructions(kFixedFunctionEpilogue, name, name);
+    if (!m_cold_instructions.empty()) {
+        emitInstructions("    .pushsection .text.unlikely\n"
+                         "%s.cold:\n",
+                         name);
+        auto &insts = m_machine_function->getInstructions();
+        insts.insert(insts.end(),
+                     std::make_move_iterator(m_cold_instructions.begin()),
+                     std::make_move_iterator(m_cold_instructions.end()));
+        m_cold_instructions.clear();
+        emitInstructions("    .popsection\n");
+    }
+
+    // folding a branch may expose more forwarding, and vice versa
+    FrameSlotForwarding().run(*m_machine_function);
+    for (;;) {
+        bool changed = SparseConditionalConstantPropagation(
+                           m_side_effects.get())
+                           .run(*m_machine_function);
+        changed |= ValueRangeAnalysis().run(*m_machine_function);
+        changed |= RedundantLoadElimination(m_side_effects.get())
+                       .run(*m_machine_function);
+        if (!changed) {
+            break;
+        }
+        FrameSlotForwarding().run(*m_machine_function);
+    }
+
+    const auto stalls = InstructionScheduler(m_options.latency_model)
+                            .run(*m_machine_function);
+    if (m_options.print_stalls) {
+        fprintf(stderr, "stalls %s: %zu -> %zu\n", name, stalls.m_before,
+                stalls.m_after);
+    }
+
+    if (m_options.dump_ir) {
+        ValueRangeAnalysis().dump(*m_machine_function, stdout);
+    }
+    if (m_options.debug_line) {
+        m_machine_function->addLineDirectives(kSourceFileNumber);
+    }
+    if (m_options.estimate_cycles) {
+        auto estimate =
+            CycleEstimator(m_options.latency_model).run(*m_machine_function);
+        fprintf(stderr, "estimate-cycles %s: %.1f per call\n", name,
+                estimate.m_cycles);
+        for (const auto &line : estimate.m_lines) {
+            fprintf(stderr, "estimate-cycles %s:%u: %.1f\n", name, line.first,
+                    line.second);
+        }
+        m_cycle_annotations[m_machine_function.get()] =
+            std::move(estimate.m_annotations);
+    }
+    // measured before the frame slots are accessed through sp
+    auto *size = m_options.size_report
+                     ? &m_size_report.addFunction(
+                           *m_machine_function,
+                           std::max(frame_size, kFixedFrameSize),
+                           m_max_outgoing_arguments)
+                     : nullptr;
+    if (m_options.compress) {
+        const auto report = RvcCompression().run(*m_machine_function);
+        fprintf(stderr, "size %s: %zu -> %zu bytes\n", name,
+                report.m_uncompressed, report.m_compressed);
+        if (size) {
+            size->m_bytes = report.m_compressed;
+        }
+    }
+
+    m_generated_functions[m_current_function].push_back(
+        std::move(m_machine_function));
+}
+
+void CodeGenerator::printFunctions() {
+    for (const auto *function : m_ordering->getOrder()) {
+        const bool cold = m_ordering->isCold(function);
+        for (const auto &machine_function : m_generated_functions[function]) {
+            // the jump tables switch back to .text after each function
+            if (cold) {
+                fprintf(m_output_file.get(), ".section    .text.unlikely\n"
+                                             "    .align 2\n");
+            }
+            auto annotations = m_cycle_annotations.find(machine_function.get());
+            if (annotations != m_cycle_annotations.end()) {
+                machine_function->print(m_output_file.get(),
+                                        annotations->second);
+            } else {
+                machine_function->print(m_output_file.get());
+            }
+        }
+        if (cold) {
+            fprintf(m_output_file.get(), ".section    .text\n"
+                                         "    .align 2\n");
+        }
+    }
+    m_generated_functions.clear();
+    m_cycle_annotations.clear();
+}
+
 void CodeGenerator::visit(ProgramNode &p_program) {
     // clang-format off
     constexpr const char*const riscv_assembly_file_prologue =
@@ -66,8 +301,75 @@ void CodeGenerator::visit(ProgramNode &p_program) {
         ".section    .text\n"
         "    .align 2\n";
     // clang-format on
-    emitInstructions(m_output_file.get(), riscv_assembly_file_prologue,
-                     m_source_file_path.c_str());
+    emitInstructions(riscv_assembly_file_prologue, m_source_file_path.c_str());
+    if (m_options.debug_line) {
+        emitInstructions("    .file %u \"%s\"\n", kSourceFileNumber,
+                         m_source_file_path.c_str());
+    }
+    if (m_options.vector) {
+        emitInstructions("    .option arch, +v\n");
+    }
+    if (m_options.compress) {
+        emitInstructions("    .option rvc\n");
+    }
+
+    m_partial_evaluation.reset(new PartialEvaluation(
+        m_symbol_manager_ptr, m_options.partial_eval_budget,
+        m_options.partial_eval_memory));
+    p_program.accept(*m_partial_evaluation);
+    m_call_graph.reset(
+        new CallGraph(m_symbol_manager_ptr, *m_partial_evaluation));
+    p_program.accept(*m_call_graph);
+    m_side_effects.reset(new SideEffectAnalysis(
+        m_symbol_manager_ptr, *m_call_graph, m_options.bounds_check));
+    p_program.accept(*m_side_effects);
+    m_memoization.reset(
+        new Memoization(*m_side_effects, m_options.memoize_budget));
+    m_compare_chains.reset(new CompareChainLowering(m_symbol_manager_ptr));
+    m_specialization.reset(new FunctionSpecialization(
+        m_symbol_manager_ptr, m_options.specialize_budget, m_options.profile,
+        *m_partial_evaluation));
+    p_program.accept(*m_specialization);
+    m_unswitching.reset(new LoopUnswitching(
+        m_symbol_manager_ptr, *m_side_effects, m_options.unswitch_budget,
+        m_options.profile));
+    p_program.accept(*m_unswitching);
+    m_interchange.reset(
+        new LoopInterchange(m_symbol_manager_ptr, m_options.loop_tile));
+    p_program.accept(*m_interchange);
+    m_ordering.reset(new FunctionOrdering(m_options.profile));
+    p_program.accept(*m_ordering);
+    m_bounds_checks.reset(
+        new BoundsCheckElimination(m_symbol_manager_ptr, *m_side_effects));
+    p_program.accept(*m_bounds_checks);
+    m_induction_variables.reset(new InductionVariables(
+        m_symbol_manager_ptr,
+        m_options.bounds_check ? m_bounds_checks.get() : nullptr,
+        *m_interchange));
+    p_program.accept(*m_induction_variables);
+    if (m_options.vector) {
+        m_vectorization.reset(new LoopVectorization(
+            m_symbol_manager_ptr,
+            m_options.bounds_check ? m_bounds_checks.get() : nullptr));
+    }
+    m_slot_coloring.reset(
+        new StackSlotColoring(m_symbol_manager_ptr, *m_partial_evaluation));
+    p_program.accept(*m_slot_coloring);
+    if (m_options.bounds_check) {
+        fprintf(stderr,
+                "bounds-check: %zu checks, %zu removed, %zu hoisted out of "
+                "loops\n",
+                m_bounds_checks->getNumOfChecks(),
+                m_bounds_checks->getNumOfRemoved(),
+                m_bounds_checks->getNumOfHoisted());
+    }
+    for (const auto &func_node : p_program.getFuncNodes()) {
+        for (const auto *specialization :
+             m_specialization->getSpecializations(*func_node)) {
+            m_side_effects->addClone(specialization->m_name,
+                                     func_node->getName());
+        }
+    }
 
     m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
         p_program.getSymbolTable());
@@ -76,65 +378,265 @@ void CodeGenerator::visit(ProgramNode &p_program) {
     auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
     for_each(p_program.getDeclNodes().begin(), p_program.getDeclNodes().end(),
              visit_ast_node);
-    emitInstructions(m_output_file.get(), ".section    .text\n"
-                                          "    .align 2\n");
+    emitInstructions(".section    .text\n"
+                     "    .align 2\n");
     for_each(p_program.getFuncNodes().begin(), p_program.getFuncNodes().end(),
              visit_ast_node);
 
-    emitInstructions(m_output_file.get(), kFixedFunctionPrologue, "main",
-                     "main", "main");
-    // start from 8 since 0-4, 4-8 are for return addr, last stack addr
-    m_local_var_offset = kLocalVariableStartOffset;
+    m_current_function = nullptr;
+    m_source_line = p_program.getLocation().line;
+    beginFunction("main");
     const_cast<CompoundStatementNode &>(p_program.getBody()).accept(*this);
-    emitInstructions(m_output_file.get(), kFixedFunctionEpilogue, "main",
-                     "main");
+    if (m_options.profile_generate) {
+        emitProfileDump();
+    }
+    endFunction();
+    printFunctions();
+    if (m_options.profile_generate) {
+        emitProfileTables(p_program);
+    }
+    if (!m_rodata_tables.empty()) {
+        emitInstructions(".section    .rodata\n"
+                         "    .align 2\n");
+        for (const auto &table : m_rodata_tables) {
+            emitInstructions("%s:\n", table.first.c_str());
+            emitWords(table.second);
+        }
+    }
 
     m_context_stack.pop();
     m_symbol_manager_ptr->removeSymbolsFromHashTable(
         p_program.getSymbolTable());
+
+    if (m_options.size_report) {
+        std::unique_ptr<FILE, FileDeleter> size_report_file(
+            fopen(m_size_report_path.c_str(), "w"));
+        assert(size_report_file.get() && "Failed to open size report file");
+        m_size_report.print(size_report_file.get());
+    }
+
+    if (m_options.print_removed) {
+        for (const auto &removed : m_removed_symbols) {
+            fprintf(stderr, "removed %s\n", removed.c_str());
+        }
+    }
+}
+
+void CodeGenerator::emitProfileCounter(const Location &p_location) {
+    const size_t index =
+        m_profile_counters
+            .emplace(std::make_pair(p_location.line, p_location.col),
+                     m_profile_counters.size())
+            .first->second;
+    size_t offset = index * 4;
+    emitInstructions("    la t1, profile.counts\n");
+    if (offset >= 2048) {
+        // out of the range of the 12-bit offset
+        emitInstructions("    li t0, %zu\n"
+                         "    add t1, t1, t0\n",
+                         offset);
+        offset = 0;
+    }
+    emitInstructions("    lw t0, %zu(t1)\n"
+                     "    addi t0, t0, 1\n"
+                     "    sw t0, %zu(t1)\n",
+                     offset, offset);
+}
+
+void CodeGenerator::emitProfileDump() {
+    emitInstructions("    la a0, profile.counts\n"
+                     "    la a1, profile.locations\n"
+                     "    li a2, %zu\n"
+                     "    la a3, profile.path\n"
+                     "    jal ra, dumpProfile\n",
+                     m_profile_counters.size());
+}
+
+// the (line, col) of each counter, and the path of the profile
+void CodeGenerator::emitProfileTables(const ProgramNode &p_program) {
+    std::vector<std::pair<uint32_t, uint32_t>> locations(
+        m_profile_counters.size());
+    for (const auto &counter : m_profile_counters) {
+        locations[counter.second] = counter.first;
+    }
+
+    emitInstructions(".comm profile.counts, %zu, 4\n"
+                     ".section    .rodata\n"
+                     "    .align 2\n"
+                     "profile.locations:\n",
+                     locations.size() * 4);
+    for (const auto &location : locations) {
+        emitInstructions("    .word %u, %u\n", location.first,
+                         location.second);
+    }
+    emitInstructions("profile.path:\n"
+                     "    .string \"%s.profile\"\n",
+                     p_program.getNameCString());
+}
+
+void CodeGenerator::emitWords(const std::vector<int32_t> &p_values) {
+    constexpr size_t kWordsPerLine = 8;
+    constexpr size_t kMinZeroRun = 4;
+
+    size_t i = 0;
+    while (i < p_values.size()) {
+        size_t end = i;
+        while (end < p_values.size() && p_values[end] == 0) {
+            ++end;
+        }
+        if (end - i >= kMinZeroRun || end == p_values.size()) {
+            emitInstructions("    .zero %zu\n", (end - i) * 4);
+            i = end;
+            continue;
+        }
+
+        emitInstructions("    .word %d", p_values[i]);
+        for (end = i + 1; end < std::min(i + kWordsPerLine, p_values.size());
+             ++end) {
+            emitInstructions(", %d", p_values[end]);
+        }
+        emitInstructions("\n");
+        i = end;
+    }
+}
+
+void CodeGenerator::emitPartialEvaluationResults(
+    const CompoundStatementNode &p_body) {
+    // a few calls are shorter than a loop over a table
+    constexpr size_t kMaxUnrolledPrints = 8;
+
+    const auto &output = m_partial_evaluation->getOutput();
+    if (output.size() <= kMaxUnrolledPrints) {
+        for (const auto value : output) {
+            emitInstructions("    li a0, %d\n"
+                             "    jal ra, printInt\n",
+                             value);
+        }
+    } else {
+        // the pointer is kept in a slot across the calls
+        const auto slot = allocateTemporarySlot();
+        const auto loop_label = m_label_sequence++;
+        m_rodata_tables.emplace_back("peval.output", output);
+        emitInstructions("    la t0, peval.output\n");
+        emitFrameAccess("sw", "t0", slot);
+        emitInstructions("L%zu:\n"
+                         "    lw a0, 0(t0)\n"
+                         "    jal ra, printInt\n",
+                         loop_label);
+        emitFrameAccess("lw", "t0", slot);
+        emitInstructions("    addi t0, t0, 4\n");
+        emitFrameAccess("sw", "t0", slot);
+        emitInstructions("    la t1, peval.output\n"
+                         "    li t2, %zu\n"
+                         "    add t1, t1, t2\n"
+                         "    bne t0, t1, L%zu\n",
+                         output.size() * 4, loop_label);
+    }
+
+    for (const auto &decl : p_body.getDeclNodes()) {
+        for (const auto &var_node : decl->getVariables()) {
+            const auto *entry_ptr =
+                m_symbol_manager_ptr->lookup(var_node->getName());
+            std::vector<int32_t> values;
+            if (!m_partial_evaluation->getValues(entry_ptr, values)) {
+                continue;
+            }
+            const auto offset = m_local_var_offset_map[entry_ptr];
+            if (values.size() == 1) {
+                emitInstructions("    li t0, %d\n", values[0]);
+                emitFrameAccess("sw", "t0", offset);
+                continue;
+            }
+
+            // copied from its image in .rodata, from the first element up
+            const auto loop_label = m_label_sequence++;
+            m_rodata_tables.emplace_back("peval." + var_node->getName(),
+                                         values);
+            emitInstructions("    la t0, peval.%s\n",
+                             var_node->getNameCString());
+            emitFrameAddress("t1", offset);
+            emitInstructions("    li t2, %zu\n"
+                             "    add t2, t0, t2\n"
+                             "L%zu:\n"
+                             "    lw a1, 0(t0)\n"
+                             "    sw a1, 0(t1)\n"
+                             "    addi t0, t0, 4\n"
+                             "    addi t1, t1, 4\n"
+                             "    bne t0, t2, L%zu\n",
+                             values.size() * 4, loop_label, loop_label);
+        }
+    }
 }
 
 void CodeGenerator::visit(DeclNode &p_decl) { p_decl.visitChildNodes(*this); }
 
+namespace {
+
+// bytes of the elements of an array with p_dimensions after p_num_of_indices
+// indices: the whole array for none, a word for all of them
+uint64_t getElementSize(const std::vector<uint64_t> &p_dimensions,
+                        const size_t p_num_of_indices) {
+    uint64_t size = 4;
+    for (size_t i = p_num_of_indices; i < p_dimensions.size(); ++i) {
+        size *= p_dimensions[i];
+    }
+    return size;
+}
+
+} // namespace
+
 void CodeGenerator::visit(VariableNode &p_variable) {
-    assert(p_variable.getTypePtr()->isInteger() &&
+    assert(p_variable.getTypePtr()->isPrimitiveInteger() &&
            "cannot handle non-integer variable");
 
-    const auto *constant_ptr = p_variable.getConstantPtr();
+    // constants are substituted as immediates at every use (see
+    // VariableReferenceNode), and P can't take the address of a variable, so
+    // no storage is needed for them
+    if (p_variable.getConstantPtr()) {
+        return;
+    }
+
     if (isInGlobal(m_context_stack)) {
-        if (constant_ptr) {
-            emitInstructions(
-                m_output_file.get(),
-                ".section    .rodata\n"
-                "    .align 2\n"
-                "    .globl %s\n"
-                "    .type %s, @object\n"
-                "%s:\n"
-                "    .word %d\n",
-                p_variable.getNameCString(), p_variable.getNameCString(),
-                p_variable.getNameCString(), constant_ptr->integer());
-        } else {
-            emitInstructions(m_output_file.get(), ".comm %s, 4, 4\n",
+        if (!m_call_graph->isReferenced(
+                m_symbol_manager_ptr->lookup(p_variable.getName()))) {
+            m_removed_symbols.push_back(std::string("variable '") +
+                                        p_variable.getName() + "'");
+            return;
+        }
+        // initialized with the results of the statements evaluated at
+        // compile time, unless they're all zeros
+        std::vector<int32_t> values;
+        if (m_partial_evaluation->getValues(
+                m_symbol_manager_ptr->lookup(p_variable.getName()), values) &&
+            std::any_of(values.begin(), values.end(),
+                        [](const int32_t p_value) { return p_value != 0; })) {
+            emitInstructions(".section    .data\n"
+                             "    .align 2\n"
+                             "%s:\n",
                              p_variable.getNameCString());
+            emitWords(values);
+            return;
         }
+        emitInstructions(".comm %s, %zu, 4\n", p_variable.getNameCString(),
+                         static_cast<size_t>(getElementSize(
+                             p_variable.getTypePtr()->getDimensions(), 0)));
         return;
     }
 
     if (isInLocal(m_context_stack)) {
-        m_local_var_offset_map.emplace(
-            std::piecewise_construct,
-            std::forward_as_tuple(
-                m_symbol_manager_ptr->lookup(p_variable.getName())),
-            std::forward_as_tuple(m_local_var_offset));
-
-        if (constant_ptr) {
-            emitInstructions(m_output_file.get(),
-                             "    li t0, %d\n"
-                             "    sw t0, -%u(s0)\n",
-                             constant_ptr->integer(), m_local_var_offset);
-        }
-
-        m_local_var_offset += 4;
+        // an array parameter is passed by reference, and a local array takes
+        // the slots up from its first element
+        const auto *entry_ptr =
+            m_symbol_manager_ptr->lookup(p_variable.getName());
+        const uint64_t size =
+            (entry_ptr->getKind() == SymbolEntry::KindEnum::kParameterKind)
+                ? 4
+                : getElementSize(p_variable.getTypePtr()->getDimensions(), 0);
+
+        // a function is generated again for each of its specializations
+        m_local_var_offset_map[entry_ptr] = kLocalVariableStartOffset +
+                                            m_slot_coloring->getOffset(entry_ptr) +
+                                            size - 4;
 
         return;
     }
@@ -144,17 +646,19 @@ void CodeGenerator::visit(VariableNode &p_variable) {
 }
 
 void CodeGenerator::visit(ConstantValueNode &p_constant_value) {
-    emitInstructions(m_output_file.get(),
-                     "    li t0, %d\n"
+    emitInstructions("    li t0, %" PRId64 "\n"
                      "    addi sp, sp, -4\n"
                      "    sw t0, 0(sp)\n",
                      p_constant_value.getConstantPtr()->integer());
 }
 
 void CodeGenerator::storeArgumentsToParameters(
-    const FunctionNode::DeclNodes &p_parameters) {
+    const FunctionNode::DeclNodes &p_parameters,
+    const FunctionSpecialization::Specialization *p_specialization) {
     constexpr size_t kNumOfArgumentRegister = 8;
     size_t index = 0;
+    // the bound parameters aren't passed
+    size_t arg_index = 0;
 
     for (const auto &parameter : p_parameters) {
         for (const auto &var_node_ptr : parameter->getVariables()) {
@@ -164,15 +668,20 @@ void CodeGenerator::storeArgumentsToParameters(
             assert(search != m_local_var_offset_map.end() &&
                    "Should have been defined before use");
 
-            if (index < kNumOfArgumentRegister) {
-                emitInstructions(m_output_file.get(), "    sw a%u, -%u(s0)\n",
-                                 index, search->second);
+            int32_t value = 0;
+            if (p_specialization &&
+                p_specialization->getConstantArgument(index, value)) {
+                emitInstructions("    li t0, %d\n", value);
+                emitFrameAccess("sw", "t0", search->second);
+            } else if (arg_index < kNumOfArgumentRegister) {
+                const auto reg = "a" + std::to_string(arg_index);
+                emitFrameAccess("sw", reg.c_str(), search->second);
+                ++arg_index;
             } else {
-                emitInstructions(m_output_file.get(),
-                                 "    lw t0, %u(s0)\n"
-                                 "    sw t0, -%u(s0)\n",
-                                 4 * (index - kNumOfArgumentRegister),
-                                 search->second);
+                emitInstructions("    lw t0, %zu(s0)\n",
+                                 4 * (arg_index - kNumOfArgumentRegister));
+                emitFrameAccess("sw", "t0", search->second);
+                ++arg_index;
             }
             ++index;
         }
@@ -180,27 +689,67 @@ void CodeGenerator::storeArgumentsToParameters(
 }
 
 void CodeGenerator::visit(FunctionNode &p_function) {
+    if (!m_call_graph->isReachable(p_function)) {
+        m_removed_symbols.push_back(std::string("function '") +
+                                    p_function.getName() + "'");
+        return;
+    }
+
+    if (m_specialization->isFullySpecialized(p_function)) {
+        m_removed_symbols.push_back(std::string("function '") +
+                                    p_function.getName() +
+                                    "' (replaced by its specializations)");
+    } else {
+        generateFunction(p_function, nullptr);
+    }
+
+    for (const auto *specialization :
+         m_specialization->getSpecializations(p_function)) {
+        generateFunction(p_function, specialization);
+    }
+}
+
+// p_specialization binds some parameters to constants; nullptr for the
+// original function
+void CodeGenerator::generateFunction(
+    FunctionNode &p_function,
+    const FunctionSpecialization::Specialization *p_specialization) {
+    const char *name = p_specialization ? p_specialization->m_name.c_str()
+                                        : p_function.getNameCString();
+
+    // only the recursive functions recompute the same results repeatedly
+    const bool memoized = m_options.auto_memoize && !p_specialization &&
+                          m_side_effects->isRecursive(p_function) &&
+                          m_memoization->begin(*this, p_function);
+
     m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
         p_function.getSymbolTable());
     m_context_stack.push(CodegenContext::kLocal);
 
-    emitInstructions(m_output_file.get(), kFixedFunctionPrologue,
-                     p_function.getNameCString(), p_function.getNameCString(),
-                     p_function.getNameCString());
-
-    // start from 8 since 0-4, 4-8 are for return addr, last stack addr
-    m_local_var_offset = kLocalVariableStartOffset;
+    m_current_function = &p_function;
+    m_source_line = p_function.getLocation().line;
+    beginFunction(name);
+    if (m_options.profile_generate) {
+        // the body is visited without the compound statement itself
+        emitProfileCounter(p_function.getLocation());
+    }
 
     auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
     for_each(p_function.getParameters().begin(),
              p_function.getParameters().end(), visit_ast_node);
 
-    storeArgumentsToParameters(p_function.getParameters());
+    storeArgumentsToParameters(p_function.getParameters(), p_specialization);
 
-    p_function.visitBodyChildNodes(*this);
+    if (memoized) {
+        m_memoization->emitLookup(*this, p_function);
+    }
 
-    emitInstructions(m_output_file.get(), kFixedFunctionEpilogue,
-                     p_function.getNameCString(), p_function.getNameCString());
+    // the body shares the scope of the parameters
+    if (p_function.hasBody()) {
+        generateStatements(p_function.getBody());
+    }
+
+    endFunction();
 
     m_context_stack.pop();
     m_symbol_manager_ptr->removeSymbolsFromHashTable(
@@ -212,111 +761,176 @@ void CodeGenerator::visit(CompoundStatementNode &p_compound_statement) {
         p_compound_statement.getSymbolTable());
     m_context_stack.push(CodegenContext::kLocal);
 
-    p_compound_statement.visitChildNodes(*this);
+    if (m_options.profile_generate) {
+        emitProfileCounter(p_compound_statement.getLocation());
+    }
+    generateStatements(p_compound_statement);
 
     m_context_stack.pop();
     m_symbol_manager_ptr->removeSymbolsFromHashTable(
         p_compound_statement.getSymbolTable());
 }
 
+void CodeGenerator::generateStatements(
+    const CompoundStatementNode &p_compound_statement) {
+    auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
+    for_each(p_compound_statement.getDeclNodes().begin(),
+             p_compound_statement.getDeclNodes().end(), visit_ast_node);
+    if (m_partial_evaluation->isEvaluatedBody(p_compound_statement)) {
+        emitPartialEvaluationResults(p_compound_statement);
+    }
+
+    const auto source_line = m_source_line;
+    for (const auto &stmt_node : p_compound_statement.getStmtNodes()) {
+        m_source_line = stmt_node->getLocation().line;
+        if (m_partial_evaluation->isEvaluated(*stmt_node)) {
+            m_removed_symbols.push_back(
+                "statement at " +
+                std::to_string(stmt_node->getLocation().line) + ":" +
+                std::to_string(stmt_node->getLocation().col) +
+                " (evaluated at compile time)");
+            continue;
+        }
+
+        auto *call_ptr = dynamic_cast<FunctionInvocationNode *>(stmt_node.get());
+        if (!call_ptr) {
+            stmt_node->accept(*this);
+            continue;
+        }
+
+        // function call statement: the result is unused
+        if (m_side_effects->isRemovable(*call_ptr)) {
+            continue;
+        }
+        call_ptr->accept(*this);
+        emitInstructions("    addi sp, sp, 4\n");
+    }
+    m_source_line = source_line;
+}
+
 void CodeGenerator::visit(PrintNode &p_print) {
     m_ref_to_value = true;
     p_print.visitChildNodes(*this);
 
-    emitInstructions(m_output_file.get(), "    lw a0, 0(sp)\n"
-                                          "    addi sp, sp, 4\n"
-                                          "    jal ra, printInt\n");
+    emitInstructions("    lw a0, 0(sp)\n"
+                     "    addi sp, sp, 4\n"
+                     "    jal ra, printInt\n");
+}
+
+void CodeGenerator::emitComparisonBranch(const char *p_op,
+                                         const char *p_inverse_op) {
+    if (m_comp_branch_next_label == m_comp_branch_true_label) {
+        emitInstructions("    %s t1, t0, L%zu\n", p_inverse_op,
+                         m_comp_branch_false_label);
+    } else if (m_comp_branch_next_label == m_comp_branch_false_label) {
+        emitInstructions("    %s t1, t0, L%zu\n", p_op,
+                         m_comp_branch_true_label);
+    } else {
+        emitInstructions("    %s t1, t0, L%zu\n"
+                         "    j L%zu\n",
+                         p_op, m_comp_branch_true_label,
+                         m_comp_branch_false_label);
+    }
 }
 
 void CodeGenerator::visit(BinaryOperatorNode &p_bin_op) {
+    // a derived induction variable is stepped along with the loop variable
+    const ForNode *loop = nullptr;
+    int32_t stride = 0;
+    if (m_induction_variables->getDerived(p_bin_op, loop, stride)) {
+        auto search = m_induction_var_offset_map.find({loop, stride});
+        assert(search != m_induction_var_offset_map.end() &&
+               "Should be inside the loop");
+        emitFrameAccess("lw", "t0", search->second);
+        emitInstructions("    addi sp, sp, -4\n"
+                         "    sw t0, 0(sp)\n");
+        return;
+    }
+
     p_bin_op.visitChildNodes(*this);
 
-    emitInstructions(m_output_file.get(), "    lw t0, 0(sp)\n"
-                                          "    addi sp, sp, 4\n"
-                                          "    lw t1, 0(sp)\n"
-                                          "    addi sp, sp, 4\n");
+    emitInstructions("    lw t0, 0(sp)\n"
+                     "    addi sp, sp, 4\n"
+                     "    lw t1, 0(sp)\n"
+                     "    addi sp, sp, 4\n");
 
     switch (p_bin_op.getOp()) {
     case Operator::kMultiplyOp:
-        emitInstructions(m_output_file.get(), "    mul t0, t1, t0\n");
+        emitInstructions("    mul t0, t1, t0\n");
         break;
     case Operator::kDivideOp:
-        emitInstructions(m_output_file.get(), "    div t0, t1, t0\n");
+        emitInstructions("    div t0, t1, t0\n");
         break;
     case Operator::kModOp:
-        emitInstructions(m_output_file.get(), "    rem t0, t1, t0\n");
+        emitInstructions("    rem t0, t1, t0\n");
         break;
     case Operator::kPlusOp:
-        emitInstructions(m_output_file.get(), "    add t0, t1, t0\n");
+        emitInstructions("    add t0, t1, t0\n");
         break;
     case Operator::kMinusOp:
-        emitInstructions(m_output_file.get(), "    sub t0, t1, t0\n");
+        emitInstructions("    sub t0, t1, t0\n");
         break;
     case Operator::kLessOp:
-        emitInstructions(m_output_file.get(),
-                         "    blt t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("blt", "bge");
         return;
     case Operator::kLessOrEqualOp:
-        emitInstructions(m_output_file.get(),
-                         "    ble t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("ble", "bgt");
         return;
     case Operator::kGreaterOp:
-        emitInstructions(m_output_file.get(),
-                         "    bgt t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("bgt", "ble");
         return;
     case Operator::kGreaterOrEqualOp:
-        emitInstructions(m_output_file.get(),
-                         "    bge t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("bge", "blt");
         return;
     case Operator::kEqualOp:
-        emitInstructions(m_output_file.get(),
-                         "    beq t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("beq", "bne");
         return;
     case Operator::kNotEqualOp:
-        emitInstructions(m_output_file.get(),
-                         "    bne t1, t0, L%u\n"
-                         "    j L%u\n",
-                         m_comp_branch_true_label, m_comp_branch_false_label);
+        emitComparisonBranch("bne", "beq");
         return;
     default:
         assert(false && "unsupported binary operator");
         return;
     }
-    emitInstructions(m_output_file.get(), "    addi sp, sp, -4\n"
-                                          "    sw t0, 0(sp)\n");
+    emitInstructions("    addi sp, sp, -4\n"
+                     "    sw t0, 0(sp)\n");
 }
 
 void CodeGenerator::visit(UnaryOperatorNode &p_un_op) {
     p_un_op.visitChildNodes(*this);
 
-    emitInstructions(m_output_file.get(), "    lw t0, 0(sp)\n"
-                                          "    addi sp, sp, 4\n");
+    emitInstructions("    lw t0, 0(sp)\n"
+                     "    addi sp, sp, 4\n");
 
     switch (p_un_op.getOp()) {
     case Operator::kNegOp:
-        emitInstructions(m_output_file.get(), "    sub t0, zero, t0\n");
+        emitInstructions("    sub t0, zero, t0\n");
         break;
     default:
         assert(false && "unsupported unary operator");
         return;
     }
-    emitInstructions(m_output_file.get(), "    addi sp, sp, -4\n"
-                                          "    sw t0, 0(sp)\n");
+    emitInstructions("    addi sp, sp, -4\n"
+                     "    sw t0, 0(sp)\n");
 }
 
 void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
     constexpr size_t kNumOfArgumentRegister = 8;
-    const auto &arguments = p_func_invocation.getArguments();
+
+    // a specialization takes only the arguments that aren't bound
+    const auto *specialization =
+        m_specialization->getSpecialization(p_func_invocation);
+    std::vector<ExpressionNode *> arguments;
+    for (size_t i = 0; i < p_func_invocation.getArguments().size(); ++i) {
+        int32_t value = 0;
+        if (!specialization ||
+            !specialization->getConstantArgument(i, value)) {
+            arguments.push_back(p_func_invocation.getArguments()[i].get());
+        }
+    }
+
+    m_max_outgoing_arguments =
+        std::max(m_max_outgoing_arguments, arguments.size());
 
     m_ref_to_value = true;
     auto visit_ast_node = [&](auto &ast_node) { ast_node->accept(*this); };
@@ -332,84 +946,230 @@ void CodeGenerator::visit(FunctionInvocationNode &p_func_invocation) {
     // RISC-V has a0-a7 for passing arguments
     size_t num_of_a_reg = std::min(kNumOfArgumentRegister, arguments.size());
     for (size_t i = 0; i < num_of_a_reg; ++i) {
-        emitInstructions(m_output_file.get(),
-                         "    lw a%u, 0(sp)\n"
+        emitInstructions("    lw a%zu, 0(sp)\n"
                          "    addi sp, sp, 4\n",
                          num_of_a_reg - i - 1);
     }
 
-    // [kNumOfArgumentRegister, end)
+    // [kNumOfArgumentRegister, end) in reverse order, so that the callee
+    // finds the (kNumOfArgumentRegister + i)-th one at 4 * i(s0)
     if (arguments.size() > kNumOfArgumentRegister) {
-        for_each(std::next(arguments.begin(), kNumOfArgumentRegister),
-                 arguments.end(), visit_ast_node);
+        for_each(arguments.rbegin(),
+                 std::prev(arguments.rend(), kNumOfArgumentRegister),
+                 visit_ast_node);
     }
 
-    emitInstructions(m_output_file.get(), "    jal ra, %s\n",
-                     p_func_invocation.getNameCString());
+    emitInstructions("    jal ra, %s\n",
+                     specialization ? specialization->m_name.c_str()
+                                    : p_func_invocation.getNameCString());
 
     // restore the stack if necessary
     if (arguments.size() > kNumOfArgumentRegister) {
-        emitInstructions(m_output_file.get(), "    addi sp, sp, %u\n",
+        emitInstructions("    addi sp, sp, %zu\n",
                          4 * (arguments.size() - kNumOfArgumentRegister));
     }
 
-    emitInstructions(m_output_file.get(), "    mv t0, a0\n"
-                                          "    addi sp, sp, -4\n"
-                                          "    sw t0, 0(sp)\n");
+    emitInstructions("    mv t0, a0\n"
+                     "    addi sp, sp, -4\n"
+                     "    sw t0, 0(sp)\n");
 }
 
 void CodeGenerator::visit(VariableReferenceNode &p_variable_ref) {
-    // Haven't supported array reference
     const auto *entry_ptr =
         m_symbol_manager_ptr->lookup(p_variable_ref.getName());
     auto search = m_local_var_offset_map.find(entry_ptr);
-    if (search == m_local_var_offset_map.end()) {
+    if (!entry_ptr->getTypePtr()->getDimensions().empty()) {
+        assert(m_ref_to_value && "Arrays are assigned element by element");
+        emitElementAddress(p_variable_ref);
+        // a subarray is passed by its address
+        if (p_variable_ref.getIndices().size() ==
+            entry_ptr->getTypePtr()->getDimensions().size()) {
+            emitInstructions("    lw t0, 0(t0)\n");
+        }
+    } else if (entry_ptr->getKind() ==
+               SymbolEntry::KindEnum::kConstantKind) {
+        assert(m_ref_to_value && "Constants can't be assigned");
+        emitInstructions("    li t0, %" PRId64 "\n",
+                         entry_ptr->getAttribute().constant()->integer());
+    } else if (search == m_local_var_offset_map.end()) {
         // global variable reference
-        emitInstructions(m_output_file.get(), "    la t0, %s\n",
-                         p_variable_ref.getNameCString());
+        emitInstructions("    la t0, %s\n", p_variable_ref.getNameCString());
+        if (m_ref_to_value) {
+            emitInstructions("    lw t0, 0(t0)\n");
+        }
+    } else if (m_ref_to_value) {
+        // local variable reference: access the frame slot directly so that
+        // FrameSlotForwarding can track it
+        emitFrameAccess("lw", "t0", search->second);
+    } else {
+        emitFrameAddress("t0", search->second);
+    }
+
+    // push onto stack
+    emitInstructions("    addi sp, sp, -4\n"
+                     "    sw t0, 0(sp)\n");
+}
+
+void CodeGenerator::storeToVariable(
+    const VariableReferenceNode &p_variable_ref, const char *p_reg) {
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    auto search = m_local_var_offset_map.find(entry_ptr);
+    if (!entry_ptr->getTypePtr()->getDimensions().empty()) {
+        // the indices may clobber p_reg
+        emitInstructions("    addi sp, sp, -4\n"
+                         "    sw %s, 0(sp)\n",
+                         p_reg);
+        emitElementAddress(p_variable_ref);
+        emitInstructions("    lw t1, 0(sp)\n"
+                         "    addi sp, sp, 4\n"
+                         "    sw t1, 0(t0)\n");
+    } else if (search == m_local_var_offset_map.end()) {
+        // global variable reference
+        emitInstructions("    la t1, %s\n"
+                         "    sw %s, 0(t1)\n",
+                         p_variable_ref.getNameCString(), p_reg);
     } else {
         // local variable reference
-        emitInstructions(m_output_file.get(), "    addi t0, s0, -%u\n",
-                         search->second);
+        emitFrameAccess("sw", p_reg, search->second);
     }
+}
 
-    // dereference to get the value if needed
-    if (m_ref_to_value) {
-        emitInstructions(m_output_file.get(), "    lw t1, 0(t0)\n"
-                                              "    mv t0, t1\n");
+void CodeGenerator::emitElementAddress(
+    const VariableReferenceNode &p_variable_ref) {
+    // stepped along with a for loop, once its value before the loop is
+    // computed
+    const ForNode *loop = nullptr;
+    size_t index = 0;
+    if (m_induction_variables->getElementPointer(p_variable_ref, loop, index)) {
+        auto search = m_element_pointer_offset_map.find({loop, index});
+        if (search != m_element_pointer_offset_map.end()) {
+            emitFrameAccess("lw", "t0", search->second);
+            return;
+        }
     }
 
-    // push onto stack
-    emitInstructions(m_output_file.get(), "    addi sp, sp, -4\n"
-                                          "    sw t0, 0(sp)\n");
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    const auto &dimensions = entry_ptr->getTypePtr()->getDimensions();
+    const auto &indices = p_variable_ref.getIndices();
+
+    // row-major: ((i0 * d1 + i1) * d2 + ...) elements of the size left by
+    // the indices
+    for (size_t i = 0; i < indices.size(); ++i) {
+        m_ref_to_value = true;
+        indices[i]->accept(*this);
+        if (m_options.bounds_check &&
+            m_bounds_checks->isChecked(p_variable_ref, i)) {
+            emitInstructions("    lw t0, 0(sp)\n");
+            emitBoundsCheck(dimensions[i], p_variable_ref.getLocation());
+        }
+        if (i == 0) {
+            continue;
+        }
+        emitInstructions("    lw t0, 0(sp)\n"
+                         "    addi sp, sp, 4\n"
+                         "    lw t1, 0(sp)\n"
+                         "    addi sp, sp, 4\n"
+                         "    li t2, %u\n"
+                         "    mul t1, t1, t2\n"
+                         "    add t0, t1, t0\n"
+                         "    addi sp, sp, -4\n"
+                         "    sw t0, 0(sp)\n",
+                         static_cast<uint32_t>(dimensions[i]));
+    }
+    if (!indices.empty()) {
+        const auto element_size = getElementSize(dimensions, indices.size());
+        emitInstructions("    lw t0, 0(sp)\n"
+                         "    addi sp, sp, 4\n");
+        if ((element_size & (element_size - 1)) == 0) {
+            unsigned shift = 0;
+            while ((uint64_t(1) << shift) < element_size) {
+                ++shift;
+            }
+            emitInstructions("    slli t0, t0, %u\n", shift);
+        } else {
+            emitInstructions("    li t1, %u\n"
+                             "    mul t0, t0, t1\n",
+                             static_cast<uint32_t>(element_size));
+        }
+    }
+
+    // the address of the first element into t1
+    auto search = m_local_var_offset_map.find(entry_ptr);
+    if (search == m_local_var_offset_map.end()) {
+        emitInstructions("    la t1, %s\n", p_variable_ref.getNameCString());
+    } else if (entry_ptr->getKind() == SymbolEntry::KindEnum::kParameterKind) {
+        emitFrameAccess("lw", "t1", search->second);
+    } else {
+        emitFrameAddress("t1", search->second);
+    }
+
+    if (indices.empty()) {
+        emitInstructions("    mv t0, t1\n");
+    } else {
+        emitInstructions("    add t0, t1, t0\n");
+    }
+}
+
+void CodeGenerator::emitBoundsCheck(const uint64_t p_dimension,
+                                    const Location &p_location) {
+    // a negative index is a large unsigned one
+    const auto trap_label = m_label_sequence++;
+    emitInstructions("    li t1, %u\n"
+                     "    bgeu t0, t1, L%zu\n",
+                     static_cast<uint32_t>(p_dimension), trap_label);
+
+    // boundsError() doesn't return
+    const size_t begin = m_machine_function->getInstructions().size();
+    emitInstructions("L%zu:\n"
+                     "    li a0, %u\n"
+                     "    li a1, %u\n"
+                     "    jal ra, boundsError\n",
+                     trap_label, p_location.line, p_location.col);
+    moveToColdSection(begin);
+}
+
+void CodeGenerator::emitHoistedBoundsChecks(const AstNode &p_loop) {
+    if (!m_options.bounds_check) {
+        return;
+    }
+    for (const auto &check : m_bounds_checks->getHoistedChecks(p_loop)) {
+        loadExpression(*check.m_index);
+        emitBoundsCheck(check.m_dimension, check.m_location);
+    }
 }
 
 void CodeGenerator::visit(AssignmentNode &p_assignment) {
-    m_ref_to_value = false;
-    const_cast<VariableReferenceNode &>(p_assignment.getLvalue()).accept(*this);
     m_ref_to_value = true;
     const_cast<ExpressionNode &>(p_assignment.getExpr()).accept(*this);
 
-    emitInstructions(m_output_file.get(), "    lw t0, 0(sp)\n"
-                                          "    addi sp, sp, 4\n"
-                                          "    lw t1, 0(sp)\n"
-                                          "    addi sp, sp, 4\n"
-                                          "    sw t0, 0(t1)\n");
+    emitInstructions("    lw t0, 0(sp)\n"
+                     "    addi sp, sp, 4\n");
+    storeToVariable(p_assignment.getLvalue(), "t0");
 }
 
 void CodeGenerator::visit(ReadNode &p_read) {
-    m_ref_to_value = false; 
-    p_read.visitChildNodes(*this);
-    
-    emitInstructions(
-        m_output_file.get(),
-        "    jal ra, readInt\n"
-        "    lw t0, 0(sp)\n"
-        "    addi sp, sp, 4\n"
-        "    sw a0, 0(t0)\n");
+    emitInstructions("    jal ra, readInt\n");
+    storeToVariable(p_read.getTarget(), "a0");
 }
 
 void CodeGenerator::visit(IfNode &p_if) {
+    auto search = m_unswitched_arms.find(&p_if);
+    if (search != m_unswitched_arms.end()) {
+        if (search->second) {
+            const_cast<CompoundStatementNode &>(p_if.getIfBody()).accept(*this);
+        } else if (p_if.getElseBodyPtr()) {
+            const_cast<CompoundStatementNode *>(p_if.getElseBodyPtr())
+                ->accept(*this);
+        }
+        return;
+    }
+
+    if (m_compare_chains->lower(*this, p_if)) {
+        return;
+    }
+
     const auto if_body_label = m_label_sequence;
     ++m_label_sequence;
 
@@ -419,60 +1179,276 @@ void CodeGenerator::visit(IfNode &p_if) {
     const auto out_label = m_label_sequence;
     ++m_label_sequence;
 
+    // the arm the profile tells is taken more often falls through, and an
+    // arm never taken while the other is moves out to .text.unlikely
+    const auto &profile = m_options.profile;
+    const auto &if_body = p_if.getIfBody();
+    bool if_cold = profile.isCold(if_body.getLocation());
+    bool else_cold =
+        else_body_ptr && profile.isCold(else_body_ptr->getLocation());
+    if (if_cold && else_cold) {
+        if_cold = else_cold = false;
+    }
+    uint64_t if_count = 0;
+    uint64_t else_count = 0;
+    const bool else_first =
+        if_cold ||
+        (else_body_ptr && !else_cold &&
+         profile.getCount(if_body.getLocation(), if_count) &&
+         profile.getCount(else_body_ptr->getLocation(), else_count) &&
+         else_count > if_count);
+
     m_comp_branch_true_label = if_body_label;
     m_comp_branch_false_label = (else_body_ptr) ? else_body_label : out_label;
+    m_comp_branch_next_label =
+        else_first ? m_comp_branch_false_label : if_body_label;
     m_ref_to_value = true;
     const_cast<ExpressionNode &>(p_if.getCondition()).accept(*this);
 
-    emitInstructions(m_output_file.get(), "L%u:\n", if_body_label);
-    const_cast<CompoundStatementNode &>(p_if.getIfBody()).accept(*this);
+    // either arm is assumed to be taken half of the time
+    const auto generate_arm = [&](const CompoundStatementNode &p_body) {
+        generateScaled(0.5, [&]() {
+            const_cast<CompoundStatementNode &>(p_body).accept(*this);
+        });
+    };
+
+    if (if_cold) {
+        generateColdArm(if_body, if_body_label, out_label);
+        if (else_body_ptr) {
+            emitInstructions("L%zu:\n", else_body_label);
+            const_cast<CompoundStatementNode *>(else_body_ptr)->accept(*this);
+        }
+        emitInstructions("L%zu:\n", out_label);
+        return;
+    }
 
-    if (else_body_ptr) {
+    if (else_first) {
+        emitInstructions("L%zu:\n", else_body_label);
+        generate_arm(*else_body_ptr);
+        emitInstructions("    j L%zu\n"
+                         "L%zu:\n",
+                         out_label, if_body_label);
+        generate_arm(if_body);
+        emitInstructions("L%zu:\n", out_label);
+        return;
+    }
+
+    emitInstructions("L%zu:\n", if_body_label);
+    if (else_cold) {
+        const_cast<CompoundStatementNode &>(if_body).accept(*this);
+        generateColdArm(*else_body_ptr, else_body_label, out_label);
+    } else if (else_body_ptr) {
+        generate_arm(if_body);
         // TODO: cannot handle nested compound statements
-        emitInstructions(m_output_file.get(),
-                         "    j L%u\n"
-                         "L%u:\n",
+        emitInstructions("    j L%zu\n"
+                         "L%zu:\n",
                          out_label, else_body_label);
-        const_cast<CompoundStatementNode *>(else_body_ptr)->accept(*this);
+        generate_arm(*else_body_ptr);
+    } else {
+        generate_arm(if_body);
     }
-    emitInstructions(m_output_file.get(), "L%u:\n", out_label);
+    emitInstructions("L%zu:\n", out_label);
 }
 
-void CodeGenerator::visit(WhileNode &p_while) {
-    const auto while_head_label = m_label_sequence;
-    const auto while_body_label = m_label_sequence + 1;
-    const auto while_out_label = m_label_sequence + 2;
+void CodeGenerator::generateColdArm(const CompoundStatementNode &p_body,
+                                    const size_t p_label,
+                                    const size_t p_out_label) {
+    const size_t begin = m_machine_function->getInstructions().size();
+    emitInstructions("L%zu:\n", p_label);
+    // the profile tells it's never taken
+    generateScaled(0, [&]() {
+        const_cast<CompoundStatementNode &>(p_body).accept(*this);
+        emitInstructions("    j L%zu\n", p_out_label);
+    });
+
+    // the arms nested in it have been moved out already
+    moveToColdSection(begin);
+}
+
+void CodeGenerator::moveToColdSection(const size_t p_begin) {
+    auto &insts = m_machine_function->getInstructions();
+    m_cold_instructions.insert(
+        m_cold_instructions.end(),
+        std::make_move_iterator(insts.begin() + p_begin),
+        std::make_move_iterator(insts.end()));
+    insts.erase(insts.begin() + p_begin, insts.end());
+}
+
+void CodeGenerator::unswitchLoop(
+    const AstNode &p_loop, const size_t p_index,
+    const std::function<void()> &p_generate_loop) {
+    const auto &unswitched_ifs = m_unswitching->getUnswitchedIfs(p_loop);
+    if (p_index == unswitched_ifs.size()) {
+        p_generate_loop();
+        return;
+    }
+
+    const auto *if_ptr = unswitched_ifs[p_index];
+    const auto true_label = m_label_sequence;
+    const auto false_label = m_label_sequence + 1;
+    const auto out_label = m_label_sequence + 2;
     m_label_sequence += 3;
 
-    emitInstructions(m_output_file.get(), "L%u:\n", while_head_label);
-    m_comp_branch_true_label = while_body_label;
-    m_comp_branch_false_label = while_out_label;
+    m_comp_branch_true_label = true_label;
+    m_comp_branch_false_label = false_label;
+    m_comp_branch_next_label = true_label;
     m_ref_to_value = true;
-    const_cast<ExpressionNode &>(p_while.getCondition()).accept(*this);
+    const_cast<ExpressionNode &>(if_ptr->getCondition()).accept(*this);
+
+    // either copy is assumed to run half of the time
+    emitInstructions("L%zu:\n", true_label);
+    m_unswitched_arms[if_ptr] = true;
+    generateScaled(0.5, [&]() {
+        unswitchLoop(p_loop, p_index + 1, p_generate_loop);
+        emitInstructions("    j L%zu\n", out_label);
+    });
+    emitInstructions("L%zu:\n", false_label);
+    m_unswitched_arms[if_ptr] = false;
+    generateScaled(0.5, [&]() {
+        unswitchLoop(p_loop, p_index + 1, p_generate_loop);
+    });
+    emitInstructions("L%zu:\n", out_label);
+    m_unswitched_arms.erase(if_ptr);
+}
+
+void CodeGenerator::visit(WhileNode &p_while) {
+    unswitchLoop(p_while, 0, [&]() { generateWhile(p_while); });
+}
 
-    emitInstructions(m_output_file.get(), "L%u:\n", while_body_label);
-    const_cast<CompoundStatementNode &>(p_while.getBody()).accept(*this);
-    // TODO: cannot handle nested compound statements
-    emitInstructions(m_output_file.get(),
-                     "    j L%u\n"
-                     "L%u:\n",
-                     while_head_label, while_out_label);
+// rotated into a do-while: the entry test guards the body, which ends with
+// the same test branching back to its top
+void CodeGenerator::generateWhile(WhileNode &p_while) {
+    const auto while_body_label = m_label_sequence;
+    const auto while_out_label = m_label_sequence + 1;
+    m_label_sequence += 2;
+
+    // the entry test falls through to the body, and the one at the bottom
+    // out of the loop
+    auto emit_condition = [&](const size_t p_next_label) {
+        m_comp_branch_true_label = while_body_label;
+        m_comp_branch_false_label = while_out_label;
+        m_comp_branch_next_label = p_next_label;
+        m_ref_to_value = true;
+        const_cast<ExpressionNode &>(p_while.getCondition()).accept(*this);
+    };
+
+    emit_condition(while_body_label);
+    emitHoistedBoundsChecks(p_while);
+    emitInstructions("%s"
+                     "L%zu:\n",
+                     kLoopHeadAlignment, while_body_label);
+    // the trip count isn't known, so a fixed one is assumed
+    generateScaled(m_options.while_trip_count, [&]() {
+        const_cast<CompoundStatementNode &>(p_while.getBody()).accept(*this);
+        emit_condition(while_out_label);
+    });
+    emitInstructions("L%zu:\n", while_out_label);
 }
 
 void CodeGenerator::visit(ForNode &p_for) {
+    unswitchLoop(p_for, 0, [&]() { generateFor(p_for); });
+}
+
+void CodeGenerator::generateFor(ForNode &p_for) {
     m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
         p_for.getSymbolTable());
     m_context_stack.push(CodegenContext::kLocal);
 
-    const_cast<DeclNode &>(p_for.getLoopVarDecl()).accept(*this);
-    const_cast<AssignmentNode &>(p_for.getLoopVarInitStmt()).accept(*this);
+    // the body runs at least once
+    emitHoistedBoundsChecks(p_for);
+    const auto local_var_offset = m_local_var_offset;
+
+    const auto generate_loop = [&](ForNode &p_loop,
+                                   const CompoundStatementNode &p_body) {
+        auto tile = m_tile_offset_map.find(&p_loop);
+        if (tile != m_tile_offset_map.end()) {
+            generateForLoop(
+                p_loop,
+                [&]() {
+                    const_cast<CompoundStatementNode &>(p_body).accept(*this);
+                },
+                tile->second);
+            return;
+        }
+        if (m_vectorization &&
+            m_vectorization->generate(*this, p_loop, p_body)) {
+            return;
+        }
+        generateForLoop(p_loop, [&]() {
+            const_cast<CompoundStatementNode &>(p_body).accept(*this);
+        });
+    };
+
+    if (m_interchange->isInterchanged(p_for)) {
+        // the inner loop goes outside, and the outer loop runs its body
+        auto &inner = const_cast<ForNode &>(
+            *LoopInterchange::getInnerLoop(p_for));
+        m_symbol_manager_ptr->reconstructHashTableFromSymbolTable(
+            inner.getSymbolTable());
+        generateForLoop(inner, [&]() {
+            // the checks hoisted out of the inner loop depend on the
+            // variable of the outer one
+            emitHoistedBoundsChecks(inner);
+            generate_loop(p_for, inner.getBody());
+        });
+        m_symbol_manager_ptr->removeSymbolsFromHashTable(
+            inner.getSymbolTable());
+    } else if (m_interchange->isTiled(p_for)) {
+        // the loop over the tiles of the inner loop goes outside
+        const auto &inner = *LoopInterchange::getInnerLoop(p_for);
+        const auto tile_size = m_interchange->getTileSize();
+        const auto lower_bound =
+            inner.getLowerBound().getConstantPtr()->integer();
+        const auto upper_bound =
+            inner.getUpperBound().getConstantPtr()->integer();
+        const auto tile_offset = allocateTemporarySlot();
+        const auto tile_label = getNewLabel();
+        emitInstructions("    li t0, %" PRId64 "\n", lower_bound);
+        emitFrameAccess("sw", "t0", tile_offset);
+        emitInstructions("%s"
+                         "L%zu:\n",
+                         kLoopHeadAlignment, tile_label);
+
+        const auto frequency = m_frequency;
+        m_frequency *= (upper_bound - lower_bound) / tile_size;
+        m_tile_offset_map[&inner] = tile_offset;
+        generate_loop(p_for, p_for.getBody());
+        m_tile_offset_map.erase(&inner);
+        m_frequency = frequency;
+
+        emitFrameAccess("lw", "t0", tile_offset);
+        if (tile_size <= 2047) {
+            emitInstructions("    addi t0, t0, %zu\n", tile_size);
+        } else {
+            emitInstructions("    li t1, %zu\n"
+                             "    add t0, t0, t1\n",
+                             tile_size);
+        }
+        emitFrameAccess("sw", "t0", tile_offset);
+        emitInstructions("    li t1, %" PRId64 "\n"
+                         "    blt t0, t1, L%zu\n",
+                         upper_bound, tile_label);
+    } else {
+        generate_loop(p_for, p_for.getBody());
+    }
 
-    const auto for_head_label = m_label_sequence;
-    const auto for_body_label = m_label_sequence + 1;
-    const auto for_out_label = m_label_sequence + 2;
-    m_label_sequence += 3;
+    m_local_var_offset = local_var_offset;
+    m_context_stack.pop();
+    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+}
+
+void CodeGenerator::generateForLoop(
+    ForNode &p_for, const std::function<void()> &p_generate_body,
+    const size_t p_tile_offset) {
+    const_cast<DeclNode &>(p_for.getLoopVarDecl()).accept(*this);
+    if (!p_tile_offset) {
+        const_cast<AssignmentNode &>(p_for.getLoopVarInitStmt())
+            .accept(*this);
+    }
 
-    emitInstructions(m_output_file.get(), "L%u:\n", for_head_label);
+    const auto for_body_label = m_label_sequence;
+    const auto for_out_label = m_label_sequence + 1;
+    m_label_sequence += 2;
 
     // hand-written comparison
     const auto *entry_ptr =
@@ -480,40 +1456,152 @@ void CodeGenerator::visit(ForNode &p_for) {
     auto search = m_local_var_offset_map.find(entry_ptr);
     assert(search != m_local_var_offset_map.end() &&
            "Should have been defined before use");
-    emitInstructions(m_output_file.get(),
-                     "    lw t1, -%u(s0)\n"
-                     "    li t0, %u\n"
-                     "    blt t1, t0, L%u\n"
-                     "    j L%u\n",
-                     search->second,
-                     p_for.getUpperBound().getConstantPtr()->integer(),
-                     for_body_label, for_out_label);
-
-    emitInstructions(m_output_file.get(), "L%u:\n", for_body_label);
-    const_cast<CompoundStatementNode &>(p_for.getBody()).accept(*this);
-
-    // loop_var += 1 & jump back to head for condition check
-    emitInstructions(m_output_file.get(),
-                     "    lw t0, -%u(s0)\n"
-                     "    li t1, 1\n"
-                     "    add t0, t0, t1\n"
-                     "    sw t0, -%u(s0)\n",
-                     search->second, search->second);
-    // TODO: cannot handle nested compound statements
-    emitInstructions(m_output_file.get(),
-                     "    j L%u\n"
-                     "L%u:\n",
-                     for_head_label, for_out_label);
+    const auto lower_bound = p_for.getLowerBound().getConstantPtr()->integer();
+    const auto upper_bound = p_for.getUpperBound().getConstantPtr()->integer();
+    const int32_t trip_count =
+        p_tile_offset ? static_cast<int32_t>(m_interchange->getTileSize())
+                      : upper_bound - lower_bound;
+    if (p_tile_offset) {
+        // the tile starts from the value in its slot
+        emitFrameAccess("lw", "t0", p_tile_offset);
+        emitFrameAccess("sw", "t0", search->second);
+    }
 
-    m_context_stack.pop();
-    m_symbol_manager_ptr->removeSymbolsFromHashTable(p_for.getSymbolTable());
+    // the body runs at least once, so there's no entry test
+    assert(lower_bound < upper_bound &&
+           "The bounds should have been checked by the semantic analyzer");
+
+    // loop_var * stride starts from lower_bound * stride (wrapping as mul
+    // does)
+    const auto &loop = m_induction_variables->getLoop(p_for);
+    for (const auto stride : loop.m_strides) {
+        const auto offset = allocateTemporarySlot();
+        m_induction_var_offset_map[{&p_for, stride}] = offset;
+        if (p_tile_offset) {
+            emitFrameAccess("lw", "t0", p_tile_offset);
+            emitInstructions("    li t1, %d\n"
+                             "    mul t0, t0, t1\n",
+                             stride);
+        } else {
+            emitInstructions("    li t0, %d\n",
+                             static_cast<int32_t>(
+                                 static_cast<uint32_t>(lower_bound) *
+                                 static_cast<uint32_t>(stride)));
+        }
+        emitFrameAccess("sw", "t0", offset);
+    }
+    // the element addresses at loop_var == lower_bound
+    for (size_t i = 0; i < loop.m_pointers.size(); ++i) {
+        const auto offset = allocateTemporarySlot();
+        emitElementAddress(*loop.m_pointers[i].m_variable_ref);
+        emitFrameAccess("sw", "t0", offset);
+        m_element_pointer_offset_map[{&p_for, i}] = offset;
+    }
+    // an unused loop variable counts the remaining iterations down instead,
+    // or holds the first element address past the last iteration
+    if (!loop.m_counter_used && !loop.m_pointers.empty()) {
+        emitInstructions("    li t1, %d\n"
+                         "    add t0, t0, t1\n",
+                         static_cast<int32_t>(
+                             static_cast<uint32_t>(trip_count) *
+                             static_cast<uint32_t>(
+                                 loop.m_pointers.back().m_stride)));
+        emitFrameAccess("sw", "t0", search->second);
+    } else if (!loop.m_counter_used) {
+        emitInstructions("    li t0, %d\n", trip_count);
+        emitFrameAccess("sw", "t0", search->second);
+    }
+
+    // the body and the latch run for each iteration
+    const auto frequency = m_frequency;
+    m_frequency *= trip_count;
+    emitInstructions("%s"
+                     "L%zu:\n",
+                     kLoopHeadAlignment, for_body_label);
+    p_generate_body();
+
+    for (const auto stride : loop.m_strides) {
+        const auto offset = m_induction_var_offset_map[{&p_for, stride}];
+        emitFrameAccess("lw", "t0", offset);
+        if (stride >= -2048 && stride <= 2047) {
+            emitInstructions("    addi t0, t0, %d\n", stride);
+        } else {
+            emitInstructions("    li t1, %d\n"
+                             "    add t0, t0, t1\n",
+                             stride);
+        }
+        emitFrameAccess("sw", "t0", offset);
+    }
+    for (size_t i = 0; i < loop.m_pointers.size(); ++i) {
+        const auto offset = m_element_pointer_offset_map[{&p_for, i}];
+        const auto stride = loop.m_pointers[i].m_stride;
+        emitFrameAccess("lw", "t0", offset);
+        if (stride <= 2047) {
+            emitInstructions("    addi t0, t0, %d\n", stride);
+        } else {
+            emitInstructions("    li t1, %d\n"
+                             "    add t0, t0, t1\n",
+                             stride);
+        }
+        emitFrameAccess("sw", "t0", offset);
+        // the computation before the loop is needed again if it's generated
+        // again
+        m_element_pointer_offset_map.erase({&p_for, i});
+    }
+
+    if (!loop.m_counter_used && !loop.m_pointers.empty()) {
+        // the last element address stepped is left in t0
+        emitFrameAccess("lw", "t1", search->second);
+        emitInstructions("    bne t0, t1, L%zu\n"
+                         "L%zu:\n",
+                         for_body_label, for_out_label);
+    } else if (!loop.m_counter_used) {
+        emitFrameAccess("lw", "t0", search->second);
+        emitInstructions("    addi t0, t0, -1\n");
+        emitFrameAccess("sw", "t0", search->second);
+        emitInstructions("    bnez t0, L%zu\n"
+                         "L%zu:\n",
+                         for_body_label, for_out_label);
+    } else if (p_tile_offset) {
+        // loop_var += 1 & jump back to the body while it's in the tile
+        emitFrameAccess("lw", "t0", search->second);
+        emitInstructions("    li t1, 1\n"
+                         "    add t0, t0, t1\n");
+        emitFrameAccess("sw", "t0", search->second);
+        emitFrameAccess("lw", "t1", p_tile_offset);
+        emitInstructions("    li t2, %d\n"
+                         "    add t1, t1, t2\n"
+                         "    blt t0, t1, L%zu\n"
+                         "L%zu:\n",
+                         trip_count, for_body_label, for_out_label);
+    } else {
+        // loop_var += 1 & jump back to the body while it's below the bound
+        emitFrameAccess("lw", "t0", search->second);
+        emitInstructions("    li t1, 1\n"
+                         "    add t0, t0, t1\n");
+        emitFrameAccess("sw", "t0", search->second);
+        emitInstructions("    li t1, %" PRId64 "\n"
+                         "    blt t0, t1, L%zu\n"
+                         "L%zu:\n",
+                         upper_bound, for_body_label, for_out_label);
+    }
+    m_frequency = frequency;
+}
+
+void CodeGenerator::loadExpression(const ExpressionNode &p_expr) {
+    m_ref_to_value = true;
+    const_cast<ExpressionNode &>(p_expr).accept(*this);
+    emitInstructions("    lw t0, 0(sp)\n"
+                     "    addi sp, sp, 4\n");
 }
 
 void CodeGenerator::visit(ReturnNode &p_return) {
     m_ref_to_value = true;
     p_return.visitChildNodes(*this);
 
-    emitInstructions(m_output_file.get(), "    lw t0, 0(sp)\n"
-                                          "    addi sp, sp, 4\n"
-                                          "    mv a0, t0\n");
+    emitInstructions("    lw t0, 0(sp)\n"
+                     "    addi sp, sp, 4\n"
+                     "    mv a0, t0\n"
+                     "    j L%zu\n",
+                     m_return_label);
 }
@@ -0,0 +1,195 @@
+#include "codegen/CompareChainLowering.hpp"
+#include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+namespace {
+
+// an if/else chain with fewer branches stays a sequence of comparisons
+constexpr size_t kMinCompareChainCases = 4;
+// a jump table may have at most this many entries, and at least half of them
+// have to be cases
+constexpr int64_t kMaxJumpTableEntries = 1024;
+// the leaves of a binary search compare for equality one by one
+constexpr size_t kMaxLinearSearchCases = 3;
+
+// "variable = constant" or "constant = variable" on a scalar integer
+// variable; nullptr otherwise
+const VariableReferenceNode *
+matchCompareChainCondition(const ExpressionNode &p_condition,
+                           const SymbolManager *p_symbol_manager,
+                           int32_t &p_value) {
+    const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&p_condition);
+    if (!bin_op || bin_op->getOp() != Operator::kEqualOp) {
+        return nullptr;
+    }
+
+    const auto *variable_ref =
+        dynamic_cast<const VariableReferenceNode *>(&bin_op->getLeftOperand());
+    const ExpressionNode *constant = &bin_op->getRightOperand();
+    if (!variable_ref || !getIntegerConstant(*constant, p_symbol_manager,
+                                             p_value)) {
+        variable_ref = dynamic_cast<const VariableReferenceNode *>(
+            &bin_op->getRightOperand());
+        constant = &bin_op->getLeftOperand();
+        if (!variable_ref ||
+            !getIntegerConstant(*constant, p_symbol_manager, p_value)) {
+            return nullptr;
+        }
+    }
+
+    const auto *entry_ptr = p_symbol_manager->lookup(variable_ref->getName());
+    if (!variable_ref->getIndices().empty() ||
+        entry_ptr->getKind() == SymbolEntry::KindEnum::kConstantKind ||
+        !entry_ptr->getTypePtr()->isInteger()) {
+        return nullptr;
+    }
+    return variable_ref;
+}
+
+} // namespace
+
+bool CompareChainLowering::lower(FunctionEmitter &p_emitter,
+                                 IfNode &p_if) const {
+    const VariableReferenceNode *variable_ref = nullptr;
+    const SymbolEntry *variable_entry = nullptr;
+    std::vector<Case> cases;
+    std::set<int32_t> values;
+    const CompoundStatementNode *default_body = nullptr;
+
+    // the else body continues the chain only if it's nothing but another if,
+    // so that no declaration is skipped over
+    for (const IfNode *if_ptr = &p_if;;) {
+        int32_t value = 0;
+        const auto *condition_ref = matchCompareChainCondition(
+            if_ptr->getCondition(), m_symbol_manager_ptr, value);
+        if (!condition_ref ||
+            (variable_entry &&
+             m_symbol_manager_ptr->lookup(condition_ref->getName()) !=
+                 variable_entry) ||
+            values.count(value)) {
+            // the rest of the chain is generated as the default
+            break;
+        }
+        variable_ref = condition_ref;
+        variable_entry = m_symbol_manager_ptr->lookup(condition_ref->getName());
+        values.insert(value);
+        cases.push_back(Case{value, &if_ptr->getIfBody(), 0});
+
+        default_body = if_ptr->getElseBodyPtr();
+        if (!default_body || !default_body->getDeclNodes().empty() ||
+            default_body->getStmtNodes().size() != 1) {
+            break;
+        }
+        if_ptr =
+            dynamic_cast<const IfNode *>(default_body->getStmtNodes()[0].get());
+        if (!if_ptr) {
+            break;
+        }
+    }
+    if (cases.size() < kMinCompareChainCases) {
+        return false;
+    }
+
+    for (auto &compare_case : cases) {
+        compare_case.m_label = p_emitter.getNewLabel();
+    }
+    const auto default_label = p_emitter.getNewLabel();
+    const auto out_label = p_emitter.getNewLabel();
+
+    p_emitter.loadExpression(*variable_ref);
+
+    auto sorted_cases = cases;
+    std::sort(sorted_cases.begin(), sorted_cases.end(),
+              [](const Case &p_lhs, const Case &p_rhs) {
+                  return p_lhs.m_value < p_rhs.m_value;
+              });
+    const int64_t min_value = sorted_cases.front().m_value;
+    const int64_t num_of_entries =
+        static_cast<int64_t>(sorted_cases.back().m_value) - min_value + 1;
+
+    if (num_of_entries <= kMaxJumpTableEntries &&
+        num_of_entries <= 2 * static_cast<int64_t>(cases.size())) {
+        // t0 - min as an unsigned index also rejects the values below min
+        const auto table_label = p_emitter.getNewLabel();
+        if (-min_value >= -2048 && -min_value <= 2047) {
+            if (min_value != 0) {
+                p_emitter.emitInstructions("    addi t0, t0, %d\n",
+                                           static_cast<int32_t>(-min_value));
+            }
+        } else {
+            p_emitter.emitInstructions("    li t1, %d\n"
+                                       "    sub t0, t0, t1\n",
+                                       static_cast<int32_t>(min_value));
+        }
+        p_emitter.emitInstructions("    li t1, %d\n"
+                                   "    bgeu t0, t1, L%zu\n"
+                                   "    slli t0, t0, 2\n"
+                                   "    la t1, L%zu\n"
+                                   "    add t0, t0, t1\n"
+                                   "    lw t0, 0(t0)\n"
+                                   "    jr t0\n",
+                                   static_cast<int32_t>(num_of_entries),
+                                   default_label, table_label);
+
+        std::vector<std::string> targets(num_of_entries,
+                                         "L" + std::to_string(default_label));
+        for (const auto &compare_case : cases) {
+            targets[compare_case.m_value - min_value] =
+                "L" + std::to_string(compare_case.m_label);
+        }
+        p_emitter.getMachineFunction().addJumpTable(
+            "L" + std::to_string(table_label), targets);
+    } else {
+        emitBinarySearch(p_emitter, sorted_cases, 0, sorted_cases.size(),
+                         default_label);
+    }
+
+    // each case, and the default, is assumed to be as likely
+    const double probability = 1.0 / (cases.size() + 1);
+    for (const auto &compare_case : cases) {
+        p_emitter.emitInstructions("L%zu:\n", compare_case.m_label);
+        p_emitter.generateScaled(probability, [&]() {
+            p_emitter.generate(
+                const_cast<CompoundStatementNode &>(*compare_case.m_body));
+            p_emitter.emitInstructions("    j L%zu\n", out_label);
+        });
+    }
+    p_emitter.emitInstructions("L%zu:\n", default_label);
+    if (default_body) {
+        p_emitter.generateScaled(probability, [&]() {
+            p_emitter.generate(
+                const_cast<CompoundStatementNode &>(*default_body));
+        });
+    }
+    p_emitter.emitInstructions("L%zu:\n", out_label);
+    return true;
+}
+
+void CompareChainLowering::emitBinarySearch(
+    FunctionEmitter &p_emitter, const std::vector<Case> &p_cases,
+    const size_t p_begin, const size_t p_end,
+    const size_t p_default_label) const {
+    if (p_end - p_begin <= kMaxLinearSearchCases) {
+        for (size_t i = p_begin; i < p_end; ++i) {
+            p_emitter.emitInstructions("    li t1, %d\n"
+                                       "    beq t0, t1, L%zu\n",
+                                       p_cases[i].m_value, p_cases[i].m_label);
+        }
+        p_emitter.emitInstructions("    j L%zu\n", p_default_label);
+        return;
+    }
+
+    const auto middle = p_begin + (p_end - p_begin) / 2;
+    const auto lower_half_label = p_emitter.getNewLabel();
+    p_emitter.emitInstructions("    li t1, %d\n"
+                               "    blt t0, t1, L%zu\n",
+                               p_cases[middle].m_value, lower_half_label);
+    emitBinarySearch(p_emitter, p_cases, middle, p_end, p_default_label);
+    p_emitter.emitInstructions("L%zu:\n", lower_half_label);
+    emitBinarySearch(p_emitter, p_cases, p_begin, middle, p_default_label);
+}
@@ -0,0 +1,49 @@
+#include "codegen/CycleEstimator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+CycleEstimator::Estimate
+CycleEstimator::run(const MachineFunction &p_function) const {
+    const auto &insts = p_function.getInstructions();
+    Estimate estimate;
+    estimate.m_annotations.resize(insts.size());
+    for (const auto &block : p_function.computeBasicBlocks()) {
+        std::map<std::string, size_t> ready;
+        size_t cycle = 0;
+        double weighted = 0;
+        for (size_t i = block.begin; i < block.end; ++i) {
+            if (!insts[i].isInstruction()) {
+                continue;
+            }
+            size_t issue = cycle;
+            for (const auto &used : insts[i].getUsedRegisters()) {
+                auto search = ready.find(used);
+                if (search != ready.end()) {
+                    issue = std::max(issue, search->second);
+                }
+            }
+            const double cost =
+                (issue + 1 - cycle) * insts[i].getFrequency();
+            cycle = issue + 1;
+            weighted += cost;
+            if (insts[i].getLine()) {
+                estimate.m_lines[insts[i].getLine()] += cost;
+            }
+
+            const auto defined = insts[i].getDefinedRegister();
+            if (!defined.empty()) {
+                ready[defined] = issue + m_latency_model.getLatency(insts[i]);
+            }
+        }
+        estimate.m_cycles += weighted;
+
+        if (cycle) {
+            char annotation[64];
+            snprintf(annotation, sizeof(annotation),
+                     "%zu cycles, %.1f per call", cycle, weighted);
+            estimate.m_annotations[block.begin] = annotation;
+        }
+    }
+    return estimate;
+}
@@ -0,0 +1,340 @@
+#include "codegen/FrameSlotForwarding.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+static constexpr const char *const kFramePointer = "s0";
+
+// return true and set p_slot if the instruction accesses -N(s0) or N(s0)
+static bool getFrameSlot(const MachineInstruction &p_inst, int32_t &p_slot) {
+    if (!p_inst.isLoad() && !p_inst.isStore()) {
+        return false;
+    }
+
+    MemoryOperand mem;
+    if (!parseMemoryOperand(p_inst.getOperands()[1], mem) ||
+        mem.base != kFramePointer) {
+        return false;
+    }
+    p_slot = mem.offset;
+    return true;
+}
+
+static bool isStackAdjustment(const MachineInstruction &p_inst,
+                              const int32_t p_amount) {
+    const auto &operands = p_inst.getOperands();
+    return p_inst.isInstruction() && p_inst.getOpcode() == "addi" &&
+           operands.size() == 3 && operands[0] == "sp" && operands[1] == "sp" &&
+           std::atoi(operands[2].c_str()) == p_amount;
+}
+
+static bool isStackTopAccess(const MachineInstruction &p_inst) {
+    MemoryOperand mem;
+    return (p_inst.isLoad() || p_inst.isStore()) &&
+           p_inst.getOpcode().back() == 'w' &&
+           parseMemoryOperand(p_inst.getOperands()[1], mem) &&
+           mem.base == "sp" && mem.offset == 0;
+}
+
+// ===========================================
+// > SlotState
+// ===========================================
+void FrameSlotForwarding::SlotState::meet(const SlotState &p_other) {
+    decltype(m_reg_holds) reg_holds;
+    std::set_intersection(m_reg_holds.begin(), m_reg_holds.end(),
+                          p_other.m_reg_holds.begin(),
+                          p_other.m_reg_holds.end(),
+                          std::inserter(reg_holds, reg_holds.begin()));
+    m_reg_holds.swap(reg_holds);
+
+    for (auto it = m_copy_of.begin(); it != m_copy_of.end();) {
+        auto search = p_other.m_copy_of.find(it->first);
+        if (search == p_other.m_copy_of.end() ||
+            search->second != it->second) {
+            it = m_copy_of.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FrameSlotForwarding::SlotState::killRegister(const std::string &p_reg) {
+    for (auto it = m_reg_holds.begin(); it != m_reg_holds.end();) {
+        it = (it->first == p_reg) ? m_reg_holds.erase(it) : std::next(it);
+    }
+}
+
+void FrameSlotForwarding::SlotState::killSlot(const int32_t p_slot) {
+    for (auto it = m_reg_holds.begin(); it != m_reg_holds.end();) {
+        it = (it->second == p_slot) ? m_reg_holds.erase(it) : std::next(it);
+    }
+    for (auto it = m_copy_of.begin(); it != m_copy_of.end();) {
+        const bool related = it->first == p_slot || it->second == p_slot;
+        it = related ? m_copy_of.erase(it) : std::next(it);
+    }
+}
+
+// ===========================================
+// > FrameSlotForwarding
+// ===========================================
+void FrameSlotForwarding::run(MachineFunction &p_function) {
+    if (p_function.isFrameAddressEscaped()) {
+        return;
+    }
+
+    foldPushPopPairs(p_function);
+    forwardStoredValues(p_function);
+    removeDeadStores(p_function);
+}
+
+// addi sp, sp, -4 / sw rs, 0(sp) / lw rd, 0(sp) / addi sp, sp, 4 => mv rd, rs
+// addi sp, sp, -4 / sw rs, 0(sp) / addi sp, sp, 4 => (nothing)
+void FrameSlotForwarding::foldPushPopPairs(MachineFunction &p_function) {
+    auto &insts = p_function.getInstructions();
+    std::vector<bool> removed(insts.size(), false);
+
+    for (size_t i = 0; i + 2 < insts.size(); ++i) {
+        if (isStackAdjustment(insts[i], -4) && insts[i + 1].isStore() &&
+            isStackTopAccess(insts[i + 1]) &&
+            isStackAdjustment(insts[i + 2], 4)) {
+            // the value is popped without being used
+            removed[i] = removed[i + 1] = removed[i + 2] = true;
+            i += 2;
+            continue;
+        }
+        if (i + 3 >= insts.size()) {
+            continue;
+        }
+        if (!isStackAdjustment(insts[i], -4) || !insts[i + 1].isStore() ||
+            !isStackTopAccess(insts[i + 1]) || !insts[i + 2].isLoad() ||
+            !isStackTopAccess(insts[i + 2]) ||
+            !isStackAdjustment(insts[i + 3], 4)) {
+            continue;
+        }
+
+        const auto &src = insts[i + 1].getOperands()[0];
+        const auto &dst = insts[i + 2].getOperands()[0];
+        removed[i] = removed[i + 1] = removed[i + 3] = true;
+        if (src == dst) {
+            removed[i + 2] = true;
+        } else {
+            insts[i + 2].rewrite("mv", {dst, src});
+        }
+        i += 3;
+    }
+
+    p_function.removeInstructions(removed);
+}
+
+void FrameSlotForwarding::transfer(const MachineInstruction &p_inst,
+                                   SlotState &p_state) {
+    if (!p_inst.isInstruction()) {
+        return;
+    }
+
+    int32_t slot = 0;
+    if (getFrameSlot(p_inst, slot)) {
+        const auto &reg = p_inst.getOperands()[0];
+        if (p_inst.isLoad()) {
+            p_state.killRegister(reg);
+            p_state.m_reg_holds.emplace(reg, slot);
+            auto search = p_state.m_copy_of.find(slot);
+            if (search != p_state.m_copy_of.end()) {
+                p_state.m_reg_holds.emplace(reg, search->second);
+            }
+            return;
+        }
+
+        // a store makes the slot a copy of whatever the register holds
+        int32_t origin = slot;
+        for (const auto &fact : p_state.m_reg_holds) {
+            if (fact.first == reg && fact.second != slot) {
+                auto search = p_state.m_copy_of.find(fact.second);
+                origin = (search != p_state.m_copy_of.end()) ? search->second
+                                                             : fact.second;
+                break;
+            }
+        }
+        p_state.killSlot(slot);
+        p_state.m_reg_holds.emplace(reg, slot);
+        if (origin != slot) {
+            p_state.m_copy_of[slot] = origin;
+            p_state.m_reg_holds.emplace(reg, origin);
+        }
+        return;
+    }
+
+    if (p_inst.isCall()) {
+        for (auto it = p_state.m_reg_holds.begin();
+             it != p_state.m_reg_holds.end();) {
+            it = isCallerSavedRegister(it->first) ? p_state.m_reg_holds.erase(it)
+                                                  : std::next(it);
+        }
+        return;
+    }
+
+    const auto defined = p_inst.getDefinedRegister();
+    if (defined.empty()) {
+        return;
+    }
+
+    if (p_inst.getOpcode() == "mv") {
+        const auto &src = p_inst.getOperands()[1];
+        std::vector<int32_t> slots;
+        for (const auto &fact : p_state.m_reg_holds) {
+            if (fact.first == src) {
+                slots.push_back(fact.second);
+            }
+        }
+        p_state.killRegister(defined);
+        for (const auto held_slot : slots) {
+            p_state.m_reg_holds.emplace(defined, held_slot);
+        }
+        return;
+    }
+
+    p_state.killRegister(defined);
+}
+
+void FrameSlotForwarding::forwardStoredValues(MachineFunction &p_function) {
+    auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+    if (blocks.empty()) {
+        return;
+    }
+
+    std::vector<SlotState> in_states(blocks.size());
+    std::vector<SlotState> out_states(blocks.size());
+    std::vector<bool> visited(blocks.size(), false);
+
+    auto compute_in_state = [&](const size_t b) {
+        SlotState state;
+        bool first = true;
+        for (const auto pred : blocks[b].predecessors) {
+            if (!visited[pred]) {
+                continue;
+            }
+            if (first) {
+                state = out_states[pred];
+                first = false;
+            } else {
+                state.meet(out_states[pred]);
+            }
+        }
+        // the entry block and blocks only reachable from unvisited ones
+        return state;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            SlotState state = (b == 0) ? SlotState{} : compute_in_state(b);
+            in_states[b] = state;
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+                transfer(insts[i], state);
+            }
+            if (!visited[b] || state != out_states[b]) {
+                visited[b] = true;
+                out_states[b] = state;
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<bool> removed(insts.size(), false);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        SlotState state = in_states[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            MachineInstruction &inst = insts[i];
+            int32_t slot = 0;
+            if (!inst.isLoad() || !getFrameSlot(inst, slot)) {
+                transfer(inst, state);
+                continue;
+            }
+
+            const MachineInstruction original = inst;
+            const auto &dst = inst.getOperands()[0];
+            const std::string *holder = nullptr;
+            for (const auto &fact : state.m_reg_holds) {
+                if (fact.second != slot) {
+                    continue;
+                }
+                if (fact.first == dst) {
+                    holder = &fact.first;
+                    break;
+                }
+                if (!holder) {
+                    holder = &fact.first;
+                }
+            }
+
+            if (holder && *holder == dst) {
+                removed[i] = true;
+            } else if (holder) {
+                inst.rewrite("mv", {dst, *holder});
+            } else {
+                auto search = state.m_copy_of.find(slot);
+                if (search != state.m_copy_of.end()) {
+                    inst.setOperands(
+                        {dst, std::to_string(search->second) + "(" +
+                                  kFramePointer + ")"});
+                }
+            }
+            transfer(original, state);
+        }
+    }
+
+    p_function.removeInstructions(removed);
+}
+
+void FrameSlotForwarding::removeDeadStores(MachineFunction &p_function) {
+    const auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+
+    using LiveSlots = std::set<int32_t>;
+    std::vector<LiveSlots> live_in(blocks.size());
+
+    // walk the block backward; flag the stores to dead slots if requested
+    auto propagate = [&](const size_t b, LiveSlots live,
+                         std::vector<bool> *p_removed) {
+        for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+            int32_t slot = 0;
+            if (!getFrameSlot(insts[i], slot)) {
+                continue;
+            }
+            if (insts[i].isLoad()) {
+                live.insert(slot);
+            } else if (live.erase(slot) == 0 && slot < 0 && p_removed) {
+                (*p_removed)[i] = true;
+            }
+        }
+        return live;
+    };
+
+    auto compute_live_out = [&](const size_t b) {
+        LiveSlots live;
+        for (const auto succ : blocks[b].successors) {
+            live.insert(live_in[succ].begin(), live_in[succ].end());
+        }
+        return live;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            auto live = propagate(b, compute_live_out(b), nullptr);
+            if (live != live_in[b]) {
+                live_in[b].swap(live);
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<bool> removed(insts.size(), false);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        propagate(b, compute_live_out(b), &removed);
+    }
+    p_function.removeInstructions(removed);
+}
@@ -0,0 +1,178 @@
+#include "codegen/InstructionScheduler.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+// the instructions that aren't moved, nor moved across
+static bool isBarrier(const MachineInstruction &p_inst) {
+    return !p_inst.isInstruction() || p_inst.isCall() ||
+           p_inst.isTerminator() || p_inst.getOpcode() == "jr" ||
+           p_inst.getOpcode().front() == 'v';
+}
+
+size_t
+InstructionScheduler::estimateStalls(const MachineFunction &p_function) const {
+    const auto &insts = p_function.getInstructions();
+    size_t stalls = 0;
+    for (const auto &block : p_function.computeBasicBlocks()) {
+        // the operands are assumed to be ready on entry
+        std::map<std::string, size_t> ready;
+        size_t cycle = 0;
+        for (size_t i = block.begin; i < block.end; ++i) {
+            if (!insts[i].isInstruction()) {
+                continue;
+            }
+            size_t issue = cycle;
+            for (const auto &used : insts[i].getUsedRegisters()) {
+                auto search = ready.find(used);
+                if (search != ready.end()) {
+                    issue = std::max(issue, search->second);
+                }
+            }
+            stalls += issue - cycle;
+            cycle = issue + 1;
+
+            const auto defined = insts[i].getDefinedRegister();
+            if (!defined.empty()) {
+                ready[defined] = issue + m_latency_model.getLatency(insts[i]);
+            }
+        }
+    }
+    return stalls;
+}
+
+std::vector<size_t> InstructionScheduler::schedule(
+    const MachineFunction::Instructions &p_insts,
+    const AliasAnalysis &p_alias, const size_t p_begin,
+    const size_t p_end) const {
+    using MemoryLocation = AliasAnalysis::MemoryLocation;
+
+    const size_t size = p_end - p_begin;
+    std::vector<unsigned> latencies(size);
+    std::vector<std::string> defined(size);
+    std::vector<std::vector<std::string>> used(size);
+    for (size_t i = 0; i < size; ++i) {
+        const auto &inst = p_insts[p_begin + i];
+        latencies[i] = m_latency_model.getLatency(inst);
+        defined[i] = inst.getDefinedRegister();
+        used[i] = inst.getUsedRegisters();
+    }
+    auto uses = [&](const size_t p_i, const std::string &p_reg) {
+        return !p_reg.empty() &&
+               std::find(used[p_i].begin(), used[p_i].end(), p_reg) !=
+                   used[p_i].end();
+    };
+
+    // (successor, cycles after the issue of the predecessor)
+    std::vector<std::vector<std::pair<size_t, unsigned>>> successors(size);
+    std::vector<size_t> num_of_preds(size, 0);
+    for (size_t j = 0; j < size; ++j) {
+        const auto &location_j = p_alias.getLocation(p_begin + j);
+        for (size_t i = 0; i < j; ++i) {
+            unsigned latency = 0;
+            if (uses(j, defined[i])) {
+                latency = latencies[i];
+            }
+            // anti- and output dependences only keep the order
+            if (uses(i, defined[j]) ||
+                (!defined[j].empty() && defined[i] == defined[j])) {
+                latency = std::max(latency, 1u);
+            }
+            const auto &location_i = p_alias.getLocation(p_begin + i);
+            if ((p_insts[p_begin + i].isStore() ||
+                 p_insts[p_begin + j].isStore()) &&
+                location_i.m_kind != MemoryLocation::KindEnum::kNone &&
+                location_j.m_kind != MemoryLocation::KindEnum::kNone &&
+                p_alias.alias(location_i, location_j) !=
+                    AliasAnalysis::AliasResult::kNoAlias) {
+                latency = std::max(latency, 1u);
+            }
+            if (latency) {
+                successors[i].emplace_back(j, latency);
+                ++num_of_preds[j];
+            }
+        }
+    }
+
+    // the latency-weighted length of the longest path to the end
+    std::vector<size_t> heights(size);
+    for (size_t i = size; i-- > 0;) {
+        heights[i] = latencies[i];
+        for (const auto &succ : successors[i]) {
+            heights[i] = std::max(heights[i], succ.second + heights[succ.first]);
+        }
+    }
+
+    std::vector<size_t> order;
+    std::vector<size_t> earliest(size, 0);
+    std::vector<bool> scheduled(size, false);
+    size_t cycle = 0;
+    while (order.size() < size) {
+        // the highest of those ready in this cycle, or else the first to be
+        // ready; the earlier in the block on a tie
+        size_t best = size;
+        for (size_t i = 0; i < size; ++i) {
+            if (scheduled[i] || num_of_preds[i]) {
+                continue;
+            }
+            if (best == size) {
+                best = i;
+                continue;
+            }
+            const bool ready = earliest[i] <= cycle;
+            const bool best_ready = earliest[best] <= cycle;
+            if (ready != best_ready) {
+                best = ready ? i : best;
+            } else if (!ready && earliest[i] != earliest[best]) {
+                best = (earliest[i] < earliest[best]) ? i : best;
+            } else if (heights[i] > heights[best]) {
+                best = i;
+            }
+        }
+
+        cycle = std::max(cycle, earliest[best]);
+        scheduled[best] = true;
+        order.push_back(p_begin + best);
+        for (const auto &succ : successors[best]) {
+            earliest[succ.first] =
+                std::max(earliest[succ.first], cycle + succ.second);
+            --num_of_preds[succ.first];
+        }
+        ++cycle;
+    }
+    return order;
+}
+
+InstructionScheduler::StallReport
+InstructionScheduler::run(MachineFunction &p_function) {
+    StallReport report;
+    report.m_before = estimateStalls(p_function);
+
+    const AliasAnalysis alias(p_function);
+    auto &insts = p_function.getInstructions();
+    MachineFunction::Instructions scheduled;
+    scheduled.reserve(insts.size());
+    for (const auto &block : p_function.computeBasicBlocks()) {
+        size_t begin = block.begin;
+        while (begin < block.end) {
+            if (isBarrier(insts[begin])) {
+                scheduled.push_back(insts[begin++]);
+                continue;
+            }
+            size_t end = begin;
+            while (end < block.end && !isBarrier(insts[end])) {
+                ++end;
+            }
+            for (const auto index : schedule(insts, alias, begin, end)) {
+                scheduled.push_back(insts[index]);
+            }
+            begin = end;
+        }
+    }
+    insts.swap(scheduled);
+
+    report.m_after = estimateStalls(p_function);
+    return report;
+}
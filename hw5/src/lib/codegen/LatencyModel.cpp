@@ -0,0 +1,51 @@
+#include "codegen/LatencyModel.hpp"
+
+#include <fstream>
+#include <sstream>
+
+LatencyModel::LatencyModel()
+    : m_latencies{{"default", 1}, {"load", 2}, {"mul", 3}, {"div", 33}} {}
+
+bool LatencyModel::load(const char *const p_path) {
+    std::ifstream file(p_path);
+    if (!file) {
+        return false;
+    }
+
+    std::map<std::string, unsigned> latencies = m_latencies;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string name;
+        if (!(fields >> name)) {
+            continue;
+        }
+        long cycles = 0;
+        std::string rest;
+        if (!(fields >> cycles) || cycles < 1 || (fields >> rest)) {
+            return false;
+        }
+        latencies[name] = static_cast<unsigned>(cycles);
+    }
+    m_latencies.swap(latencies);
+    return true;
+}
+
+unsigned LatencyModel::getLatency(const MachineInstruction &p_inst) const {
+    const auto &op = p_inst.getOpcode();
+    auto search = m_latencies.find(op);
+    if (search != m_latencies.end()) {
+        return search->second;
+    }
+
+    const char *category = "default";
+    if (p_inst.isLoad()) {
+        category = "load";
+    } else if (op == "mul" || op == "mulh" || op == "mulhu" ||
+               op == "mulhsu") {
+        category = "mul";
+    } else if (op == "div" || op == "divu" || op == "rem" || op == "remu") {
+        category = "div";
+    }
+    return m_latencies.at(category);
+}
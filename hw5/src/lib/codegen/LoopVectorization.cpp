@@ -0,0 +1,603 @@
+#include "codegen/LoopVectorization.hpp"
+#include "AST/operator.hpp"
+#include "analysis/IntegerConstant.hpp"
+#include "analysis/Reduction.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstdint>
+#include <map>
+
+namespace {
+
+// the loops with fewer iterations stay scalar
+constexpr int64_t kMinVectorTripCount = 8;
+// v0 is left for the masks, and v1 holds the loop variable of each lane
+constexpr unsigned kNumOfVectorRegisters = 32;
+constexpr unsigned kVectorIndexRegister = 1;
+// lanes of e32 for VLEN of 128 bits, the least that V requires
+constexpr int64_t kMinVectorLanes = 4;
+
+// p_name anywhere in p_expr, including the indices of the elements
+bool referencesVariable(const ExpressionNode &p_expr,
+                        const std::string &p_name) {
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        if (variable_ref->getName() == p_name) {
+            return true;
+        }
+        for (const auto &index : variable_ref->getIndices()) {
+            if (referencesVariable(*index, p_name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return referencesVariable(un_op->getOperand(), p_name);
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        return referencesVariable(bin_op->getLeftOperand(), p_name) ||
+               referencesVariable(bin_op->getRightOperand(), p_name);
+    }
+    return false;
+}
+
+// p_name as a value, besides the indices of the elements
+bool usesVariable(const ExpressionNode &p_expr, const std::string &p_name) {
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        return variable_ref->getIndices().empty() &&
+               variable_ref->getName() == p_name;
+    }
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return usesVariable(un_op->getOperand(), p_name);
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        return usesVariable(bin_op->getLeftOperand(), p_name) ||
+               usesVariable(bin_op->getRightOperand(), p_name);
+    }
+    return false;
+}
+
+// the same constants, variables and operators
+bool isSameExpression(const ExpressionNode &p_first,
+                      const ExpressionNode &p_second,
+                      const SymbolManager *p_symbol_manager) {
+    int32_t first_value = 0;
+    int32_t second_value = 0;
+    if (getIntegerConstant(p_first, p_symbol_manager, first_value)) {
+        return getIntegerConstant(p_second, p_symbol_manager, second_value) &&
+               first_value == second_value;
+    }
+    if (const auto *first_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_first)) {
+        const auto *second_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_second);
+        if (!second_ref || first_ref->getName() != second_ref->getName() ||
+            first_ref->getIndices().size() !=
+                second_ref->getIndices().size()) {
+            return false;
+        }
+        for (size_t i = 0; i < first_ref->getIndices().size(); ++i) {
+            if (!isSameExpression(*first_ref->getIndices()[i],
+                                  *second_ref->getIndices()[i],
+                                  p_symbol_manager)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (const auto *first_op =
+            dynamic_cast<const UnaryOperatorNode *>(&p_first)) {
+        const auto *second_op =
+            dynamic_cast<const UnaryOperatorNode *>(&p_second);
+        return second_op && first_op->getOp() == second_op->getOp() &&
+               isSameExpression(first_op->getOperand(),
+                                second_op->getOperand(), p_symbol_manager);
+    }
+    if (const auto *first_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_first)) {
+        const auto *second_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_second);
+        return second_op && first_op->getOp() == second_op->getOp() &&
+               isSameExpression(first_op->getLeftOperand(),
+                                second_op->getLeftOperand(),
+                                p_symbol_manager) &&
+               isSameExpression(first_op->getRightOperand(),
+                                second_op->getRightOperand(),
+                                p_symbol_manager);
+    }
+    return false;
+}
+
+// an upper bound of the registers that emitExpression uses
+unsigned getVectorRegisterDemand(const ExpressionNode &p_expr) {
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return getVectorRegisterDemand(un_op->getOperand());
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        return std::max({getVectorRegisterDemand(bin_op->getLeftOperand()),
+                         getVectorRegisterDemand(bin_op->getRightOperand()) +
+                             1,
+                         2u});
+    }
+    return 1;
+}
+
+const char *getVectorOpcode(const Operator p_op) {
+    switch (p_op) {
+    case Operator::kPlusOp:
+        return "vadd";
+    case Operator::kMinusOp:
+        return "vsub";
+    case Operator::kMultiplyOp:
+        return "vmul";
+    case Operator::kDivideOp:
+        return "vdiv";
+    case Operator::kModOp:
+        return "vrem";
+    default:
+        assert(false && "Should have been checked by isVectorizable");
+        return "";
+    }
+}
+
+} // namespace
+
+bool LoopVectorization::isInvariant(const ExpressionNode &p_expr,
+                                    const Body &p_body) const {
+    if (dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+        return true;
+    }
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        if (variable_ref->getName() == p_body.m_loop_var) {
+            return false;
+        }
+        const auto *entry_ptr =
+            m_symbol_manager_ptr->lookup(variable_ref->getName());
+        if (variable_ref->getIndices().empty()) {
+            return p_body.m_reduced.count(entry_ptr) == 0;
+        }
+        // nor any array that may be one written
+        for (const auto *written : p_body.m_written) {
+            const auto *written_entry =
+                m_symbol_manager_ptr->lookup(written->getName());
+            if (written_entry == entry_ptr ||
+                written_entry->getKind() ==
+                    SymbolEntry::KindEnum::kParameterKind ||
+                entry_ptr->getKind() ==
+                    SymbolEntry::KindEnum::kParameterKind) {
+                return false;
+            }
+        }
+        for (const auto &index : variable_ref->getIndices()) {
+            if (!isInvariant(*index, p_body)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return isInvariant(un_op->getOperand(), p_body);
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        return isInvariant(bin_op->getLeftOperand(), p_body) &&
+               isInvariant(bin_op->getRightOperand(), p_body);
+    }
+    // function invocations
+    return false;
+}
+
+bool LoopVectorization::isContiguous(
+    const VariableReferenceNode &p_variable_ref, const Body &p_body) const {
+    const auto *entry_ptr =
+        m_symbol_manager_ptr->lookup(p_variable_ref.getName());
+    const auto &indices = p_variable_ref.getIndices();
+    if (!entry_ptr->getTypePtr()->isPrimitiveInteger() || indices.empty() ||
+        indices.size() != entry_ptr->getTypePtr()->getDimensions().size()) {
+        return false;
+    }
+    if (m_bounds_checks) {
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (m_bounds_checks->isChecked(p_variable_ref, i)) {
+                return false;
+            }
+        }
+    }
+    for (size_t i = 0; i + 1 < indices.size(); ++i) {
+        if (!isInvariant(*indices[i], p_body)) {
+            return false;
+        }
+    }
+
+    // loop variable, loop variable +/- constant or constant + loop variable
+    const auto is_loop_var = [&](const ExpressionNode &p_expr) {
+        const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr);
+        return variable_ref && variable_ref->getName() == p_body.m_loop_var;
+    };
+    const auto &last = *indices.back();
+    if (is_loop_var(last)) {
+        return true;
+    }
+    const auto *bin_op = dynamic_cast<const BinaryOperatorNode *>(&last);
+    if (!bin_op) {
+        return false;
+    }
+    int32_t constant = 0;
+    const auto op = bin_op->getOp();
+    return (op == Operator::kPlusOp &&
+            getIntegerConstant(bin_op->getLeftOperand(),
+                               m_symbol_manager_ptr, constant) &&
+            is_loop_var(bin_op->getRightOperand())) ||
+           ((op == Operator::kPlusOp || op == Operator::kMinusOp) &&
+            is_loop_var(bin_op->getLeftOperand()) &&
+            getIntegerConstant(bin_op->getRightOperand(),
+                               m_symbol_manager_ptr, constant));
+}
+
+bool LoopVectorization::isVectorizable(const ExpressionNode &p_expr,
+                                       const Body &p_body) const {
+    if (!p_expr.getInferredType() || !p_expr.getInferredType()->isInteger()) {
+        return false;
+    }
+
+    if (dynamic_cast<const ConstantValueNode *>(&p_expr)) {
+        return true;
+    }
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        const auto *entry_ptr =
+            m_symbol_manager_ptr->lookup(variable_ref->getName());
+        if (variable_ref->getIndices().empty()) {
+            return variable_ref->getName() == p_body.m_loop_var ||
+                   p_body.m_reduced.count(entry_ptr) == 0;
+        }
+        for (const auto *written : p_body.m_written) {
+            const auto *written_entry =
+                m_symbol_manager_ptr->lookup(written->getName());
+            if (written_entry == entry_ptr) {
+                // the element written in the same iteration
+                return isSameExpression(*variable_ref, *written,
+                                        m_symbol_manager_ptr);
+            }
+            if (written_entry->getKind() ==
+                    SymbolEntry::KindEnum::kParameterKind ||
+                entry_ptr->getKind() ==
+                    SymbolEntry::KindEnum::kParameterKind) {
+                return false;
+            }
+        }
+        return isContiguous(*variable_ref, p_body) ||
+               isInvariant(*variable_ref, p_body);
+    }
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        return un_op->getOp() == Operator::kNegOp &&
+               isVectorizable(un_op->getOperand(), p_body);
+    }
+    if (const auto *bin_op =
+            dynamic_cast<const BinaryOperatorNode *>(&p_expr)) {
+        switch (bin_op->getOp()) {
+        case Operator::kPlusOp:
+        case Operator::kMinusOp:
+        case Operator::kMultiplyOp:
+        case Operator::kDivideOp:
+        case Operator::kModOp:
+            return isVectorizable(bin_op->getLeftOperand(), p_body) &&
+                   isVectorizable(bin_op->getRightOperand(), p_body);
+        default:
+            return false;
+        }
+    }
+    // function invocations
+    return false;
+}
+
+bool LoopVectorization::getStatements(
+    const ForNode &p_for, const CompoundStatementNode &p_body,
+    std::vector<Statement> &p_statements) const {
+    const auto trip_count =
+        static_cast<int64_t>(p_for.getUpperBound().getConstantPtr()->integer()) -
+        p_for.getLowerBound().getConstantPtr()->integer();
+    if (trip_count < kMinVectorTripCount || !p_body.getDeclNodes().empty() ||
+        p_body.getStmtNodes().empty()) {
+        return false;
+    }
+
+    // the variables reduced and the elements written first, which the
+    // values may not depend on
+    Body body{p_for.getLoopVarName(), {}, {}};
+    std::vector<const AssignmentNode *> assignments;
+    for (const auto &stmt : p_body.getStmtNodes()) {
+        const auto *assignment =
+            dynamic_cast<const AssignmentNode *>(stmt.get());
+        if (!assignment) {
+            return false;
+        }
+        const auto &target = assignment->getLvalue();
+        const auto *entry_ptr = m_symbol_manager_ptr->lookup(target.getName());
+        if (!entry_ptr ||
+            (entry_ptr->getKind() != SymbolEntry::KindEnum::kVariableKind &&
+             entry_ptr->getKind() != SymbolEntry::KindEnum::kParameterKind) ||
+            !entry_ptr->getTypePtr()->isPrimitiveInteger()) {
+            return false;
+        }
+        assignments.push_back(assignment);
+        if (target.getIndices().empty()) {
+            if (!entry_ptr->getTypePtr()->isScalar()) {
+                return false;
+            }
+            body.m_reduced.insert(entry_ptr);
+            continue;
+        }
+        const auto written = std::find_if(
+            body.m_written.begin(), body.m_written.end(),
+            [&](const VariableReferenceNode *p_written) {
+                return p_written->getName() == target.getName();
+            });
+        if (written == body.m_written.end()) {
+            body.m_written.push_back(&target);
+        } else if (!isSameExpression(target, **written,
+                                     m_symbol_manager_ptr)) {
+            return false;
+        }
+    }
+
+    const auto is_term = [&](const ExpressionNode &p_expr) {
+        return isVectorizable(p_expr, body);
+    };
+    std::vector<Statement> statements;
+    for (const auto *assignment : assignments) {
+        const auto &target = assignment->getLvalue();
+        if (target.getIndices().empty()) {
+            Reduction reduction;
+            if (!getReduction(*assignment, is_term, reduction)) {
+                return false;
+            }
+            statements.push_back(Statement{reduction.m_target, nullptr,
+                                           std::move(reduction.m_terms)});
+            continue;
+        }
+        if (!isContiguous(target, body) || !is_term(target) ||
+            !is_term(assignment->getExpr())) {
+            return false;
+        }
+        statements.push_back(Statement{&target, &assignment->getExpr(), {}});
+    }
+
+    // one accumulator for each variable, and the temporaries above them
+    unsigned demand = 0;
+    for (const auto &statement : statements) {
+        if (statement.m_value) {
+            demand =
+                std::max(demand, getVectorRegisterDemand(*statement.m_value));
+        }
+        for (const auto &term : statement.m_terms) {
+            demand = std::max(demand, getVectorRegisterDemand(*term.first));
+        }
+    }
+    if (kVectorIndexRegister + 1 + body.m_reduced.size() + demand >
+        kNumOfVectorRegisters) {
+        return false;
+    }
+    p_statements.swap(statements);
+    return true;
+}
+
+unsigned LoopVectorization::emitExpression(FunctionEmitter &p_emitter,
+                                           const ExpressionNode &p_expr,
+                                           const std::string &p_loop_var,
+                                           const unsigned p_reg) const {
+    // the same value in every lane
+    if (!referencesVariable(p_expr, p_loop_var)) {
+        p_emitter.loadExpression(p_expr);
+        p_emitter.emitInstructions("    vmv.v.x v%u, t0\n", p_reg);
+        return p_reg;
+    }
+
+    if (const auto *variable_ref =
+            dynamic_cast<const VariableReferenceNode *>(&p_expr)) {
+        if (variable_ref->getIndices().empty()) {
+            return kVectorIndexRegister;
+        }
+        // the elements of the lanes follow the one of the first lane
+        p_emitter.emitElementAddress(*variable_ref);
+        p_emitter.emitInstructions("    vle32.v v%u, (t0)\n", p_reg);
+        return p_reg;
+    }
+
+    if (const auto *un_op = dynamic_cast<const UnaryOperatorNode *>(&p_expr)) {
+        const auto operand = emitExpression(p_emitter, un_op->getOperand(),
+                                            p_loop_var, p_reg);
+        p_emitter.emitInstructions("    vrsub.vx v%u, v%u, zero\n", p_reg,
+                                   operand);
+        return p_reg;
+    }
+
+    const auto &bin_op = dynamic_cast<const BinaryOperatorNode &>(p_expr);
+    const auto &left = bin_op.getLeftOperand();
+    const auto &right = bin_op.getRightOperand();
+    const auto *opcode = getVectorOpcode(bin_op.getOp());
+    if (!referencesVariable(right, p_loop_var)) {
+        const auto left_reg =
+            emitExpression(p_emitter, left, p_loop_var, p_reg);
+        p_emitter.loadExpression(right);
+        p_emitter.emitInstructions("    %s.vx v%u, v%u, t0\n", opcode, p_reg,
+                                   left_reg);
+        return p_reg;
+    }
+    if (referencesVariable(left, p_loop_var)) {
+        const auto left_reg =
+            emitExpression(p_emitter, left, p_loop_var, p_reg);
+        const auto right_reg =
+            emitExpression(p_emitter, right, p_loop_var, p_reg + 1);
+        p_emitter.emitInstructions("    %s.vv v%u, v%u, v%u\n", opcode, p_reg,
+                                   left_reg, right_reg);
+        return p_reg;
+    }
+
+    // scalar op vector
+    const auto right_reg = emitExpression(p_emitter, right, p_loop_var, p_reg);
+    p_emitter.loadExpression(left);
+    switch (bin_op.getOp()) {
+    case Operator::kPlusOp:
+    case Operator::kMultiplyOp:
+        p_emitter.emitInstructions("    %s.vx v%u, v%u, t0\n", opcode, p_reg,
+                                   right_reg);
+        break;
+    case Operator::kMinusOp:
+        p_emitter.emitInstructions("    vrsub.vx v%u, v%u, t0\n", p_reg,
+                                   right_reg);
+        break;
+    default:
+        p_emitter.emitInstructions("    vmv.v.x v%u, t0\n"
+                                   "    %s.vv v%u, v%u, v%u\n",
+                                   p_reg + 1, opcode, p_reg, p_reg + 1,
+                                   right_reg);
+        break;
+    }
+    return p_reg;
+}
+
+bool LoopVectorization::generate(FunctionEmitter &p_emitter, ForNode &p_for,
+                                 const CompoundStatementNode &p_body) const {
+    std::vector<Statement> statements;
+    if (!getStatements(p_for, p_body, statements)) {
+        return false;
+    }
+
+    p_emitter.generate(const_cast<DeclNode &>(p_for.getLoopVarDecl()));
+    p_emitter.generate(
+        const_cast<AssignmentNode &>(p_for.getLoopVarInitStmt()));
+
+    const auto &loop_var = p_for.getLoopVarName();
+    const auto index_offset = p_emitter.getLocalVariableOffset(
+        m_symbol_manager_ptr->lookup(loop_var));
+    const auto lower_bound = p_for.getLowerBound().getConstantPtr()->integer();
+    const auto upper_bound = p_for.getUpperBound().getConstantPtr()->integer();
+    assert(lower_bound < upper_bound &&
+           "The bounds should have been checked by the semantic analyzer");
+
+    // the iterations left
+    const auto remaining_offset = p_emitter.allocateTemporarySlot();
+    p_emitter.emitInstructions("    li t0, %" PRId64 "\n",
+                               upper_bound - lower_bound);
+    p_emitter.emitFrameAccess("sw", "t0", remaining_offset);
+
+    // the loop variable holds the iteration of the first lane if the
+    // elements are addressed from it, and v1 the one of each lane if it's
+    // used as a value
+    bool index_used = false;
+    bool counter_used = false;
+    const auto note_uses = [&](const ExpressionNode &p_expr) {
+        index_used |= usesVariable(p_expr, loop_var);
+        counter_used |= referencesVariable(p_expr, loop_var);
+    };
+    // each lane of an accumulator sums its own iterations; lane 0 starts
+    // from the value of the variable
+    std::map<std::string, unsigned> accumulators;
+    std::vector<const VariableReferenceNode *> targets;
+    for (const auto &statement : statements) {
+        if (statement.m_value) {
+            note_uses(*statement.m_value);
+            counter_used = true;
+            continue;
+        }
+        for (const auto &term : statement.m_terms) {
+            note_uses(*term.first);
+        }
+        const auto &name = statement.m_target->getName();
+        if (accumulators.count(name)) {
+            continue;
+        }
+        const unsigned reg = kVectorIndexRegister + 1 + accumulators.size();
+        if (accumulators.empty()) {
+            p_emitter.emitInstructions(
+                "    vsetvli t0, zero, e32, m1, ta, ma\n");
+        }
+        accumulators.emplace(name, reg);
+        targets.push_back(statement.m_target);
+        p_emitter.loadExpression(*statement.m_target);
+        p_emitter.emitInstructions("    vmv.v.i v%u, 0\n"
+                                   "    vmv.s.x v%u, t0\n",
+                                   reg, reg);
+    }
+    const unsigned first_temporary =
+        kVectorIndexRegister + 1 + accumulators.size();
+
+    // the strips run for each group of kMinVectorLanes iterations at most
+    const auto strips = (upper_bound - lower_bound + kMinVectorLanes - 1) /
+                        kMinVectorLanes;
+    p_emitter.generateScaled(static_cast<double>(strips), [&]() {
+        const auto body_label = p_emitter.getNewLabel();
+        // the lanes past vl keep their sums in the last strip (tail
+        // undisturbed)
+        p_emitter.emitInstructions("%s"
+                                   "L%zu:\n",
+                                   kLoopHeadAlignment, body_label);
+        p_emitter.emitFrameAccess("lw", "t0", remaining_offset);
+        p_emitter.emitInstructions("    vsetvli zero, t0, e32, m1, tu, ma\n");
+        if (index_used) {
+            p_emitter.emitInstructions("    vid.v v%u\n",
+                                       kVectorIndexRegister);
+            p_emitter.emitFrameAccess("lw", "t0", index_offset);
+            p_emitter.emitInstructions("    vadd.vx v%u, v%u, t0\n",
+                                       kVectorIndexRegister,
+                                       kVectorIndexRegister);
+        }
+        for (const auto &statement : statements) {
+            if (statement.m_value) {
+                const auto reg = emitExpression(p_emitter, *statement.m_value,
+                                                loop_var, first_temporary);
+                p_emitter.emitElementAddress(*statement.m_target);
+                p_emitter.emitInstructions("    vse32.v v%u, (t0)\n", reg);
+                continue;
+            }
+            const auto accumulator =
+                accumulators[statement.m_target->getName()];
+            for (const auto &term : statement.m_terms) {
+                const auto reg = emitExpression(p_emitter, *term.first,
+                                                loop_var, first_temporary);
+                p_emitter.emitInstructions("    %s.vv v%u, v%u, v%u\n",
+                                           term.second ? "vsub" : "vadd",
+                                           accumulator, accumulator, reg);
+            }
+        }
+
+        // advance by vl, which the temporaries may have clobbered in t0
+        p_emitter.emitFrameAccess("lw", "t1", remaining_offset);
+        p_emitter.emitInstructions("    vsetvli t0, t1, e32, m1, tu, ma\n"
+                                   "    sub t1, t1, t0\n");
+        p_emitter.emitFrameAccess("sw", "t1", remaining_offset);
+        if (counter_used) {
+            p_emitter.emitFrameAccess("lw", "t1", index_offset);
+            p_emitter.emitInstructions("    add t1, t1, t0\n");
+            p_emitter.emitFrameAccess("sw", "t1", index_offset);
+        }
+        p_emitter.emitFrameAccess("lw", "t0", remaining_offset);
+        p_emitter.emitInstructions("    bnez t0, L%zu\n", body_label);
+    });
+
+    // sum the lanes of each accumulator back into its variable
+    if (!targets.empty()) {
+        p_emitter.emitInstructions("    vsetvli t0, zero, e32, m1, ta, ma\n");
+    }
+    for (const auto *target : targets) {
+        const auto accumulator = accumulators[target->getName()];
+        p_emitter.emitInstructions("    vmv.s.x v%u, zero\n"
+                                   "    vredsum.vs v%u, v%u, v%u\n"
+                                   "    vmv.x.s t0, v%u\n",
+                                   first_temporary, accumulator, accumulator,
+                                   first_temporary, accumulator);
+        p_emitter.storeToVariable(*target, "t0");
+    }
+    return true;
+}
@@ -0,0 +1,431 @@
+#include "codegen/MachineFunction.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <set>
+
+static const std::set<std::string> kLoadOpcodes = {"lw", "lh", "lhu", "lb",
+                                                   "lbu"};
+static const std::set<std::string> kStoreOpcodes = {"sw", "sh", "sb"};
+static const std::set<std::string> kVectorLoadOpcodes = {"vle8.v", "vle16.v",
+                                                         "vle32.v"};
+static const std::set<std::string> kVectorStoreOpcodes = {"vse8.v", "vse16.v",
+                                                          "vse32.v"};
+static const std::set<std::string> kBranchOpcodes = {
+    "beq",  "bne",  "blt",  "bge",  "ble",  "bgt",  "bltu", "bgeu",
+    "bgtu", "bleu", "beqz", "bnez", "blez", "bgez", "bltz", "bgtz"};
+
+static std::string trim(const std::string &p_str) {
+    const auto first = p_str.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    const auto last = p_str.find_last_not_of(" \t");
+    return p_str.substr(first, last - first + 1);
+}
+
+static bool isRegisterName(const std::string &p_name) {
+    static const std::set<std::string> kRegisterNames = {
+        "zero", "ra", "sp", "gp", "tp", "fp", "t0", "t1", "t2", "t3", "t4",
+        "t5",   "t6", "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8",
+        "s9",   "s10", "s11", "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7"};
+    return kRegisterNames.count(p_name) != 0;
+}
+
+bool parseMemoryOperand(const std::string &p_operand, MemoryOperand &p_mem) {
+    const auto lparen = p_operand.find('(');
+    const auto rparen = p_operand.find(')');
+    if (lparen == std::string::npos || rparen == std::string::npos ||
+        rparen < lparen) {
+        return false;
+    }
+
+    const std::string offset = p_operand.substr(0, lparen);
+    char *end = nullptr;
+    p_mem.offset = offset.empty() ? 0 : std::strtol(offset.c_str(), &end, 0);
+    if (end && *end != '\0') {
+        // symbolic offsets like %lo(sym)
+        return false;
+    }
+    p_mem.base = p_operand.substr(lparen + 1, rparen - lparen - 1);
+    return true;
+}
+
+bool parseImmediate(const std::string &p_operand, int32_t &p_imm) {
+    if (p_operand.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    const long long imm = std::strtoll(p_operand.c_str(), &end, 0);
+    if (*end != '\0') {
+        // symbolic immediates like %lo(sym)
+        return false;
+    }
+    p_imm = static_cast<int32_t>(imm);
+    return true;
+}
+
+std::string getRegisterForm(const std::string &p_op) {
+    if (p_op == "addi" || p_op == "andi" || p_op == "ori" || p_op == "xori" ||
+        p_op == "slli" || p_op == "srli" || p_op == "srai") {
+        return p_op.substr(0, p_op.size() - 1);
+    }
+    if (p_op == "slti") {
+        return "slt";
+    }
+    if (p_op == "sltiu") {
+        return "sltu";
+    }
+    return "";
+}
+
+bool isCallerSavedRegister(const std::string &p_reg) {
+    if (p_reg == "ra") {
+        return true;
+    }
+    return p_reg.size() == 2 && (p_reg[0] == 't' || p_reg[0] == 'a') &&
+           std::isdigit(p_reg[1]);
+}
+
+// ===========================================
+// > MachineInstruction
+// ===========================================
+MachineInstruction MachineInstruction::parse(const std::string &p_line) {
+    const std::string line = trim(p_line);
+    assert(!line.empty() && "Shouldn't parse an empty line");
+
+    if (line.back() == ':' && line.find_first_of(" \t") == std::string::npos) {
+        return MachineInstruction(KindEnum::kLabel,
+                                  line.substr(0, line.size() - 1));
+    }
+
+    if (line.front() == '.') {
+        return MachineInstruction(KindEnum::kDirective, line);
+    }
+
+    const auto space = line.find_first_of(" \t");
+    if (space == std::string::npos) {
+        return MachineInstruction(KindEnum::kInstruction, line);
+    }
+
+    Operands operands;
+    std::string rest = line.substr(space + 1);
+    size_t start = 0;
+    while (start <= rest.size()) {
+        auto comma = rest.find(',', start);
+        if (comma == std::string::npos) {
+            comma = rest.size();
+        }
+        operands.emplace_back(trim(rest.substr(start, comma - start)));
+        start = comma + 1;
+    }
+
+    return MachineInstruction(KindEnum::kInstruction, line.substr(0, space),
+                              operands);
+}
+
+bool MachineInstruction::isLoad() const {
+    return isInstruction() && kLoadOpcodes.count(m_opcode);
+}
+
+bool MachineInstruction::isStore() const {
+    return isInstruction() && kStoreOpcodes.count(m_opcode);
+}
+
+bool MachineInstruction::isVectorLoad() const {
+    return isInstruction() && kVectorLoadOpcodes.count(m_opcode);
+}
+
+bool MachineInstruction::isVectorStore() const {
+    return isInstruction() && kVectorStoreOpcodes.count(m_opcode);
+}
+
+bool MachineInstruction::isBranch() const {
+    return isInstruction() && kBranchOpcodes.count(m_opcode);
+}
+
+bool MachineInstruction::isJump() const {
+    return isInstruction() && m_opcode == "j";
+}
+
+bool MachineInstruction::isCall() const {
+    return isInstruction() && (m_opcode == "jal" || m_opcode == "call");
+}
+
+bool MachineInstruction::isIndirectJump() const {
+    return isInstruction() && m_opcode == "jr" && m_operands.size() == 1 &&
+           m_operands[0] != "ra";
+}
+
+bool MachineInstruction::isVectorConfiguration() const {
+    return isInstruction() && m_opcode == "vsetvli";
+}
+
+bool MachineInstruction::isReturn() const {
+    return isInstruction() &&
+           (m_opcode == "ret" ||
+            (m_opcode == "jr" && m_operands.size() == 1 &&
+             m_operands[0] == "ra"));
+}
+
+std::string MachineInstruction::getDefinedRegister() const {
+    if (!isInstruction() || isStore() || isBranch() || isJump() ||
+        isReturn() || m_operands.empty()) {
+        return "";
+    }
+    if (isCall()) {
+        return "ra";
+    }
+    if (m_opcode == "jr") {
+        return "";
+    }
+    return isRegisterName(m_operands[0]) ? m_operands[0] : "";
+}
+
+std::vector<std::string> MachineInstruction::getUsedRegisters() const {
+    std::vector<std::string> used;
+    if (!isInstruction() || isJump() || isCall()) {
+        return used;
+    }
+
+    size_t first = 1;
+    if (isStore() || isBranch() || m_opcode == "jr") {
+        first = 0;
+    }
+
+    for (size_t i = first; i < m_operands.size(); ++i) {
+        MemoryOperand mem;
+        if (isRegisterName(m_operands[i])) {
+            used.emplace_back(m_operands[i]);
+        } else if (parseMemoryOperand(m_operands[i], mem) &&
+                   isRegisterName(mem.base)) {
+            used.emplace_back(mem.base);
+        }
+    }
+    return used;
+}
+
+std::string MachineInstruction::toString() const {
+    switch (m_kind) {
+    case KindEnum::kLabel:
+        return m_opcode + ":";
+    case KindEnum::kDirective:
+        return "    " + m_opcode;
+    case KindEnum::kInstruction:
+    default:
+        break;
+    }
+
+    std::string text = "    " + m_opcode;
+    for (size_t i = 0; i < m_operands.size(); ++i) {
+        text += (i == 0) ? " " : ", ";
+        text += m_operands[i];
+    }
+    return text;
+}
+
+void MachineInstruction::print(FILE *p_out_file) const {
+    std::fprintf(p_out_file, "%s\n", toString().c_str());
+}
+
+// ===========================================
+// > MachineFunction
+// ===========================================
+void MachineFunction::appendAssembly(const std::string &p_text) {
+    size_t start = 0;
+    while (start < p_text.size()) {
+        auto newline = p_text.find('\n', start);
+        if (newline == std::string::npos) {
+            newline = p_text.size();
+        }
+        const std::string line = p_text.substr(start, newline - start);
+        if (!trim(line).empty()) {
+            m_instructions.emplace_back(MachineInstruction::parse(line));
+        }
+        start = newline + 1;
+    }
+}
+
+void MachineFunction::removeInstructions(const std::vector<bool> &p_removed) {
+    assert(p_removed.size() == m_instructions.size() &&
+           "The flags should be one-to-one mapped to the instructions");
+
+    Instructions kept;
+    kept.reserve(m_instructions.size());
+    for (size_t i = 0; i < m_instructions.size(); ++i) {
+        if (!p_removed[i]) {
+            kept.emplace_back(std::move(m_instructions[i]));
+        }
+    }
+    m_instructions.swap(kept);
+
+    // the tables whose indirect jump was unreachable
+    std::set<std::string> referenced;
+    for (const auto &inst : m_instructions) {
+        if (inst.isInstruction()) {
+            referenced.insert(inst.getOperands().begin(),
+                              inst.getOperands().end());
+        }
+    }
+    for (auto it = m_jump_tables.begin(); it != m_jump_tables.end();) {
+        it = referenced.count(it->first) ? std::next(it)
+                                         : m_jump_tables.erase(it);
+    }
+}
+
+MachineFunction::BasicBlocks MachineFunction::computeBasicBlocks() const {
+    BasicBlocks blocks;
+    std::map<std::string, size_t> label_to_block;
+
+    size_t begin = 0;
+    auto close_block = [&](const size_t end) {
+        if (end > begin) {
+            blocks.push_back(MachineBasicBlock{begin, end, {}, {}});
+        }
+        begin = end;
+    };
+
+    for (size_t i = 0; i < m_instructions.size(); ++i) {
+        if (m_instructions[i].isLabel()) {
+            close_block(i);
+            label_to_block[m_instructions[i].getOpcode()] = blocks.size();
+        } else if (m_instructions[i].isTerminator()) {
+            close_block(i + 1);
+        }
+    }
+    close_block(m_instructions.size());
+
+    auto add_edge = [&](const size_t from, const size_t to) {
+        blocks[from].successors.push_back(to);
+        blocks[to].predecessors.push_back(from);
+    };
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const auto &last = m_instructions[blocks[b].end - 1];
+        const bool falls_through =
+            !(last.isJump() || last.isReturn() || last.isIndirectJump());
+
+        if (last.isBranch() || last.isJump()) {
+            auto search = label_to_block.find(last.getTarget());
+            assert(search != label_to_block.end() &&
+                   "Branch to a label outside of the function");
+            add_edge(b, search->second);
+        }
+        if (last.isIndirectJump()) {
+            std::set<size_t> targets;
+            for (const auto &jump_table : m_jump_tables) {
+                for (const auto &target : jump_table.second) {
+                    auto search = label_to_block.find(target);
+                    assert(search != label_to_block.end() &&
+                           "Jump table entry outside of the function");
+                    targets.insert(search->second);
+                }
+            }
+            for (const auto target : targets) {
+                add_edge(b, target);
+            }
+        }
+        if (falls_through && b + 1 < blocks.size()) {
+            add_edge(b, b + 1);
+        }
+    }
+
+    return blocks;
+}
+
+bool MachineFunction::isFrameAddressEscaped() const {
+    for (const auto &inst : m_instructions) {
+        if (!inst.isInstruction()) {
+            continue;
+        }
+
+        const auto &operands = inst.getOperands();
+        MemoryOperand mem;
+        // the elements it accesses aren't at a constant offset
+        if ((inst.isVectorLoad() || inst.isVectorStore()) &&
+            parseMemoryOperand(operands[1], mem) && mem.base == "s0") {
+            return true;
+        }
+        for (size_t i = 0; i < operands.size(); ++i) {
+            if (operands[i] != "s0") {
+                continue;
+            }
+            // the frame pointer is defined in the prologue
+            if (i == 0 && inst.getDefinedRegister() == "s0") {
+                continue;
+            }
+            // the caller's frame pointer is saved in the prologue
+            if (i == 0 && inst.isStore() &&
+                parseMemoryOperand(operands[1], mem) && mem.base == "sp") {
+                continue;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void MachineFunction::printJumpTables(FILE *p_out_file) const {
+    if (m_jump_tables.empty()) {
+        return;
+    }
+
+    std::fprintf(p_out_file, ".section    .rodata\n"
+                             "    .align 2\n");
+    for (const auto &jump_table : m_jump_tables) {
+        std::fprintf(p_out_file, "%s:\n", jump_table.first.c_str());
+        for (const auto &target : jump_table.second) {
+            std::fprintf(p_out_file, "    .word %s\n", target.c_str());
+        }
+    }
+    std::fprintf(p_out_file, ".section    .text\n"
+                             "    .align 2\n");
+}
+
+void MachineFunction::addLineDirectives(const unsigned p_file) {
+    Instructions insts;
+    insts.reserve(m_instructions.size());
+    uint32_t line = 0;
+    for (auto &inst : m_instructions) {
+        if (inst.isDirective() &&
+            inst.getOpcode().find("section") != std::string::npos) {
+            line = 0;
+        }
+        if (inst.isInstruction() && inst.getLine() && inst.getLine() != line) {
+            line = inst.getLine();
+            insts.emplace_back(MachineInstruction::KindEnum::kDirective,
+                               ".loc " + std::to_string(p_file) + " " +
+                                   std::to_string(line));
+            insts.back().setSource(line, inst.getFrequency());
+        }
+        insts.push_back(std::move(inst));
+    }
+    m_instructions.swap(insts);
+}
+
+void MachineFunction::print(FILE *p_out_file) const {
+    for_each(m_instructions.begin(), m_instructions.end(),
+             [&](const auto &p_inst) { p_inst.print(p_out_file); });
+    printJumpTables(p_out_file);
+}
+
+void MachineFunction::print(
+    FILE *p_out_file, const std::vector<std::string> &p_annotations) const {
+    assert(p_annotations.size() == m_instructions.size() &&
+           "The annotations should be one-to-one mapped to the instructions");
+
+    for (size_t i = 0; i < m_instructions.size(); ++i) {
+        const auto text = m_instructions[i].toString();
+        if (p_annotations[i].empty()) {
+            std::fprintf(p_out_file, "%s\n", text.c_str());
+        } else {
+            std::fprintf(p_out_file, "%-32s # %s\n", text.c_str(),
+                         p_annotations[i].c_str());
+        }
+    }
+    printJumpTables(p_out_file);
+}
@@ -0,0 +1,149 @@
+#include "codegen/Memoization.hpp"
+#include "visitor/AstNodeInclude.hpp"
+
+#include <cstdio>
+
+constexpr size_t kNumOfArgumentRegister = 8;
+// a word for the result and a byte for the valid flag
+constexpr size_t kEntrySize = 5;
+
+size_t Memoization::getDimension(const FunctionNode &p_function,
+                                 const char *&p_reason) const {
+    const auto *summary = m_side_effects.getSummary(p_function.getName());
+    if (summary->reads_globals || summary->writes_globals) {
+        p_reason = "accesses globals";
+        return 0;
+    }
+    if (summary->does_io) {
+        p_reason = "does I/O";
+        return 0;
+    }
+    if (summary->calls_unknown) {
+        p_reason = "calls a function without a body";
+        return 0;
+    }
+
+    const auto &parameters = p_function.getParameters();
+    const size_t num_of_args = FunctionNode::getParametersNum(parameters);
+    if (num_of_args == 0 || num_of_args > kNumOfArgumentRegister) {
+        p_reason = "has no or too many arguments";
+        return 0;
+    }
+    bool all_integers = p_function.getTypePtr()->isInteger();
+    for (const auto &parameter : parameters) {
+        for (const auto &var_node : parameter->getVariables()) {
+            // an array is passed by its address
+            all_integers &= var_node->getTypePtr()->isInteger() &&
+                            var_node->getTypePtr()->isScalar();
+        }
+    }
+    if (!all_integers) {
+        p_reason = "has non-integer arguments or result";
+        return 0;
+    }
+
+    // the largest dimension^num_of_args that fits in the budget
+    const size_t max_entries = m_budget / kEntrySize;
+    size_t dimension = 1;
+    for (;;) {
+        size_t entries = 1;
+        for (size_t i = 0; i < num_of_args && entries <= max_entries; ++i) {
+            entries *= dimension + 1;
+        }
+        if (entries > max_entries) {
+            break;
+        }
+        ++dimension;
+    }
+    if (dimension < 2) {
+        p_reason = "doesn't fit in the budget";
+        return 0;
+    }
+    return dimension;
+}
+
+bool Memoization::begin(FunctionEmitter &p_emitter,
+                        const FunctionNode &p_function) {
+    const char *name = p_function.getNameCString();
+    const char *reason = "";
+    m_dimension = getDimension(p_function, reason);
+    if (!m_dimension) {
+        fprintf(stderr, "auto-memoize: '%s' not memoized: %s\n", name, reason);
+        return false;
+    }
+    m_name = p_function.getName();
+
+    const size_t num_of_args =
+        FunctionNode::getParametersNum(p_function.getParameters());
+    size_t entries = 1;
+    for (size_t i = 0; i < num_of_args; ++i) {
+        entries *= m_dimension;
+    }
+    p_emitter.emitInstructions(".comm %s.memo, %zu, 4\n"
+                               ".comm %s.memo.valid, %zu, 1\n",
+                               name, entries * 4, name, entries);
+    fprintf(stderr,
+            "auto-memoize: '%s' memoized for arguments in [0, %zu), %zu "
+            "entries (%zu bytes)\n",
+            name, m_dimension, entries, entries * kEntrySize);
+    return true;
+}
+
+// index = ((a0 * dimension) + a1) * dimension + ..., or -1 if an argument is
+// out of [0, dimension)
+void Memoization::emitLookup(FunctionEmitter &p_emitter,
+                             const FunctionNode &p_function) {
+    const char *name = m_name.c_str();
+    const size_t num_of_args =
+        FunctionNode::getParametersNum(p_function.getParameters());
+    const auto out_of_range_label = p_emitter.getNewLabel();
+    const auto body_label = p_emitter.getNewLabel();
+    m_done_label = p_emitter.getNewLabel();
+
+    m_index_offset = p_emitter.allocateTemporarySlot();
+
+    p_emitter.emitInstructions("    li t1, %zu\n", m_dimension);
+    for (size_t i = 0; i < num_of_args; ++i) {
+        p_emitter.emitInstructions("    bgeu a%zu, t1, L%zu\n", i,
+                                   out_of_range_label);
+    }
+    p_emitter.emitInstructions("    mv t0, a0\n");
+    for (size_t i = 1; i < num_of_args; ++i) {
+        p_emitter.emitInstructions("    mul t0, t0, t1\n"
+                                   "    add t0, t0, a%zu\n",
+                                   i);
+    }
+    p_emitter.emitFrameAccess("sw", "t0", m_index_offset);
+    p_emitter.emitInstructions("    la t1, %s.memo.valid\n"
+                               "    add t1, t1, t0\n"
+                               "    lbu t1, 0(t1)\n"
+                               "    beqz t1, L%zu\n"
+                               "    la t1, %s.memo\n"
+                               "    slli t0, t0, 2\n"
+                               "    add t1, t1, t0\n"
+                               "    lw a0, 0(t1)\n"
+                               "    j L%zu\n"
+                               "L%zu:\n"
+                               "    li t0, -1\n",
+                               name, body_label, name, m_done_label,
+                               out_of_range_label);
+    p_emitter.emitFrameAccess("sw", "t0", m_index_offset);
+    p_emitter.emitInstructions("L%zu:\n", body_label);
+}
+
+void Memoization::end(FunctionEmitter &p_emitter) {
+    const char *name = m_name.c_str();
+    p_emitter.emitFrameAccess("lw", "t0", m_index_offset);
+    p_emitter.emitInstructions("    bltz t0, L%zu\n"
+                               "    la t1, %s.memo.valid\n"
+                               "    add t1, t1, t0\n"
+                               "    li t2, 1\n"
+                               "    sb t2, 0(t1)\n"
+                               "    la t1, %s.memo\n"
+                               "    slli t0, t0, 2\n"
+                               "    add t1, t1, t0\n"
+                               "    sw a0, 0(t1)\n"
+                               "L%zu:\n",
+                               m_done_label, name, name, m_done_label);
+    m_dimension = 0;
+}
@@ -0,0 +1,152 @@
+#include "codegen/RedundantLoadElimination.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using MemoryLocation = AliasAnalysis::MemoryLocation;
+
+// a word of a global at a known offset
+static bool isTracked(const MemoryLocation &p_location) {
+    return p_location.m_kind == MemoryLocation::KindEnum::kGlobal &&
+           p_location.m_offset_known && p_location.m_size == 4;
+}
+
+void RedundantLoadElimination::transfer(const MachineInstruction &p_inst,
+                                        const MemoryLocation &p_location,
+                                        const AliasAnalysis &p_alias,
+                                        Facts &p_facts) {
+    if (!p_inst.isInstruction()) {
+        return;
+    }
+
+    auto kill_if = [&](auto p_predicate) {
+        for (auto it = p_facts.begin(); it != p_facts.end();) {
+            it = p_predicate(*it) ? p_facts.erase(it) : std::next(it);
+        }
+    };
+
+    if (p_inst.isStore() || p_inst.isVectorStore()) {
+        kill_if([&](const Facts::value_type &p_fact) {
+            return p_alias.alias(p_fact.second, p_location) !=
+                   AliasAnalysis::AliasResult::kNoAlias;
+        });
+        if (isTracked(p_location)) {
+            p_facts.emplace(p_inst.getOperands()[0], p_location);
+        }
+        return;
+    }
+
+    if (p_inst.isCall()) {
+        kill_if([&](const Facts::value_type &p_fact) {
+            return isCallerSavedRegister(p_fact.first) ||
+                   p_alias.mayClobber(p_inst, p_fact.second);
+        });
+        return;
+    }
+
+    const auto defined = p_inst.getDefinedRegister();
+    if (defined.empty()) {
+        return;
+    }
+
+    std::vector<MemoryLocation> copied;
+    if (p_inst.getOpcode() == "mv") {
+        for (const auto &fact : p_facts) {
+            if (fact.first == p_inst.getOperands()[1]) {
+                copied.push_back(fact.second);
+            }
+        }
+    }
+    kill_if([&](const Facts::value_type &p_fact) {
+        return p_fact.first == defined;
+    });
+    for (const auto &location : copied) {
+        p_facts.emplace(defined, location);
+    }
+    if (p_inst.isLoad() && isTracked(p_location)) {
+        p_facts.emplace(defined, p_location);
+    }
+}
+
+bool RedundantLoadElimination::run(MachineFunction &p_function) {
+    auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+    if (blocks.empty()) {
+        return false;
+    }
+    const AliasAnalysis alias(p_function, m_side_effects);
+
+    std::vector<Facts> in_states(blocks.size());
+    std::vector<Facts> out_states(blocks.size());
+    std::vector<bool> visited(blocks.size(), false);
+
+    auto compute_in_state = [&](const size_t b) {
+        Facts facts;
+        bool first = true;
+        for (const auto pred : blocks[b].predecessors) {
+            if (!visited[pred]) {
+                continue;
+            }
+            if (first) {
+                facts = out_states[pred];
+                first = false;
+                continue;
+            }
+            Facts common;
+            std::set_intersection(facts.begin(), facts.end(),
+                                  out_states[pred].begin(),
+                                  out_states[pred].end(),
+                                  std::inserter(common, common.begin()));
+            facts.swap(common);
+        }
+        return facts;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            Facts facts = (b == 0) ? Facts{} : compute_in_state(b);
+            in_states[b] = facts;
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+                transfer(insts[i], alias.getLocation(i), alias, facts);
+            }
+            if (!visited[b] || facts != out_states[b]) {
+                visited[b] = true;
+                out_states[b].swap(facts);
+                changed = true;
+            }
+        }
+    }
+
+    bool rewritten = false;
+    std::vector<bool> removed(insts.size(), false);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        Facts facts = in_states[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            const MachineInstruction original = insts[i];
+            const auto &location = alias.getLocation(i);
+            if (original.isLoad() && isTracked(location)) {
+                const auto &dst = original.getOperands()[0];
+                const std::string *holder = nullptr;
+                for (const auto &fact : facts) {
+                    if (fact.second == location &&
+                        (!holder || fact.first == dst)) {
+                        holder = &fact.first;
+                    }
+                }
+                if (holder && *holder == dst) {
+                    removed[i] = true;
+                    rewritten = true;
+                } else if (holder) {
+                    insts[i].rewrite("mv", {dst, *holder});
+                    rewritten = true;
+                }
+            }
+            transfer(original, location, alias, facts);
+        }
+    }
+
+    p_function.removeInstructions(removed);
+    return rewritten;
+}
@@ -0,0 +1,469 @@
+#include "codegen/RvcCompression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+// x8-x15, which the 3-bit register fields encode
+static bool isCompressedRegister(const std::string &p_reg) {
+    static const std::vector<std::string> kRegisters = {
+        "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5"};
+    return std::find(kRegisters.begin(), kRegisters.end(), p_reg) !=
+           kRegisters.end();
+}
+
+static bool fitsSigned(const int32_t p_imm, const int p_bits) {
+    return p_imm >= -(1 << (p_bits - 1)) && p_imm < (1 << (p_bits - 1));
+}
+
+// a multiple of p_scale in [0, p_max]
+static bool fitsScaled(const int32_t p_imm, const int32_t p_scale,
+                       const int32_t p_max) {
+    return p_imm >= 0 && p_imm <= p_max && p_imm % p_scale == 0;
+}
+
+// the operand is a register, not a label or a symbol
+static bool isRegisterOperand(const MachineInstruction &p_inst,
+                              const size_t p_index) {
+    if (p_inst.getOpcode() == "la" && p_index == 1) {
+        return false;
+    }
+    return !((p_inst.isBranch() || p_inst.isJump() || p_inst.isCall()) &&
+             p_index + 1 == p_inst.getOperands().size());
+}
+
+void RvcCompression::renameTemporaries(MachineFunction &p_function) {
+    static const std::vector<std::pair<std::string, std::string>> kRenames = {
+        {"t0", "a5"}, {"t1", "a4"}, {"t2", "a3"}};
+    static const std::vector<std::string> kCallerSavedRegisters = {
+        "ra", "t0", "t1", "t2", "t3", "t4", "t5", "t6",
+        "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7"};
+
+    auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+
+    // a call reads the arguments set before it in its block and clobbers the
+    // caller-saved registers; a return reads the result
+    std::vector<std::set<std::string>> uses(insts.size());
+    std::vector<std::set<std::string>> defs(insts.size());
+    for (const auto &block : blocks) {
+        std::set<std::string> arguments;
+        for (size_t i = block.begin; i < block.end; ++i) {
+            const auto &inst = insts[i];
+            if (inst.isCall()) {
+                uses[i] = std::move(arguments);
+                arguments.clear();
+                defs[i].insert(kCallerSavedRegisters.begin(),
+                               kCallerSavedRegisters.end());
+                continue;
+            }
+            if (inst.isReturn()) {
+                uses[i] = {"a0", "ra"};
+                continue;
+            }
+            const auto used = inst.getUsedRegisters();
+            uses[i].insert(used.begin(), used.end());
+            const auto defined = inst.getDefinedRegister();
+            if (!defined.empty()) {
+                defs[i].insert(defined);
+                if (defined[0] == 'a') {
+                    arguments.insert(defined);
+                }
+            }
+        }
+    }
+
+    std::vector<std::set<std::string>> live_ins(blocks.size());
+    auto get_live_out = [&](const size_t p_block) {
+        std::set<std::string> live;
+        for (const auto succ : blocks[p_block].successors) {
+            live.insert(live_ins[succ].begin(), live_ins[succ].end());
+        }
+        return live;
+    };
+    auto step = [&](const size_t p_index, std::set<std::string> &p_live) {
+        for (const auto &reg : defs[p_index]) {
+            p_live.erase(reg);
+        }
+        p_live.insert(uses[p_index].begin(), uses[p_index].end());
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            auto live = get_live_out(b);
+            for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+                step(i, live);
+            }
+            if (live != live_ins[b]) {
+                live_ins[b] = std::move(live);
+                changed = true;
+            }
+        }
+    }
+
+    // one of them is written where the other is live afterwards
+    auto interferes = [&](const std::string &p_reg,
+                          const std::string &p_other) {
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            auto live = get_live_out(b);
+            for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+                if (!insts[i].isCall() &&
+                    ((defs[i].count(p_reg) && live.count(p_other)) ||
+                     (defs[i].count(p_other) && live.count(p_reg)))) {
+                    return true;
+                }
+                step(i, live);
+            }
+        }
+        return false;
+    };
+
+    for (const auto &rename : kRenames) {
+        if (interferes(rename.first, rename.second)) {
+            continue;
+        }
+        for (auto &inst : insts) {
+            if (!inst.isInstruction()) {
+                continue;
+            }
+            auto operands = inst.getOperands();
+            for (size_t i = 0; i < operands.size(); ++i) {
+                MemoryOperand mem;
+                if (!isRegisterOperand(inst, i)) {
+                    continue;
+                } else if (parseMemoryOperand(operands[i], mem)) {
+                    if (mem.base == rename.first) {
+                        operands[i].replace(operands[i].find('(') + 1,
+                                            rename.first.size(),
+                                            rename.second);
+                    }
+                } else if (operands[i] == rename.first) {
+                    operands[i] = rename.second;
+                }
+            }
+            inst.setOperands(operands);
+        }
+    }
+}
+
+void RvcCompression::rewriteFrameAccesses(MachineFunction &p_function) {
+    // sp == s0 + offset, if known
+    struct SpState {
+        bool m_reached = false;
+        bool m_known = false;
+        int32_t m_offset = 0;
+    };
+    auto transfer = [](const MachineInstruction &p_inst, SpState &p_state) {
+        const auto defined = p_inst.getDefinedRegister();
+        const auto &operands = p_inst.getOperands();
+        int32_t imm = 0;
+        const bool is_addi = p_inst.getOpcode() == "addi" &&
+                             operands.size() == 3 &&
+                             parseImmediate(operands[2], imm);
+        if (defined == "sp") {
+            if (is_addi && operands[1] == "sp" && p_state.m_known) {
+                p_state.m_offset += imm;
+            } else {
+                p_state.m_known = false;
+            }
+        } else if (defined == "s0") {
+            // s0 = sp + imm
+            p_state.m_known = is_addi && operands[1] == "sp";
+            p_state.m_offset = -imm;
+        }
+    };
+
+    auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+    if (blocks.empty()) {
+        return;
+    }
+    std::vector<SpState> in_states(blocks.size());
+    in_states[0].m_reached = true;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if (!in_states[b].m_reached) {
+                continue;
+            }
+            SpState state = in_states[b];
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+                transfer(insts[i], state);
+            }
+            for (const auto succ : blocks[b].successors) {
+                auto &in = in_states[succ];
+                if (!in.m_reached) {
+                    in = state;
+                    changed = true;
+                } else if (in.m_known &&
+                           (!state.m_known || in.m_offset != state.m_offset)) {
+                    in.m_known = false;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        SpState state = in_states[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            auto &inst = insts[i];
+            MemoryOperand mem;
+            if (state.m_known && (inst.getOpcode() == "lw" ||
+                                  inst.getOpcode() == "sw") &&
+                parseMemoryOperand(inst.getOperands()[1], mem) &&
+                mem.base == "s0") {
+                // only if c.lwsp/c.swsp can encode the offset
+                const auto offset = mem.offset - state.m_offset;
+                if (fitsScaled(offset, 4, 252)) {
+                    inst.setOperands(
+                        {inst.getOperands()[0],
+                         std::to_string(offset) + "(sp)"});
+                }
+            }
+            transfer(inst, state);
+        }
+    }
+}
+
+bool RvcCompression::compress(MachineInstruction &p_inst) {
+    if (!p_inst.isInstruction()) {
+        return false;
+    }
+    const auto &op = p_inst.getOpcode();
+    const auto operands = p_inst.getOperands();
+    auto replace = [&](const char *p_op,
+                       const MachineInstruction::Operands &p_operands) {
+        p_inst.setOpcode(p_op);
+        p_inst.setOperands(p_operands);
+        return true;
+    };
+
+    if (op == "nop") {
+        return replace("c.nop", {});
+    }
+    if (p_inst.isReturn() || (op == "jr" && operands.size() == 1)) {
+        return replace("c.jr", {operands.empty() ? "ra" : operands[0]});
+    }
+
+    MemoryOperand mem;
+    if ((op == "lw" || op == "sw") && operands.size() == 2 &&
+        parseMemoryOperand(operands[1], mem)) {
+        const bool is_load = op == "lw";
+        if (mem.base == "sp" && fitsScaled(mem.offset, 4, 252) &&
+            (!is_load || operands[0] != "zero")) {
+            return replace(is_load ? "c.lwsp" : "c.swsp", operands);
+        }
+        if (isCompressedRegister(mem.base) &&
+            isCompressedRegister(operands[0]) &&
+            fitsScaled(mem.offset, 4, 124)) {
+            return replace(is_load ? "c.lw" : "c.sw", operands);
+        }
+        return false;
+    }
+
+    if (operands.empty() || operands[0] == "zero") {
+        return false;
+    }
+    const auto &rd = operands[0];
+    int32_t imm = 0;
+
+    if (op == "li" && operands.size() == 2 &&
+        parseImmediate(operands[1], imm) && fitsSigned(imm, 6)) {
+        return replace("c.li", operands);
+    }
+    if (op == "mv" && operands.size() == 2 && operands[1] != "zero") {
+        return replace("c.mv", operands);
+    }
+
+    if (operands.size() != 3) {
+        return false;
+    }
+    const auto &rs1 = operands[1];
+    const auto &rs2 = operands[2];
+    if (parseImmediate(rs2, imm)) {
+        if (op == "addi") {
+            if (rd == "sp" && rs1 == "sp" && imm != 0 && imm % 16 == 0 &&
+                imm >= -512 && imm <= 496) {
+                return replace("c.addi16sp", {"sp", rs2});
+            }
+            if (rs1 == "sp" && isCompressedRegister(rd) && imm != 0 &&
+                fitsScaled(imm, 4, 1020)) {
+                return replace("c.addi4spn", operands);
+            }
+            if (rd == rs1 && imm != 0 && fitsSigned(imm, 6)) {
+                return replace("c.addi", {rd, rs2});
+            }
+            if (rs1 == "zero" && fitsSigned(imm, 6)) {
+                return replace("c.li", {rd, rs2});
+            }
+            if (imm == 0 && rs1 != "zero") {
+                return replace("c.mv", {rd, rs1});
+            }
+            return false;
+        }
+        if (op == "andi" && rd == rs1 && isCompressedRegister(rd) &&
+            fitsSigned(imm, 6)) {
+            return replace("c.andi", {rd, rs2});
+        }
+        if (rd == rs1 && imm > 0 && imm < 32) {
+            if (op == "slli") {
+                return replace("c.slli", {rd, rs2});
+            }
+            if ((op == "srli" || op == "srai") && isCompressedRegister(rd)) {
+                return replace(op == "srli" ? "c.srli" : "c.srai", {rd, rs2});
+            }
+        }
+        return false;
+    }
+
+    // rd = rd op rs, or rd = rs op rd for the commutative ones
+    const bool commutative =
+        op == "add" || op == "and" || op == "or" || op == "xor";
+    std::string rs;
+    if (rd == rs1) {
+        rs = rs2;
+    } else if (commutative && rd == rs2) {
+        rs = rs1;
+    } else {
+        return false;
+    }
+    if (op == "add" && rs != "zero") {
+        return replace("c.add", {rd, rs});
+    }
+    if ((op == "sub" || op == "and" || op == "or" || op == "xor") &&
+        isCompressedRegister(rd) && isCompressedRegister(rs)) {
+        return replace(("c." + op).c_str(), {rd, rs});
+    }
+    return false;
+}
+
+void RvcCompression::compressBranches(MachineFunction &p_function) {
+    auto &insts = p_function.getInstructions();
+    // the compressed form of each branch and jump that may have one
+    std::map<size_t, std::string> candidates;
+    for (size_t i = 0; i < insts.size(); ++i) {
+        const auto &op = insts[i].getOpcode();
+        const auto &operands = insts[i].getOperands();
+        if (!insts[i].isInstruction()) {
+            continue;
+        } else if (op == "j") {
+            candidates[i] = "c.j";
+        } else if ((op == "beqz" || op == "bnez") &&
+                   isCompressedRegister(operands[0])) {
+            candidates[i] = "c." + op;
+        } else if ((op == "beq" || op == "bne") && operands.size() == 3 &&
+                   operands[1] == "zero" &&
+                   isCompressedRegister(operands[0])) {
+            candidates[i] = op == "beq" ? "c.beqz" : "c.bnez";
+        }
+    }
+
+    // assume that they're all compressed, and keep those whose label is
+    // still in the reach of the compressed offset; an .align counts as its
+    // largest padding, and a label in another section is out of reach
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::vector<std::string> sections = {".text"};
+        std::map<std::string, int64_t> section_sizes;
+        // (section, offset in it)
+        std::vector<std::pair<std::string, int64_t>> addresses(insts.size());
+        std::map<std::string, std::pair<std::string, int64_t>> labels;
+        for (size_t i = 0; i < insts.size(); ++i) {
+            const auto &inst = insts[i];
+            auto &size = section_sizes[sections.back()];
+            addresses[i] = {sections.back(), size};
+            if (inst.isLabel()) {
+                labels[inst.getOpcode()] = addresses[i];
+            } else if (inst.isInstruction()) {
+                size += candidates.count(i) ? 2 : getSize(inst);
+            } else {
+                const auto &directive = inst.getOpcode();
+                const auto space = directive.find(' ');
+                const auto name = directive.substr(0, space);
+                const auto argument = space == std::string::npos
+                                          ? ""
+                                          : directive.substr(space + 1);
+                if (name == ".pushsection") {
+                    sections.push_back(argument);
+                } else if (name == ".popsection" && sections.size() > 1) {
+                    sections.pop_back();
+                } else if (name == ".section") {
+                    sections.back() = argument;
+                } else if (name == ".align") {
+                    size += (int64_t(1) << std::stoi(argument)) - 2;
+                }
+            }
+        }
+
+        for (auto it = candidates.begin(); it != candidates.end();) {
+            const auto &address = addresses[it->first];
+            const int64_t reach = it->second == "c.j" ? 2048 : 256;
+            auto search = labels.find(insts[it->first].getTarget());
+            if (search == labels.end() ||
+                search->second.first != address.first ||
+                search->second.second - address.second < -reach ||
+                search->second.second - address.second >= reach) {
+                it = candidates.erase(it);
+                changed = true;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const auto &candidate : candidates) {
+        auto &inst = insts[candidate.first];
+        const auto label = inst.getTarget();
+        if (candidate.second == "c.j") {
+            inst.rewrite("c.j", {label});
+        } else {
+            inst.rewrite(candidate.second, {inst.getOperands()[0], label});
+        }
+    }
+}
+
+size_t RvcCompression::getSize(const MachineInstruction &p_inst) {
+    const auto &op = p_inst.getOpcode();
+    int32_t imm = 0;
+    if (op.compare(0, 2, "c.") == 0) {
+        return 2;
+    }
+    if (op == "la" || op == "call" || op == "tail" ||
+        (op == "li" && !(parseImmediate(p_inst.getOperands()[1], imm) &&
+                         fitsSigned(imm, 12)))) {
+        // auipc/lui + another instruction
+        return 8;
+    }
+    return 4;
+}
+
+size_t RvcCompression::getSize(const MachineFunction &p_function) {
+    size_t size = 0;
+    for (const auto &inst : p_function.getInstructions()) {
+        if (inst.isInstruction()) {
+            size += getSize(inst);
+        }
+    }
+    return size;
+}
+
+RvcCompression::SizeReport RvcCompression::run(MachineFunction &p_function) {
+    SizeReport report;
+    report.m_uncompressed = getSize(p_function);
+
+    renameTemporaries(p_function);
+    rewriteFrameAccesses(p_function);
+    for (auto &inst : p_function.getInstructions()) {
+        compress(inst);
+    }
+    compressBranches(p_function);
+
+    report.m_compressed = getSize(p_function);
+    return report;
+}
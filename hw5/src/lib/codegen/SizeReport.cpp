@@ -0,0 +1,157 @@
+#include "codegen/SizeReport.hpp"
+#include "codegen/RvcCompression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+// cached for the functions that can reach a recursive one
+constexpr size_t kUnbounded = SIZE_MAX;
+
+SizeReport::Function &
+SizeReport::addFunction(const MachineFunction &p_function,
+                        const size_t p_frame_size,
+                        const size_t p_max_outgoing_arguments) {
+    m_functions.emplace_back();
+    auto &function = m_functions.back();
+    function.m_name = p_function.getName();
+    function.m_bytes = RvcCompression::getSize(p_function);
+    function.m_frame_size = p_frame_size;
+    function.m_max_outgoing_arguments = p_max_outgoing_arguments;
+
+    // bytes below the caller's sp; the value of the last li to t0 extends a
+    // large frame
+    int64_t depth = 0;
+    int32_t t0_value = 0;
+    for (const auto &inst : p_function.getInstructions()) {
+        if (inst.isDirective() &&
+            inst.getOpcode().find(".pushsection") != std::string::npos) {
+            // the cold code runs in the frame
+            depth = p_frame_size;
+            continue;
+        }
+        if (!inst.isInstruction()) {
+            continue;
+        }
+        ++function.m_num_of_instructions;
+
+        const auto &op = inst.getOpcode();
+        const auto &operands = inst.getOperands();
+        MemoryOperand mem;
+        if (inst.isStore() && parseMemoryOperand(operands[1], mem) &&
+            mem.base == "sp" && operands[0] != "ra" && operands[0] != "s0") {
+            ++function.m_num_of_spills;
+        }
+
+        int32_t imm = 0;
+        if (op == "li" && operands[0] == "t0" &&
+            parseImmediate(operands[1], imm)) {
+            t0_value = imm;
+        }
+        if (inst.getDefinedRegister() == "sp" && operands.size() == 3 &&
+            operands[1] == "sp") {
+            if (op == "addi" && parseImmediate(operands[2], imm)) {
+                depth -= imm;
+            } else if (op == "sub" && operands[2] == "t0") {
+                depth += t0_value;
+            } else if (op == "add" && operands[2] == "t0") {
+                depth -= t0_value;
+            }
+            depth = std::max<int64_t>(depth, 0);
+        }
+
+        const size_t pushed =
+            (depth > static_cast<int64_t>(p_frame_size))
+                ? static_cast<size_t>(depth) - p_frame_size
+                : 0;
+        function.m_max_pushed = std::max(function.m_max_pushed, pushed);
+        if (inst.isCall()) {
+            auto &call = function.m_calls[inst.getTarget()];
+            call = std::max(call, pushed);
+        }
+    }
+    return function;
+}
+
+bool SizeReport::getStackDepth(const std::string &p_name,
+                               std::map<std::string, size_t> &p_depths,
+                               std::set<std::string> &p_visiting) const {
+    auto cached = p_depths.find(p_name);
+    if (cached != p_depths.end()) {
+        return cached->second != kUnbounded;
+    }
+    auto function = std::find_if(
+        m_functions.begin(), m_functions.end(),
+        [&](const Function &p_function) { return p_function.m_name == p_name; });
+    if (function == m_functions.end()) {
+        // a runtime function
+        p_depths[p_name] = 0;
+        return true;
+    }
+    if (!p_visiting.insert(p_name).second) {
+        return false;
+    }
+
+    size_t depth = function->m_max_pushed;
+    bool bounded = true;
+    for (const auto &call : function->m_calls) {
+        if (!getStackDepth(call.first, p_depths, p_visiting)) {
+            bounded = false;
+            break;
+        }
+        depth = std::max(depth, call.second + p_depths[call.first]);
+    }
+
+    p_visiting.erase(p_name);
+    p_depths[p_name] = bounded ? function->m_frame_size + depth : kUnbounded;
+    return bounded;
+}
+
+void SizeReport::print(FILE *p_out_file) const {
+    std::map<std::string, size_t> depths;
+    std::set<std::string> visiting;
+    size_t num_of_instructions = 0;
+    size_t bytes = 0;
+
+    fprintf(p_out_file, "{\n"
+                        "  \"functions\": [\n");
+    for (size_t i = 0; i < m_functions.size(); ++i) {
+        const auto &function = m_functions[i];
+        num_of_instructions += function.m_num_of_instructions;
+        bytes += function.m_bytes;
+
+        fprintf(p_out_file,
+                "    {\n"
+                "      \"name\": \"%s\",\n"
+                "      \"instructions\": %zu,\n"
+                "      \"bytes\": %zu,\n"
+                "      \"frame_size\": %zu,\n"
+                "      \"spills\": %zu,\n"
+                "      \"max_outgoing_args\": %zu,\n",
+                function.m_name.c_str(), function.m_num_of_instructions,
+                function.m_bytes, function.m_frame_size,
+                function.m_num_of_spills, function.m_max_outgoing_arguments);
+        if (getStackDepth(function.m_name, depths, visiting)) {
+            fprintf(p_out_file,
+                    "      \"stack_depth\": %zu,\n"
+                    "      \"unbounded_recursion\": false\n",
+                    depths[function.m_name]);
+        } else {
+            fprintf(p_out_file, "      \"stack_depth\": null,\n"
+                                "      \"unbounded_recursion\": true\n");
+        }
+        fprintf(p_out_file, "    }%s\n",
+                (i + 1 == m_functions.size()) ? "" : ",");
+    }
+
+    fprintf(p_out_file,
+            "  ],\n"
+            "  \"instructions\": %zu,\n"
+            "  \"bytes\": %zu,\n",
+            num_of_instructions, bytes);
+    if (getStackDepth("main", depths, visiting)) {
+        fprintf(p_out_file, "  \"stack_depth\": %zu\n", depths["main"]);
+    } else {
+        fprintf(p_out_file, "  \"stack_depth\": null\n");
+    }
+    fprintf(p_out_file, "}\n");
+}
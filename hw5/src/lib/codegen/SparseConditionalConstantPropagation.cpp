@@ -0,0 +1,636 @@
+#include "codegen/SparseConditionalConstantPropagation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <deque>
+#include <set>
+
+static constexpr const char *const kFramePointer = "s0";
+static constexpr const char *const kStackPointer = "sp";
+
+// RV32IM semantics, including division by zero and overflow
+static bool foldBinary(const std::string &p_op, const int32_t p_lhs,
+                       const int32_t p_rhs, int32_t &p_result) {
+    const uint32_t lhs = static_cast<uint32_t>(p_lhs);
+    const uint32_t rhs = static_cast<uint32_t>(p_rhs);
+    const bool overflow = p_lhs == INT32_MIN && p_rhs == -1;
+
+    if (p_op == "add") {
+        p_result = static_cast<int32_t>(lhs + rhs);
+    } else if (p_op == "sub") {
+        p_result = static_cast<int32_t>(lhs - rhs);
+    } else if (p_op == "mul") {
+        p_result = static_cast<int32_t>(lhs * rhs);
+    } else if (p_op == "div") {
+        p_result = (p_rhs == 0) ? -1 : (overflow ? p_lhs : p_lhs / p_rhs);
+    } else if (p_op == "divu") {
+        p_result = static_cast<int32_t>((rhs == 0) ? UINT32_MAX : lhs / rhs);
+    } else if (p_op == "rem") {
+        p_result = (p_rhs == 0) ? p_lhs : (overflow ? 0 : p_lhs % p_rhs);
+    } else if (p_op == "remu") {
+        p_result = static_cast<int32_t>((rhs == 0) ? lhs : lhs % rhs);
+    } else if (p_op == "and") {
+        p_result = static_cast<int32_t>(lhs & rhs);
+    } else if (p_op == "or") {
+        p_result = static_cast<int32_t>(lhs | rhs);
+    } else if (p_op == "xor") {
+        p_result = static_cast<int32_t>(lhs ^ rhs);
+    } else if (p_op == "sll") {
+        p_result = static_cast<int32_t>(lhs << (rhs & 31));
+    } else if (p_op == "srl") {
+        p_result = static_cast<int32_t>(lhs >> (rhs & 31));
+    } else if (p_op == "sra") {
+        p_result = p_lhs >> (rhs & 31);
+    } else if (p_op == "slt") {
+        p_result = p_lhs < p_rhs;
+    } else if (p_op == "sltu") {
+        p_result = lhs < rhs;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool isRemovableDefinition(const MachineInstruction &p_inst) {
+    if (!p_inst.isInstruction() || p_inst.isStore() || p_inst.isCall() ||
+        p_inst.isTerminator() || p_inst.isVectorConfiguration() ||
+        p_inst.getOpcode() == "jr") {
+        return false;
+    }
+    const auto defined = p_inst.getDefinedRegister();
+    return !defined.empty() && defined != "ra" &&
+           isCallerSavedRegister(defined);
+}
+
+// ===========================================
+// > LatticeState
+// ===========================================
+void SparseConditionalConstantPropagation::LatticeState::meet(
+    const LatticeState &p_other) {
+    for (auto it = m_registers.begin(); it != m_registers.end();) {
+        auto search = p_other.m_registers.find(it->first);
+        const bool same = search != p_other.m_registers.end() &&
+                          search->second == it->second;
+        it = same ? std::next(it) : m_registers.erase(it);
+    }
+    for (auto it = m_memory.begin(); it != m_memory.end();) {
+        auto search = p_other.m_memory.find(it->first);
+        const bool same =
+            search != p_other.m_memory.end() && search->second == it->second;
+        it = same ? std::next(it) : m_memory.erase(it);
+    }
+    if (!p_other.m_sp_known || p_other.m_sp_offset != m_sp_offset) {
+        m_sp_known = false;
+    }
+}
+
+bool SparseConditionalConstantPropagation::LatticeState::getValue(
+    const std::string &p_reg, Value &p_value) const {
+    if (p_reg == "zero") {
+        p_value = Value{};
+        return true;
+    }
+    auto search = m_registers.find(p_reg);
+    if (search == m_registers.end()) {
+        return false;
+    }
+    p_value = search->second;
+    return true;
+}
+
+void SparseConditionalConstantPropagation::LatticeState::setValue(
+    const std::string &p_reg, const Value *p_value) {
+    if (p_reg == "zero") {
+        return;
+    }
+    if (p_value) {
+        m_registers[p_reg] = *p_value;
+    } else {
+        m_registers.erase(p_reg);
+    }
+}
+
+// ===========================================
+// > SparseConditionalConstantPropagation
+// ===========================================
+bool SparseConditionalConstantPropagation::resolveAddress(
+    const std::string &p_operand, const LatticeState &p_state,
+    MemoryLocation &p_location) const {
+    MemoryOperand mem;
+    if (!parseMemoryOperand(p_operand, mem)) {
+        return false;
+    }
+
+    if (mem.base == kFramePointer) {
+        p_location = MemoryLocation{kFramePointer, mem.offset};
+        return true;
+    }
+    if (mem.base == kStackPointer) {
+        if (!p_state.m_sp_known) {
+            return false;
+        }
+        p_location =
+            MemoryLocation{kFramePointer, p_state.m_sp_offset + mem.offset};
+        return true;
+    }
+
+    Value base;
+    if (!p_state.getValue(mem.base, base) || base.isConstant()) {
+        return false;
+    }
+    p_location = MemoryLocation{base.m_symbol, base.m_constant + mem.offset};
+    return true;
+}
+
+bool SparseConditionalConstantPropagation::evaluate(
+    const MachineInstruction &p_inst, const LatticeState &p_state,
+    Value &p_value) {
+    const auto &op = p_inst.getOpcode();
+    const auto &operands = p_inst.getOperands();
+
+    if (op == "li") {
+        p_value = Value{};
+        return operands.size() == 2 &&
+               parseImmediate(operands[1], p_value.m_constant);
+    }
+    if (op == "la") {
+        p_value = Value{operands[1], 0};
+        return operands.size() == 2;
+    }
+    if (op == "mv") {
+        return p_state.getValue(operands[1], p_value);
+    }
+
+    if (op == "neg" || op == "not" || op == "seqz" || op == "snez" ||
+        op == "sltz" || op == "sgtz") {
+        Value src;
+        if (!p_state.getValue(operands[1], src) || !src.isConstant()) {
+            return false;
+        }
+        const int32_t value = src.m_constant;
+        p_value = Value{};
+        if (op == "neg") {
+            p_value.m_constant =
+                static_cast<int32_t>(0u - static_cast<uint32_t>(value));
+        } else if (op == "not") {
+            p_value.m_constant = ~value;
+        } else if (op == "seqz") {
+            p_value.m_constant = value == 0;
+        } else if (op == "snez") {
+            p_value.m_constant = value != 0;
+        } else if (op == "sltz") {
+            p_value.m_constant = value < 0;
+        } else {
+            p_value.m_constant = value > 0;
+        }
+        return true;
+    }
+
+    if (operands.size() != 3) {
+        return false;
+    }
+
+    Value lhs, rhs;
+    std::string binary_op = getRegisterForm(op);
+    if (!binary_op.empty()) {
+        rhs = Value{};
+        if (!parseImmediate(operands[2], rhs.m_constant)) {
+            return false;
+        }
+    } else {
+        binary_op = op;
+        if (!p_state.getValue(operands[2], rhs)) {
+            return false;
+        }
+    }
+    if (!p_state.getValue(operands[1], lhs)) {
+        return false;
+    }
+
+    // symbol + constant, symbol - constant
+    if (!lhs.isConstant() || !rhs.isConstant()) {
+        if (binary_op == "add" && lhs.isConstant() != rhs.isConstant()) {
+            const Value &symbol = lhs.isConstant() ? rhs : lhs;
+            const Value &offset = lhs.isConstant() ? lhs : rhs;
+            p_value = Value{symbol.m_symbol,
+                            symbol.m_constant + offset.m_constant};
+            return true;
+        }
+        if (binary_op == "sub" && rhs.isConstant()) {
+            p_value = Value{lhs.m_symbol, lhs.m_constant - rhs.m_constant};
+            return true;
+        }
+        return false;
+    }
+
+    p_value = Value{};
+    return foldBinary(binary_op, lhs.m_constant, rhs.m_constant,
+                      p_value.m_constant);
+}
+
+SparseConditionalConstantPropagation::BranchOutcome
+SparseConditionalConstantPropagation::evaluateBranch(
+    const MachineInstruction &p_inst, const LatticeState &p_state) {
+    std::string op = p_inst.getOpcode();
+    const auto &operands = p_inst.getOperands();
+
+    // normalize to "op lhs, rhs, target" with op in beq, bne, blt, bge,
+    // bltu, bgeu
+    std::string lhs = operands[0];
+    std::string rhs = (operands.size() == 3) ? operands[1] : "zero";
+    if (operands.size() == 2) {
+        // beqz, bnez, blez, bgez, bltz, bgtz
+        op.pop_back();
+    }
+    if (op == "ble" || op == "bgt" || op == "bleu" || op == "bgtu") {
+        std::swap(lhs, rhs);
+        op = std::string((op[1] == 'l') ? "bge" : "blt") +
+             ((op.back() == 'u') ? "u" : "");
+    }
+
+    Value lhs_value, rhs_value;
+    if (!p_state.getValue(lhs, lhs_value) ||
+        !p_state.getValue(rhs, rhs_value) || !lhs_value.isConstant() ||
+        !rhs_value.isConstant()) {
+        return BranchOutcome::kUnknown;
+    }
+
+    const int32_t a = lhs_value.m_constant;
+    const int32_t b = rhs_value.m_constant;
+    bool taken = false;
+    if (op == "beq") {
+        taken = a == b;
+    } else if (op == "bne") {
+        taken = a != b;
+    } else if (op == "blt") {
+        taken = a < b;
+    } else if (op == "bge") {
+        taken = a >= b;
+    } else if (op == "bltu") {
+        taken = static_cast<uint32_t>(a) < static_cast<uint32_t>(b);
+    } else if (op == "bgeu") {
+        taken = static_cast<uint32_t>(a) >= static_cast<uint32_t>(b);
+    } else {
+        return BranchOutcome::kUnknown;
+    }
+    return taken ? BranchOutcome::kTaken : BranchOutcome::kNotTaken;
+}
+
+void SparseConditionalConstantPropagation::transfer(
+    const MachineInstruction &p_inst, LatticeState &p_state) const {
+    if (!p_inst.isInstruction()) {
+        return;
+    }
+
+    auto kill_memory = [&](const bool p_globals, const bool p_frame,
+                           const int32_t p_below) {
+        for (auto it = p_state.m_memory.begin();
+             it != p_state.m_memory.end();) {
+            const bool in_frame = it->first.first == kFramePointer;
+            const bool kill = in_frame ? (p_frame && it->first.second < p_below)
+                                       : p_globals;
+            it = kill ? p_state.m_memory.erase(it) : std::next(it);
+        }
+    };
+
+    if (p_inst.isVectorStore()) {
+        // the extent isn't known; it may write any global, and the frame if
+        // its address escapes
+        kill_memory(true, m_frame_escaped, INT32_MAX);
+        return;
+    }
+
+    if (p_inst.isStore()) {
+        MemoryLocation location;
+        if (p_inst.getOpcode() != "sw" ||
+            !resolveAddress(p_inst.getOperands()[1], p_state, location)) {
+            // may write any global, and the frame if its address escapes
+            kill_memory(true, m_frame_escaped, INT32_MAX);
+            return;
+        }
+        Value value;
+        if (p_state.getValue(p_inst.getOperands()[0], value)) {
+            p_state.m_memory[location] = value;
+        } else {
+            p_state.m_memory.erase(location);
+        }
+        return;
+    }
+
+    if (p_inst.isCall()) {
+        for (auto it = p_state.m_registers.begin();
+             it != p_state.m_registers.end();) {
+            it = isCallerSavedRegister(it->first)
+                     ? p_state.m_registers.erase(it)
+                     : std::next(it);
+        }
+        // the callee may write the globals and the stack below sp
+        const auto *summary =
+            m_side_effects ? m_side_effects->getSummary(p_inst.getTarget())
+                           : nullptr;
+        const bool globals = !summary || !summary->preservesGlobals();
+        const bool whole_frame = m_frame_escaped || !p_state.m_sp_known;
+        kill_memory(globals, true,
+                    whole_frame ? INT32_MAX : p_state.m_sp_offset);
+        return;
+    }
+
+    const auto defined = p_inst.getDefinedRegister();
+    if (defined.empty()) {
+        return;
+    }
+
+    const auto &operands = p_inst.getOperands();
+    int32_t imm = 0;
+    if (defined == kStackPointer) {
+        const bool adjusts = p_inst.getOpcode() == "addi" &&
+                             operands[1] == kStackPointer &&
+                             parseImmediate(operands[2], imm);
+        if (adjusts) {
+            p_state.m_sp_offset += imm;
+        } else {
+            p_state.m_sp_known = false;
+        }
+        return;
+    }
+
+    if (defined == kFramePointer) {
+        // a new frame: addi s0, sp, N
+        for (auto it = p_state.m_memory.begin();
+             it != p_state.m_memory.end();) {
+            it = (it->first.first == kFramePointer)
+                     ? p_state.m_memory.erase(it)
+                     : std::next(it);
+        }
+        p_state.m_sp_known = p_inst.getOpcode() == "addi" &&
+                             operands[1] == kStackPointer &&
+                             parseImmediate(operands[2], imm);
+        p_state.m_sp_offset = -imm;
+        return;
+    }
+
+    if (p_inst.isLoad()) {
+        MemoryLocation location;
+        if (p_inst.getOpcode() == "lw" &&
+            resolveAddress(operands[1], p_state, location)) {
+            auto search = p_state.m_memory.find(location);
+            if (search != p_state.m_memory.end()) {
+                p_state.setValue(defined, &search->second);
+                return;
+            }
+        }
+        p_state.setValue(defined, nullptr);
+        return;
+    }
+
+    Value value;
+    const bool known = evaluate(p_inst, p_state, value);
+    p_state.setValue(defined, known ? &value : nullptr);
+}
+
+bool SparseConditionalConstantPropagation::run(MachineFunction &p_function) {
+    m_frame_escaped = p_function.isFrameAddressEscaped();
+
+    auto &insts = p_function.getInstructions();
+    const auto blocks = p_function.computeBasicBlocks();
+    if (blocks.empty()) {
+        return false;
+    }
+
+    std::vector<LatticeState> in_states(blocks.size());
+    std::vector<LatticeState> out_states(blocks.size());
+    std::vector<bool> visited(blocks.size(), false);
+    std::set<std::pair<size_t, size_t>> executable_edges;
+
+    auto compute_in_state = [&](const size_t b) {
+        LatticeState state;
+        bool first = true;
+        for (const auto pred : blocks[b].predecessors) {
+            if (!executable_edges.count({pred, b})) {
+                continue;
+            }
+            if (first) {
+                state = out_states[pred];
+                first = false;
+            } else {
+                state.meet(out_states[pred]);
+            }
+        }
+        return state;
+    };
+
+    // successors reachable from the end of the block
+    auto get_executable_successors = [&](const size_t b,
+                                         const LatticeState &p_state) {
+        const auto &last = insts[blocks[b].end - 1];
+        const auto &successors = blocks[b].successors;
+        if (!last.isBranch()) {
+            return successors;
+        }
+        switch (evaluateBranch(last, p_state)) {
+        case BranchOutcome::kTaken:
+            return std::vector<size_t>{successors.front()};
+        case BranchOutcome::kNotTaken:
+            return std::vector<size_t>(std::next(successors.begin()),
+                                       successors.end());
+        case BranchOutcome::kUnknown:
+        default:
+            return successors;
+        }
+    };
+
+    std::deque<size_t> worklist{0};
+    std::vector<bool> queued(blocks.size(), false);
+    queued[0] = true;
+    while (!worklist.empty()) {
+        const size_t b = worklist.front();
+        worklist.pop_front();
+        queued[b] = false;
+
+        LatticeState state = (b == 0) ? LatticeState{} : compute_in_state(b);
+        in_states[b] = state;
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            transfer(insts[i], state);
+        }
+
+        const bool changed = !visited[b] || state != out_states[b];
+        visited[b] = true;
+        out_states[b] = state;
+
+        for (const auto succ : get_executable_successors(b, state)) {
+            const bool new_edge = executable_edges.emplace(b, succ).second;
+            if ((new_edge || changed) && !queued[succ]) {
+                queued[succ] = true;
+                worklist.push_back(succ);
+            }
+        }
+    }
+
+    bool changed = false;
+    std::vector<bool> removed(insts.size(), false);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (!visited[b]) {
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+                // keep .size and the like
+                removed[i] = !insts[i].isDirective();
+                changed |= removed[i];
+            }
+            continue;
+        }
+
+        LatticeState state = in_states[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            MachineInstruction &inst = insts[i];
+            const MachineInstruction original = inst;
+
+            if (inst.isBranch()) {
+                switch (evaluateBranch(inst, state)) {
+                case BranchOutcome::kTaken:
+                    inst.rewrite("j", {inst.getTarget()});
+                    changed = true;
+                    break;
+                case BranchOutcome::kNotTaken:
+                    removed[i] = true;
+                    changed = true;
+                    break;
+                case BranchOutcome::kUnknown:
+                default:
+                    break;
+                }
+            } else if (isRemovableDefinition(inst) && inst.getOpcode() != "li") {
+                LatticeState after = state;
+                transfer(inst, after);
+                Value value;
+                if (after.getValue(inst.getDefinedRegister(), value) &&
+                    value.isConstant()) {
+                    inst.rewrite("li", {inst.getDefinedRegister(),
+                                        std::to_string(value.m_constant)});
+                    changed = true;
+                }
+            }
+            transfer(original, state);
+        }
+    }
+    p_function.removeInstructions(removed);
+
+    changed |= removeRedundantJumps(p_function);
+    changed |= removeDeadDefinitions(p_function);
+    return changed;
+}
+
+// j L / L: => L:, also across directives such as the alignment of a loop,
+// but not across a switch to another section, e.g., of the cold code
+bool SparseConditionalConstantPropagation::removeRedundantJumps(
+    MachineFunction &p_function) {
+    auto &insts = p_function.getInstructions();
+    std::vector<bool> removed(insts.size(), false);
+    bool changed = false;
+
+    for (size_t i = 0; i < insts.size(); ++i) {
+        if (!insts[i].isJump()) {
+            continue;
+        }
+        for (size_t j = i + 1; j < insts.size() && !insts[j].isInstruction();
+             ++j) {
+            const auto &opcode = insts[j].getOpcode();
+            if (insts[j].isDirective() &&
+                (opcode.compare(0, 8, ".section") == 0 ||
+                 opcode.compare(0, 12, ".pushsection") == 0 ||
+                 opcode.compare(0, 11, ".popsection") == 0)) {
+                break;
+            }
+            if (opcode == insts[i].getTarget()) {
+                removed[i] = true;
+                changed = true;
+                break;
+            }
+        }
+    }
+
+    p_function.removeInstructions(removed);
+    return changed;
+}
+
+bool SparseConditionalConstantPropagation::removeDeadDefinitions(
+    MachineFunction &p_function) {
+    static const std::vector<std::string> kArgumentRegisters = {
+        "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7"};
+    using LiveRegisters = std::set<std::string>;
+
+    auto &insts = p_function.getInstructions();
+    bool changed = false;
+    bool removed_any = true;
+    while (removed_any) {
+        const auto blocks = p_function.computeBasicBlocks();
+        std::vector<LiveRegisters> live_in(blocks.size());
+
+        // walk the block backward; flag the dead definitions if requested
+        auto propagate = [&](const size_t b, LiveRegisters live,
+                             std::vector<bool> *p_removed) {
+            for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+                const auto &inst = insts[i];
+                if (!inst.isInstruction()) {
+                    continue;
+                }
+                if (inst.isReturn()) {
+                    live.insert({"a0", "a1", "ra", "sp", "s0"});
+                    continue;
+                }
+                if (inst.isCall()) {
+                    for (auto it = live.begin(); it != live.end();) {
+                        it = isCallerSavedRegister(*it) ? live.erase(it)
+                                                        : std::next(it);
+                    }
+                    live.insert(kArgumentRegisters.begin(),
+                                kArgumentRegisters.end());
+                    live.insert("sp");
+                    continue;
+                }
+
+                const auto defined = inst.getDefinedRegister();
+                if (isRemovableDefinition(inst) && !live.count(defined)) {
+                    if (p_removed) {
+                        (*p_removed)[i] = true;
+                    }
+                    continue;
+                }
+                live.erase(defined);
+                for (const auto &used : inst.getUsedRegisters()) {
+                    live.insert(used);
+                }
+            }
+            return live;
+        };
+
+        auto compute_live_out = [&](const size_t b) {
+            LiveRegisters live;
+            for (const auto succ : blocks[b].successors) {
+                live.insert(live_in[succ].begin(), live_in[succ].end());
+            }
+            return live;
+        };
+
+        bool live_changed = true;
+        while (live_changed) {
+            live_changed = false;
+            for (size_t b = blocks.size(); b-- > 0;) {
+                auto live = propagate(b, compute_live_out(b), nullptr);
+                if (live != live_in[b]) {
+                    live_in[b].swap(live);
+                    live_changed = true;
+                }
+            }
+        }
+
+        std::vector<bool> removed(insts.size(), false);
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            propagate(b, compute_live_out(b), &removed);
+        }
+        removed_any =
+            std::find(removed.begin(), removed.end(), true) != removed.end();
+        changed |= removed_any;
+        p_function.removeInstructions(removed);
+    }
+    return changed;
+}
@@ -0,0 +1,868 @@
+#include "codegen/ValueRangeAnalysis.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <set>
+
+static constexpr const char *const kFramePointer = "s0";
+static constexpr const char *const kStackPointer = "sp";
+
+// rounds a loop head is analyzed before the ranges at its entry are widened
+static constexpr const size_t kWideningRounds = 3;
+
+using ValueRange = ValueRangeAnalysis::ValueRange;
+
+// ===========================================
+// > ValueRange
+// ===========================================
+ValueRange ValueRange::of(const int64_t p_min, const int64_t p_max) {
+    // the result wraps around: it may be any value
+    if (p_min < INT32_MIN || p_max > INT32_MAX) {
+        return ValueRange{};
+    }
+    return ValueRange{p_min, p_max};
+}
+
+ValueRange ValueRange::hull(const ValueRange &p_other) const {
+    return ValueRange{std::min(m_min, p_other.m_min),
+                      std::max(m_max, p_other.m_max)};
+}
+
+ValueRange ValueRange::intersect(const ValueRange &p_other) const {
+    return ValueRange{std::max(m_min, p_other.m_min),
+                      std::min(m_max, p_other.m_max)};
+}
+
+// ===========================================
+// > LatticeState
+// ===========================================
+void ValueRangeAnalysis::LatticeState::join(const LatticeState &p_other) {
+    for (auto it = m_registers.begin(); it != m_registers.end();) {
+        auto search = p_other.m_registers.find(it->first);
+        if (search == p_other.m_registers.end()) {
+            it = m_registers.erase(it);
+            continue;
+        }
+        it->second = it->second.hull(search->second);
+        it = it->second.isFull() ? m_registers.erase(it) : std::next(it);
+    }
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        auto search = p_other.m_slots.find(it->first);
+        if (search == p_other.m_slots.end()) {
+            it = m_slots.erase(it);
+            continue;
+        }
+        it->second = it->second.hull(search->second);
+        it = it->second.isFull() ? m_slots.erase(it) : std::next(it);
+    }
+    for (auto it = m_copies.begin(); it != m_copies.end();) {
+        auto search = p_other.m_copies.find(it->first);
+        const bool same =
+            search != p_other.m_copies.end() && search->second == it->second;
+        it = same ? std::next(it) : m_copies.erase(it);
+    }
+    for (auto it = m_register_copies.begin(); it != m_register_copies.end();) {
+        auto search = p_other.m_register_copies.find(it->first);
+        const bool same = search != p_other.m_register_copies.end() &&
+                          search->second == it->second;
+        it = same ? std::next(it) : m_register_copies.erase(it);
+    }
+    for (auto it = m_aliases.begin(); it != m_aliases.end();) {
+        auto search = p_other.m_aliases.find(it->first);
+        const bool same =
+            search != p_other.m_aliases.end() && search->second == it->second;
+        it = same ? std::next(it) : m_aliases.erase(it);
+    }
+    if (!p_other.m_sp_known || p_other.m_sp_offset != m_sp_offset) {
+        m_sp_known = false;
+    }
+}
+
+void ValueRangeAnalysis::LatticeState::widen(
+    const LatticeState &p_previous, const std::set<int64_t> &p_thresholds) {
+    // to the next threshold first, so that a loop variable only bounded by
+    // the test at the bottom of the loop stays bounded
+    auto widen_range = [&](ValueRange &p_range, const ValueRange &p_last) {
+        if (p_range.m_min < p_last.m_min) {
+            auto it = p_thresholds.upper_bound(p_range.m_min);
+            p_range.m_min =
+                (it == p_thresholds.begin()) ? INT32_MIN : *std::prev(it);
+        }
+        if (p_range.m_max > p_last.m_max) {
+            auto it = p_thresholds.lower_bound(p_range.m_max);
+            p_range.m_max = (it == p_thresholds.end()) ? INT32_MAX : *it;
+        }
+    };
+
+    for (auto it = m_registers.begin(); it != m_registers.end();) {
+        auto search = p_previous.m_registers.find(it->first);
+        widen_range(it->second, (search == p_previous.m_registers.end())
+                                    ? ValueRange{}
+                                    : search->second);
+        it = it->second.isFull() ? m_registers.erase(it) : std::next(it);
+    }
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        auto search = p_previous.m_slots.find(it->first);
+        widen_range(it->second, (search == p_previous.m_slots.end())
+                                    ? ValueRange{}
+                                    : search->second);
+        it = it->second.isFull() ? m_slots.erase(it) : std::next(it);
+    }
+}
+
+ValueRange
+ValueRangeAnalysis::LatticeState::getRange(const std::string &p_reg) const {
+    if (p_reg == "zero") {
+        return ValueRange{0, 0};
+    }
+    auto search = m_registers.find(p_reg);
+    return (search == m_registers.end()) ? ValueRange{} : search->second;
+}
+
+void ValueRangeAnalysis::LatticeState::setRange(const std::string &p_reg,
+                                                const ValueRange &p_range) {
+    if (p_reg == "zero") {
+        return;
+    }
+    m_copies.erase(p_reg);
+    m_register_copies.erase(p_reg);
+    for (auto it = m_register_copies.begin(); it != m_register_copies.end();) {
+        it = (it->second == p_reg) ? m_register_copies.erase(it)
+                                   : std::next(it);
+    }
+    if (p_range.isFull()) {
+        m_registers.erase(p_reg);
+    } else {
+        m_registers[p_reg] = p_range;
+    }
+}
+
+void ValueRangeAnalysis::LatticeState::copyRegister(const std::string &p_reg,
+                                                    const std::string &p_src) {
+    if (p_reg == p_src || p_reg == "zero" || p_src == "zero") {
+        return;
+    }
+    auto search = m_register_copies.find(p_src);
+    m_register_copies[p_reg] =
+        (search == m_register_copies.end()) ? p_src : search->second;
+}
+
+std::set<std::string> ValueRangeAnalysis::LatticeState::getSameRegisters(
+    const std::string &p_reg) const {
+    auto search = m_register_copies.find(p_reg);
+    const auto &origin =
+        (search == m_register_copies.end()) ? p_reg : search->second;
+    std::set<std::string> same_registers{origin};
+    for (const auto &copy : m_register_copies) {
+        if (copy.second == origin) {
+            same_registers.insert(copy.first);
+        }
+    }
+    return same_registers;
+}
+
+bool ValueRangeAnalysis::LatticeState::narrow(const std::string &p_reg,
+                                              const ValueRange &p_range) {
+    const auto range = getRange(p_reg).intersect(p_range);
+    if (range.isEmpty()) {
+        return false;
+    }
+    if (p_reg == "zero") {
+        return true;
+    }
+
+    for (const auto &reg : getSameRegisters(p_reg)) {
+        m_registers[reg] = getRange(reg).intersect(range);
+    }
+    auto copy = m_copies.find(p_reg);
+    if (copy != m_copies.end()) {
+        narrowSlot(getOrigin(copy->second), range);
+    }
+    return true;
+}
+
+// the slot, its aliases and the registers copying them hold the same value
+void ValueRangeAnalysis::LatticeState::narrowSlot(const int32_t p_slot,
+                                                  const ValueRange &p_range) {
+    std::set<int32_t> same_slots{p_slot};
+    for (const auto &alias : m_aliases) {
+        if (alias.second == p_slot) {
+            same_slots.insert(alias.first);
+        }
+    }
+
+    for (const auto slot : same_slots) {
+        auto search = m_slots.find(slot);
+        m_slots[slot] = (search == m_slots.end())
+                            ? p_range
+                            : search->second.intersect(p_range);
+    }
+    for (const auto &copy : m_copies) {
+        if (same_slots.count(copy.second)) {
+            m_registers[copy.first] =
+                getRange(copy.first).intersect(p_range);
+        }
+    }
+}
+
+int32_t
+ValueRangeAnalysis::LatticeState::getOrigin(const int32_t p_slot) const {
+    auto search = m_aliases.find(p_slot);
+    return (search == m_aliases.end()) ? p_slot : search->second;
+}
+
+// sw p_reg, p_slot
+void ValueRangeAnalysis::LatticeState::storeSlot(const int32_t p_slot,
+                                                 const std::string &p_reg) {
+    auto copy = m_copies.find(p_reg);
+    const bool copies_slot = copy != m_copies.end();
+    const int32_t origin = copies_slot ? getOrigin(copy->second) : p_slot;
+
+    // the registers holding the same value, which copy the slot from now on
+    // if it isn't an alias
+    auto same_registers = getSameRegisters(p_reg);
+    if (copies_slot) {
+        for (const auto &other : m_copies) {
+            if (other.second == copy->second) {
+                same_registers.insert(other.first);
+            }
+        }
+    }
+
+    killSlot(p_slot);
+    const auto range = getRange(p_reg);
+    if (!range.isFull()) {
+        m_slots[p_slot] = range;
+    }
+    if (p_reg == "zero") {
+        return;
+    }
+    if (copies_slot && origin != p_slot) {
+        m_aliases[p_slot] = origin;
+        m_copies[p_reg] = origin;
+        return;
+    }
+    for (const auto &reg : same_registers) {
+        m_register_copies.erase(reg);
+        m_copies[reg] = p_slot;
+    }
+}
+
+void ValueRangeAnalysis::LatticeState::killSlot(const int32_t p_slot) {
+    m_slots.erase(p_slot);
+    for (auto it = m_copies.begin(); it != m_copies.end();) {
+        it = (it->second == p_slot) ? m_copies.erase(it) : std::next(it);
+    }
+    for (auto it = m_aliases.begin(); it != m_aliases.end();) {
+        const bool kill = it->first == p_slot || it->second == p_slot;
+        it = kill ? m_aliases.erase(it) : std::next(it);
+    }
+}
+
+void ValueRangeAnalysis::LatticeState::killSlots(const int32_t p_below) {
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        it = (it->first < p_below) ? m_slots.erase(it) : std::next(it);
+    }
+    for (auto it = m_copies.begin(); it != m_copies.end();) {
+        it = (it->second < p_below) ? m_copies.erase(it) : std::next(it);
+    }
+    for (auto it = m_aliases.begin(); it != m_aliases.end();) {
+        const bool kill = it->first < p_below || it->second < p_below;
+        it = kill ? m_aliases.erase(it) : std::next(it);
+    }
+}
+
+// ===========================================
+// > ValueRangeAnalysis
+// ===========================================
+bool ValueRangeAnalysis::resolveSlot(const std::string &p_operand,
+                                     const LatticeState &p_state,
+                                     int32_t &p_slot) const {
+    MemoryOperand mem;
+    if (!parseMemoryOperand(p_operand, mem)) {
+        return false;
+    }
+    if (mem.base == kFramePointer) {
+        p_slot = mem.offset;
+        return true;
+    }
+    if (mem.base == kStackPointer && p_state.m_sp_known) {
+        p_slot = p_state.m_sp_offset + mem.offset;
+        return true;
+    }
+    return false;
+}
+
+ValueRange ValueRangeAnalysis::evaluate(const MachineInstruction &p_inst,
+                                        const LatticeState &p_state) {
+    const auto &op = p_inst.getOpcode();
+    const auto &operands = p_inst.getOperands();
+
+    if (op == "li") {
+        int32_t imm = 0;
+        return (operands.size() == 2 && parseImmediate(operands[1], imm))
+                   ? ValueRange{imm, imm}
+                   : ValueRange{};
+    }
+    if (op == "mv") {
+        return p_state.getRange(operands[1]);
+    }
+    if (op == "neg") {
+        const auto src = p_state.getRange(operands[1]);
+        return ValueRange::of(-src.m_max, -src.m_min);
+    }
+    if (op == "not") {
+        const auto src = p_state.getRange(operands[1]);
+        return ValueRange::of(-src.m_max - 1, -src.m_min - 1);
+    }
+    if (op == "seqz" || op == "snez" || op == "sltz" || op == "sgtz") {
+        return ValueRange{0, 1};
+    }
+    if (operands.size() != 3) {
+        return ValueRange{};
+    }
+
+    ValueRange rhs;
+    std::string binary_op = getRegisterForm(op);
+    if (!binary_op.empty()) {
+        int32_t imm = 0;
+        if (!parseImmediate(operands[2], imm)) {
+            return ValueRange{};
+        }
+        rhs = ValueRange{imm, imm};
+    } else {
+        binary_op = op;
+        rhs = p_state.getRange(operands[2]);
+    }
+    const auto lhs = p_state.getRange(operands[1]);
+
+    if (binary_op == "add") {
+        return ValueRange::of(lhs.m_min + rhs.m_min, lhs.m_max + rhs.m_max);
+    }
+    if (binary_op == "sub") {
+        return ValueRange::of(lhs.m_min - rhs.m_max, lhs.m_max - rhs.m_min);
+    }
+    if (binary_op == "mul" || binary_op == "div") {
+        // truncating division is monotonic on each side of 0; exclude the
+        // division by 0 and INT32_MIN / -1
+        if (binary_op == "div" &&
+            (rhs.contains(0) ||
+             (lhs.contains(INT32_MIN) && rhs.contains(-1)))) {
+            return ValueRange{};
+        }
+        auto apply = [&](const int64_t p_lhs, const int64_t p_rhs) {
+            return (binary_op == "mul") ? p_lhs * p_rhs : p_lhs / p_rhs;
+        };
+        const int64_t corners[] = {
+            apply(lhs.m_min, rhs.m_min), apply(lhs.m_min, rhs.m_max),
+            apply(lhs.m_max, rhs.m_min), apply(lhs.m_max, rhs.m_max)};
+        return ValueRange::of(*std::min_element(corners, corners + 4),
+                              *std::max_element(corners, corners + 4));
+    }
+    if (binary_op == "divu") {
+        if (!lhs.isNonNegative() || rhs.m_min <= 0) {
+            return ValueRange{};
+        }
+        return ValueRange{lhs.m_min / rhs.m_max, lhs.m_max / rhs.m_min};
+    }
+    if (binary_op == "rem") {
+        if (rhs.contains(0)) {
+            return ValueRange{};
+        }
+        // |result| < |divisor|, with the sign of the dividend
+        const int64_t bound =
+            std::max(std::abs(rhs.m_min), std::abs(rhs.m_max)) - 1;
+        if (lhs.isNonNegative()) {
+            return ValueRange{0, std::min(lhs.m_max, bound)};
+        }
+        if (lhs.m_max <= 0) {
+            return ValueRange{std::max(lhs.m_min, -bound), 0};
+        }
+        return ValueRange{-bound, bound};
+    }
+    if (binary_op == "remu") {
+        if (rhs.m_min <= 0) {
+            return ValueRange{};
+        }
+        const int64_t max = lhs.isNonNegative()
+                                ? std::min(lhs.m_max, rhs.m_max - 1)
+                                : rhs.m_max - 1;
+        return ValueRange{0, max};
+    }
+    if (binary_op == "and") {
+        if (lhs.isNonNegative() && rhs.isNonNegative()) {
+            return ValueRange{0, std::min(lhs.m_max, rhs.m_max)};
+        }
+        if (lhs.isNonNegative() || rhs.isNonNegative()) {
+            return ValueRange{
+                0, lhs.isNonNegative() ? lhs.m_max : rhs.m_max};
+        }
+        return ValueRange{};
+    }
+    if (binary_op == "or" || binary_op == "xor") {
+        if (!lhs.isNonNegative() || !rhs.isNonNegative()) {
+            return ValueRange{};
+        }
+        int64_t mask = 0;
+        while (mask < std::max(lhs.m_max, rhs.m_max)) {
+            mask = mask * 2 + 1;
+        }
+        return ValueRange{0, mask};
+    }
+    if (binary_op == "sll" || binary_op == "srl" || binary_op == "sra") {
+        if (!rhs.isConstant()) {
+            return ValueRange{};
+        }
+        const int shamt = static_cast<int>(rhs.m_min & 31);
+        if (binary_op == "sll") {
+            return ValueRange::of(lhs.m_min * (int64_t{1} << shamt),
+                                  lhs.m_max * (int64_t{1} << shamt));
+        }
+        if (binary_op == "sra" || lhs.isNonNegative()) {
+            return ValueRange{lhs.m_min >> shamt, lhs.m_max >> shamt};
+        }
+        return (shamt == 0) ? lhs : ValueRange{0, UINT32_MAX >> shamt};
+    }
+    if (binary_op == "slt" || binary_op == "sltu") {
+        return ValueRange{0, 1};
+    }
+    return ValueRange{};
+}
+
+bool ValueRangeAnalysis::narrowBranch(const MachineInstruction &p_inst,
+                                      const bool p_taken,
+                                      LatticeState &p_state) {
+    std::string op = p_inst.getOpcode();
+    const auto &operands = p_inst.getOperands();
+
+    // normalize to "op lhs, rhs, target" with op in beq, bne, blt, bge,
+    // bltu, bgeu
+    std::string lhs = operands[0];
+    std::string rhs = (operands.size() == 3) ? operands[1] : "zero";
+    if (operands.size() == 2) {
+        // beqz, bnez, blez, bgez, bltz, bgtz
+        op.pop_back();
+    }
+    if (op == "ble" || op == "bgt" || op == "bleu" || op == "bgtu") {
+        std::swap(lhs, rhs);
+        op = std::string((op[1] == 'l') ? "bge" : "blt") +
+             ((op.back() == 'u') ? "u" : "");
+    }
+
+    // the fallthrough edge has the opposite condition
+    if (!p_taken) {
+        static const std::map<std::string, std::string> kNegations = {
+            {"beq", "bne"},  {"bne", "beq"},   {"blt", "bge"},
+            {"bge", "blt"},  {"bltu", "bgeu"}, {"bgeu", "bltu"}};
+        auto search = kNegations.find(op);
+        if (search == kNegations.end()) {
+            return true;
+        }
+        op = search->second;
+    }
+
+    const auto a = p_state.getRange(lhs);
+    const auto b = p_state.getRange(rhs);
+    const bool unsigned_as_signed = a.isNonNegative() && b.isNonNegative();
+    if (unsigned_as_signed && (op == "bltu" || op == "bgeu")) {
+        op.pop_back();
+    }
+
+    if (op == "beq") {
+        const auto range = a.intersect(b);
+        return p_state.narrow(lhs, range) && p_state.narrow(rhs, range);
+    }
+    if (op == "bne") {
+        if (a.isConstant() && b.isConstant()) {
+            return a.m_min != b.m_min;
+        }
+        // only the bounds can be excluded
+        auto exclude = [&](const std::string &p_reg, const ValueRange &p_range,
+                           const int64_t p_value) {
+            if (p_range.m_min == p_value) {
+                return p_state.narrow(p_reg,
+                                      ValueRange{p_value + 1, INT32_MAX});
+            }
+            if (p_range.m_max == p_value) {
+                return p_state.narrow(p_reg,
+                                      ValueRange{INT32_MIN, p_value - 1});
+            }
+            return true;
+        };
+        if (b.isConstant()) {
+            return exclude(lhs, a, b.m_min);
+        }
+        if (a.isConstant()) {
+            return exclude(rhs, b, a.m_min);
+        }
+        return true;
+    }
+    if (op == "blt") {
+        return p_state.narrow(lhs, ValueRange{INT32_MIN, b.m_max - 1}) &&
+               p_state.narrow(rhs, ValueRange{a.m_min + 1, INT32_MAX});
+    }
+    if (op == "bge") {
+        return p_state.narrow(lhs, ValueRange{b.m_min, INT32_MAX}) &&
+               p_state.narrow(rhs, ValueRange{INT32_MIN, a.m_max});
+    }
+    if (op == "bltu" && b.isNonNegative()) {
+        // the idiom of a bounds check: 0 <= lhs < rhs
+        return p_state.narrow(lhs, ValueRange{0, b.m_max - 1});
+    }
+    return true;
+}
+
+void ValueRangeAnalysis::transfer(const MachineInstruction &p_inst,
+                                  LatticeState &p_state) const {
+    if (!p_inst.isInstruction()) {
+        return;
+    }
+
+    const auto &operands = p_inst.getOperands();
+    if (p_inst.isVectorStore()) {
+        // the extent isn't known; it may write any slot if the address of
+        // the frame escapes
+        if (m_frame_escaped) {
+            p_state.killSlots(INT32_MAX);
+        }
+        return;
+    }
+
+    if (p_inst.isStore()) {
+        int32_t slot = 0;
+        if (!resolveSlot(operands[1], p_state, slot)) {
+            // may write any slot if the address of the frame escapes
+            if (m_frame_escaped) {
+                p_state.killSlots(INT32_MAX);
+            }
+            return;
+        }
+        if (p_inst.getOpcode() == "sw") {
+            p_state.storeSlot(slot, operands[0]);
+        } else {
+            // a part of the slot
+            p_state.killSlot(slot & ~3);
+        }
+        return;
+    }
+
+    if (p_inst.isCall()) {
+        for (auto it = p_state.m_registers.begin();
+             it != p_state.m_registers.end();) {
+            it = isCallerSavedRegister(it->first)
+                     ? p_state.m_registers.erase(it)
+                     : std::next(it);
+        }
+        for (auto it = p_state.m_copies.begin();
+             it != p_state.m_copies.end();) {
+            it = isCallerSavedRegister(it->first) ? p_state.m_copies.erase(it)
+                                                  : std::next(it);
+        }
+        for (auto it = p_state.m_register_copies.begin();
+             it != p_state.m_register_copies.end();) {
+            const bool clobbered = isCallerSavedRegister(it->first) ||
+                                   isCallerSavedRegister(it->second);
+            it = clobbered ? p_state.m_register_copies.erase(it)
+                           : std::next(it);
+        }
+        // the callee may write the stack below sp
+        const bool whole_frame = m_frame_escaped || !p_state.m_sp_known;
+        p_state.killSlots(whole_frame ? INT32_MAX : p_state.m_sp_offset);
+        return;
+    }
+
+    const auto defined = p_inst.getDefinedRegister();
+    if (defined.empty()) {
+        return;
+    }
+
+    int32_t imm = 0;
+    if (defined == kStackPointer) {
+        const bool adjusts = p_inst.getOpcode() == "addi" &&
+                             operands[1] == kStackPointer &&
+                             parseImmediate(operands[2], imm);
+        if (adjusts) {
+            p_state.m_sp_offset += imm;
+        } else {
+            p_state.m_sp_known = false;
+        }
+        return;
+    }
+
+    if (defined == kFramePointer) {
+        // a new frame: addi s0, sp, N
+        p_state.killSlots(INT32_MAX);
+        p_state.m_sp_known = p_inst.getOpcode() == "addi" &&
+                             operands[1] == kStackPointer &&
+                             parseImmediate(operands[2], imm);
+        p_state.m_sp_offset = -imm;
+        return;
+    }
+
+    if (p_inst.isLoad()) {
+        static const std::map<std::string, ValueRange> kNarrowLoads = {
+            {"lb", ValueRange{INT8_MIN, INT8_MAX}},
+            {"lbu", ValueRange{0, UINT8_MAX}},
+            {"lh", ValueRange{INT16_MIN, INT16_MAX}},
+            {"lhu", ValueRange{0, UINT16_MAX}}};
+
+        int32_t slot = 0;
+        if (p_inst.getOpcode() == "lw" &&
+            resolveSlot(operands[1], p_state, slot)) {
+            auto search = p_state.m_slots.find(slot);
+            p_state.setRange(defined, (search == p_state.m_slots.end())
+                                          ? ValueRange{}
+                                          : search->second);
+            p_state.m_copies[defined] = p_state.getOrigin(slot);
+            return;
+        }
+        auto search = kNarrowLoads.find(p_inst.getOpcode());
+        p_state.setRange(defined, (search == kNarrowLoads.end())
+                                      ? ValueRange{}
+                                      : search->second);
+        return;
+    }
+
+    const auto range = evaluate(p_inst, p_state);
+    // the copy of a slot is still a copy of it after mv
+    auto copy = p_state.m_copies.find(operands.back());
+    const bool copies_slot =
+        p_inst.getOpcode() == "mv" && copy != p_state.m_copies.end();
+    const int32_t slot = copies_slot ? copy->second : 0;
+    p_state.setRange(defined, range);
+    if (copies_slot) {
+        p_state.m_copies[defined] = slot;
+    } else if (p_inst.getOpcode() == "mv") {
+        p_state.copyRegister(defined, operands[1]);
+    }
+}
+
+void ValueRangeAnalysis::analyze(const MachineFunction &p_function) {
+    m_frame_escaped = p_function.isFrameAddressEscaped();
+
+    const auto &insts = p_function.getInstructions();
+    m_blocks = p_function.computeBasicBlocks();
+    m_in_states.assign(m_blocks.size(), LatticeState{});
+    m_reached.assign(m_blocks.size(), false);
+    if (m_blocks.empty()) {
+        return;
+    }
+
+    std::map<std::pair<size_t, size_t>, LatticeState> edge_states;
+    std::vector<size_t> rounds(m_blocks.size(), 0);
+
+    // every cycle passes through the target of an edge going backward in
+    // the layout, so widening only there is enough to terminate, and the
+    // blocks inside the loops keep the ranges narrowed by the branches
+    std::vector<bool> widened(m_blocks.size(), false);
+    for (size_t b = 0; b < m_blocks.size(); ++b) {
+        for (const auto pred : m_blocks[b].predecessors) {
+            widened[b] = widened[b] || pred >= b;
+        }
+    }
+    // the constants of the function, e.g. the bounds that the loops test
+    std::set<int64_t> thresholds;
+    for (const auto &inst : insts) {
+        int32_t imm = 0;
+        if (inst.isInstruction() && !inst.getOperands().empty() &&
+            parseImmediate(inst.getOperands().back(), imm)) {
+            thresholds.insert(imm);
+        }
+    }
+
+    std::deque<size_t> worklist{0};
+    std::vector<bool> queued(m_blocks.size(), false);
+    queued[0] = true;
+    while (!worklist.empty()) {
+        const size_t b = worklist.front();
+        worklist.pop_front();
+        queued[b] = false;
+
+        LatticeState state;
+        bool first = true;
+        for (const auto pred : m_blocks[b].predecessors) {
+            auto search = edge_states.find({pred, b});
+            if (search == edge_states.end()) {
+                continue;
+            }
+            if (first) {
+                state = search->second;
+                first = false;
+            } else {
+                state.join(search->second);
+            }
+        }
+        if (m_reached[b]) {
+            // the ranges only grow, and stop growing once widened
+            state.join(m_in_states[b]);
+            if (widened[b] && ++rounds[b] > kWideningRounds) {
+                state.widen(m_in_states[b], thresholds);
+            }
+            if (state == m_in_states[b]) {
+                continue;
+            }
+        }
+        m_reached[b] = true;
+        m_in_states[b] = state;
+
+        for (size_t i = m_blocks[b].begin; i < m_blocks[b].end; ++i) {
+            transfer(insts[i], state);
+        }
+
+        // a successor may be both the target and the fallthrough
+        std::map<size_t, LatticeState> successor_states;
+        auto reach = [&](const size_t p_succ, const LatticeState &p_state) {
+            auto search = successor_states.find(p_succ);
+            if (search == successor_states.end()) {
+                successor_states.emplace(p_succ, p_state);
+            } else {
+                search->second.join(p_state);
+            }
+        };
+        const auto &last = insts[m_blocks[b].end - 1];
+        const auto &successors = m_blocks[b].successors;
+        if (last.isBranch()) {
+            LatticeState taken = state;
+            if (narrowBranch(last, true, taken)) {
+                reach(successors.front(), taken);
+            }
+            LatticeState not_taken = state;
+            if (narrowBranch(last, false, not_taken)) {
+                for_each(std::next(successors.begin()), successors.end(),
+                         [&](const size_t p_succ) {
+                             reach(p_succ, not_taken);
+                         });
+            }
+        } else {
+            for (const auto succ : successors) {
+                reach(succ, state);
+            }
+        }
+
+        for (const auto &successor_state : successor_states) {
+            const auto edge = std::make_pair(b, successor_state.first);
+            auto search = edge_states.find(edge);
+            if (search != edge_states.end() &&
+                search->second == successor_state.second) {
+                continue;
+            }
+            edge_states[edge] = successor_state.second;
+            if (!queued[successor_state.first]) {
+                queued[successor_state.first] = true;
+                worklist.push_back(successor_state.first);
+            }
+        }
+    }
+}
+
+// x / 2^k => x >> k, x % 2^k => x & (2^k - 1), and divu/remu for x >= 0
+bool ValueRangeAnalysis::rewriteDivision(MachineInstruction &p_inst,
+                                         const LatticeState &p_state) {
+    const auto &op = p_inst.getOpcode();
+    const auto operands = p_inst.getOperands();
+    if ((op != "div" && op != "rem") ||
+        !p_state.getRange(operands[1]).isNonNegative()) {
+        return false;
+    }
+
+    const auto divisor = p_state.getRange(operands[2]);
+    const bool power_of_two = divisor.isConstant() && divisor.m_min > 0 &&
+                              (divisor.m_min & (divisor.m_min - 1)) == 0;
+    if (power_of_two && op == "div") {
+        int shamt = 0;
+        while ((int64_t{1} << shamt) < divisor.m_min) {
+            ++shamt;
+        }
+        p_inst.setOpcode("srli");
+        p_inst.setOperands(
+            {operands[0], operands[1], std::to_string(shamt)});
+        return true;
+    }
+    // the immediate of andi has 12 bits
+    if (power_of_two && op == "rem" && divisor.m_min - 1 <= 2047) {
+        p_inst.setOpcode("andi");
+        p_inst.setOperands({operands[0], operands[1],
+                            std::to_string(divisor.m_min - 1)});
+        return true;
+    }
+
+    // both behave the same for the division by 0 as well
+    if (divisor.isNonNegative()) {
+        p_inst.setOpcode(op + "u");
+        return true;
+    }
+    return false;
+}
+
+bool ValueRangeAnalysis::run(MachineFunction &p_function) {
+    analyze(p_function);
+
+    auto &insts = p_function.getInstructions();
+    std::vector<bool> removed(insts.size(), false);
+    bool changed = false;
+    for (size_t b = 0; b < m_blocks.size(); ++b) {
+        if (!m_reached[b]) {
+            continue;
+        }
+
+        LatticeState state = m_in_states[b];
+        for (size_t i = m_blocks[b].begin; i < m_blocks[b].end; ++i) {
+            MachineInstruction &inst = insts[i];
+            const MachineInstruction original = inst;
+
+            if (inst.isBranch()) {
+                LatticeState taken = state;
+                LatticeState not_taken = state;
+                const bool may_take = narrowBranch(inst, true, taken);
+                const bool may_fall = narrowBranch(inst, false, not_taken);
+                if (may_take && !may_fall) {
+                    inst.rewrite("j", {inst.getTarget()});
+                    changed = true;
+                } else if (!may_take && may_fall) {
+                    removed[i] = true;
+                    changed = true;
+                }
+            } else {
+                changed |= rewriteDivision(inst, state);
+            }
+            transfer(original, state);
+        }
+    }
+    p_function.removeInstructions(removed);
+    return changed;
+}
+
+void ValueRangeAnalysis::dump(const MachineFunction &p_function,
+                              FILE *p_out_file) {
+    analyze(p_function);
+
+    const auto &insts = p_function.getInstructions();
+    std::vector<std::string> annotations(insts.size());
+    for (size_t b = 0; b < m_blocks.size(); ++b) {
+        if (!m_reached[b]) {
+            annotations[m_blocks[b].begin] = "unreachable";
+            continue;
+        }
+
+        LatticeState state = m_in_states[b];
+        for (size_t i = m_blocks[b].begin; i < m_blocks[b].end; ++i) {
+            transfer(insts[i], state);
+
+            const auto defined = insts[i].getDefinedRegister();
+            if (defined.empty() || defined == kStackPointer ||
+                defined == kFramePointer || insts[i].isCall()) {
+                continue;
+            }
+            const auto range = state.getRange(defined);
+            if (!range.isFull()) {
+                annotations[i] = defined + " in [" +
+                                 std::to_string(range.m_min) + ", " +
+                                 std::to_string(range.m_max) + "]";
+            }
+        }
+    }
+    p_function.print(p_out_file, annotations);
+}
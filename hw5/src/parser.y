@@ -754,10 +754,87 @@ void yyerror(const char *msg) {
 
 int main(int argc, const char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: ./compiler <filename> --save-path [save path]\n");
+        fprintf(stderr, "Usage: ./compiler <filename> --save-path [save path] "
+                        "[--dump-ast] [--dump-ir] [--print-removed] "
+                        "[--auto-memoize] "
+                        "[--memoize-budget=<bytes>] "
+                        "[--specialize-budget=<nodes>] "
+                        "[--unswitch-budget=<nodes>] "
+                        "[--loop-tile=<iterations>] "
+                        "[--target-feature=+v] [--compress] "
+                        "[--latency-model=<file>] [--print-stalls] "
+                        "[--profile-generate] [--profile-use=<file>] "
+                        "[--bounds-check] "
+                        "[--partial-eval-budget=<steps>] "
+                        "[--partial-eval-memory=<bytes>] [--size-report] "
+                        "[--estimate-cycles] [--while-trip-count=<n>] "
+                        "[-g]\n");
         exit(-1);
     }
 
+    const char *save_path = "";
+    bool dump_ast = false;
+    CodegenOptions codegen_options;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--save-path") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--dump-ast") == 0) {
+            dump_ast = true;
+        } else if (strcmp(argv[i], "--dump-ir") == 0) {
+            codegen_options.dump_ir = true;
+        } else if (strcmp(argv[i], "--print-removed") == 0) {
+            codegen_options.print_removed = true;
+        } else if (strcmp(argv[i], "--auto-memoize") == 0) {
+            codegen_options.auto_memoize = true;
+        } else if (strncmp(argv[i], "--memoize-budget=", 17) == 0) {
+            codegen_options.memoize_budget = strtoul(argv[i] + 17, NULL, 10);
+        } else if (strncmp(argv[i], "--specialize-budget=", 20) == 0) {
+            codegen_options.specialize_budget =
+                strtoul(argv[i] + 20, NULL, 10);
+        } else if (strncmp(argv[i], "--unswitch-budget=", 18) == 0) {
+            codegen_options.unswitch_budget = strtoul(argv[i] + 18, NULL, 10);
+        } else if (strncmp(argv[i], "--loop-tile=", 12) == 0) {
+            codegen_options.loop_tile = strtoul(argv[i] + 12, NULL, 10);
+        } else if (strcmp(argv[i], "--target-feature=+v") == 0) {
+            codegen_options.vector = true;
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            codegen_options.compress = true;
+        } else if (strncmp(argv[i], "--latency-model=", 16) == 0) {
+            if (!codegen_options.latency_model.load(argv[i] + 16)) {
+                fprintf(stderr, "Invalid latency model: %s\n", argv[i] + 16);
+                exit(-1);
+            }
+        } else if (strcmp(argv[i], "--print-stalls") == 0) {
+            codegen_options.print_stalls = true;
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            codegen_options.profile_generate = true;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            if (!codegen_options.profile.load(argv[i] + 14)) {
+                fprintf(stderr, "Invalid profile: %s\n", argv[i] + 14);
+                exit(-1);
+            }
+        } else if (strcmp(argv[i], "--bounds-check") == 0) {
+            codegen_options.bounds_check = true;
+        } else if (strncmp(argv[i], "--partial-eval-budget=", 22) == 0) {
+            codegen_options.partial_eval_budget =
+                strtoul(argv[i] + 22, NULL, 10);
+        } else if (strncmp(argv[i], "--partial-eval-memory=", 22) == 0) {
+            codegen_options.partial_eval_memory =
+                strtoul(argv[i] + 22, NULL, 10);
+        } else if (strcmp(argv[i], "--size-report") == 0) {
+            codegen_options.size_report = true;
+        } else if (strcmp(argv[i], "--estimate-cycles") == 0) {
+            codegen_options.estimate_cycles = true;
+        } else if (strncmp(argv[i], "--while-trip-count=", 19) == 0) {
+            codegen_options.while_trip_count = strtoul(argv[i] + 19, NULL, 10);
+        } else if (strcmp(argv[i], "-g") == 0) {
+            codegen_options.debug_line = true;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+
     yyin = fopen(argv[1], "r");
     if (yyin == NULL) {
         perror("fopen() failed:");
@@ -765,7 +842,7 @@ int main(int argc, const char *argv[]) {
 
     yyparse();
 
-    if (argc >= 3 && strcmp(argv[2], "--dump-ast") == 0) {
+    if (dump_ast) {
         AstDumper ast_dumper;
         root->accept(ast_dumper);
     }
@@ -778,8 +855,9 @@ int main(int argc, const char *argv[]) {
                "|---------------------------------------------------|\n"
                "|  There is no syntactic error and semantic error!  |\n"
                "|---------------------------------------------------|\n");
-        CodeGenerator code_generator(argv[1], (argc == 4) ? argv[3] : "",
-                                     sema_analyzer.getSymbolManager());
+        CodeGenerator code_generator(argv[1], save_path,
+                                     sema_analyzer.getSymbolManager(),
+                                     codegen_options);
         root->accept(code_generator);
     }
 
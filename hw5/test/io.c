@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 void printInt(int value)
 {
@@ -27,3 +28,29 @@ void printString(char *value)
 {
     printf("%s\n", value);
 }
+
+// called at the exit of a program compiled with --profile-generate: append
+// the count of each compound statement, located by the (line, col) pairs in
+// locations, to the profile at path
+void dumpProfile(const unsigned *counts, const int *locations, int n,
+                 const char *path)
+{
+    FILE *file = fopen(path, "a");
+    if (file == NULL) {
+        perror("dumpProfile");
+        return;
+    }
+    for (int i = 0; i < n; ++i) {
+        fprintf(file, "%d:%d %u\n", locations[2 * i], locations[2 * i + 1],
+                counts[i]);
+    }
+    fclose(file);
+}
+
+// called by a program compiled with --bounds-check when the index of the
+// array access at (line, col) is out of range
+void boundsError(int line, int col)
+{
+    fprintf(stderr, "%d:%d: array index out of bounds\n", line, col);
+    exit(1);
+}
@@ -0,0 +1,22 @@
+//&S-
+//&T-
+//&D-
+
+aliasLoads;
+
+// a global still held in a register is not loaded again across the stores
+// to the other globals and to the frame
+
+var g, h, k: integer;
+
+begin
+	var y: integer;
+	read g;
+	h := 7;
+	k := g + h;
+	y := g * 2;
+	h := y - h;
+	h := h + g;
+	print g * 3 + h + k + g + y;
+end
+end
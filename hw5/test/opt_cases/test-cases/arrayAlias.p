@@ -0,0 +1,39 @@
+//&S-
+//&T-
+//&D-
+
+arrayAlias;
+
+// both parameters may be the same array, so the elements stored through one
+// are loaded again through the other, even when the loop is vectorized
+
+var g, h: array 16 of integer;
+
+shift(p: array 16 of integer; q: array 16 of integer): integer
+begin
+	for i := 1 to 16 do
+	begin
+		p[i] := q[i - 1] + 1;
+	end
+	end do
+	return p[15] + q[0];
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	for i := 0 to 16 do
+	begin
+		g[i] := 0;
+		h[i] := 0;
+	end
+	end do
+	g[0] := x;
+	h[0] := x;
+	print shift(g, g);
+	print g[8];
+	print shift(h, g);
+	print h[8];
+end
+end
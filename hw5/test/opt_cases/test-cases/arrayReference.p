@@ -0,0 +1,53 @@
+//&S-
+//&T-
+//&D-
+
+arrayReference;
+
+// arrays are passed by reference: the writes of the callee to its parameter
+// are seen by the caller, whether the array is global, local to the caller or
+// a row of a two-dimensional array
+
+var g: array 8 of integer;
+
+scale(p: array 8 of integer; k: integer): integer
+begin
+	var s: integer;
+	s := 0;
+	for i := 0 to 8 do
+	begin
+		p[i] := p[i] * k;
+		s := s + p[i];
+	end
+	end do
+	return s;
+end
+end
+
+begin
+	var a: array 8 of integer;
+	var m: array 3 of array 8 of integer;
+	var x, s: integer;
+	read x;
+	for i := 0 to 8 do
+	begin
+		g[i] := x + i;
+		a[i] := i;
+		m[0][i] := i;
+		m[1][i] := x - i;
+		m[2][i] := 0;
+	end
+	end do
+	s := scale(g, 2);
+	print s;
+	print g[7];
+	s := scale(a, 3);
+	print s;
+	print a[7];
+	s := scale(m[1], 5);
+	print s;
+	print m[1][2];
+	print m[0][2];
+	print m[2][2];
+end
+end
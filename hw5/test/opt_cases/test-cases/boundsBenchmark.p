@@ -0,0 +1,88 @@
+//&S-
+//&T-
+//&D-
+
+boundsBenchmark;
+
+// array kernels to measure the overhead of --bounds-check: the indices of the
+// for loops are proven in range, the column of sumColumn is checked once
+// before its loop, and the indices computed from the data are checked at
+// every access
+
+var data: array 32 of integer;
+var hist: array 8 of integer;
+var grid: array 8 of array 8 of integer;
+
+fill(seed: integer)
+begin
+	for i := 0 to 32 do
+	begin
+		data[i] := (seed * (i + 3)) mod 97;
+	end
+	end do
+	for i := 0 to 8 do
+	begin
+		for j := 0 to 8 do
+		begin
+			grid[i][j] := i * 8 + j;
+		end
+		end do
+	end
+	end do
+end
+end
+
+histogram()
+begin
+	for i := 0 to 32 do
+	begin
+		hist[data[i] mod 8] := hist[data[i] mod 8] + 1;
+	end
+	end do
+end
+end
+
+sumColumn(c: integer): integer
+begin
+	var s: integer;
+	s := 0;
+	for i := 0 to 8 do
+	begin
+		s := s + grid[i][c];
+	end
+	end do
+	return s;
+end
+end
+
+begin
+	var seed, k, w, s: integer;
+	read seed;
+	fill(seed);
+	histogram();
+	for i := 0 to 8 do
+	begin
+		print hist[i];
+	end
+	end do
+	k := seed - 120;
+	s := 0;
+	w := 0;
+	while w < 8 do
+	begin
+		s := s + sumColumn((k + w) mod 8);
+		w := w + 1;
+	end
+	end do
+	print s;
+	w := 0;
+	s := 0;
+	while w < 31 do
+	begin
+		s := s + data[data[w] mod 32] - data[w + 1];
+		w := w + 1;
+	end
+	end do
+	print s;
+end
+end
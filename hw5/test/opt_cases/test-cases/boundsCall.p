@@ -0,0 +1,44 @@
+//&S-
+//&T-
+//&D-
+
+boundsCall;
+
+// with --bounds-check a call whose result is unused is kept if the callee
+// may index out of range, or its arguments may, so that the error is still
+// reported
+
+var a: array 8 of integer;
+
+get(k: integer): integer
+begin
+	return a[k];
+end
+end
+
+first(k: integer): integer
+begin
+	return a[0] + k;
+end
+end
+
+twice(k: integer): integer
+begin
+	return k * 2;
+end
+end
+
+begin
+	var x, i: integer;
+	var b: array 3 of integer;
+	read x;
+	first(x);
+	get(x - 116);
+	print 1;
+	i := x - 118;
+	twice(b[i]);
+	print 2;
+	get(x);
+	print 0;
+end
+end
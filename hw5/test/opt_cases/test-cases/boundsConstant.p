@@ -0,0 +1,37 @@
+//&S-
+//&T-
+//&D-
+
+boundsConstant;
+
+// the check of an index made of a constant declared in the loop is not
+// hoisted out of the loop, where the constant is out of scope
+
+var a: array 4 of integer;
+var g: integer;
+
+begin
+	var w: integer;
+	read g;
+	g := g - 122;
+	for i := 0 to 4 do
+	begin
+		a[i] := i * 10;
+	end
+	end do
+	for i := 0 to 3 do
+	begin
+		var c: 1;
+		print a[c + g];
+	end
+	end do
+	w := 0;
+	while w < 2 do
+	begin
+		var c: 2;
+		print a[c + g];
+		w := w + 1;
+	end
+	end do
+end
+end
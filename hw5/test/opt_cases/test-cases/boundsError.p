@@ -0,0 +1,30 @@
+//&S-
+//&T-
+//&D-
+
+boundsError;
+
+// with --bounds-check an index out of range calls boundsError, which reports
+// the access and exits, after the output printed before it
+
+var a: array 8 of integer;
+
+get(k: integer): integer
+begin
+	return a[k];
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	for i := 0 to 8 do
+	begin
+		a[i] := x + i;
+	end
+	end do
+	print get(x - 116);
+	print get(x - 115);
+	print 0;
+end
+end
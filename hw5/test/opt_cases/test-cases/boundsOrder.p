@@ -0,0 +1,33 @@
+//&S-
+//&T-
+//&D-
+
+boundsOrder;
+
+// the check of an index the loop doesn't change is not hoisted above the
+// print before the access, which runs before the check traps, nor above the
+// check of an earlier access that stays in the loop and traps first
+
+var a: array 4 of integer;
+var g: integer;
+
+begin
+	var w: integer;
+	var b: array 3 of integer;
+	read g;
+	g := g - 116;
+	w := 0;
+	while w < 3 do
+	begin
+		print w;
+		for i := 0 to 3 do
+		begin
+			b[i + 5] := 1;
+			a[g] := 2;
+		end
+		end do
+		w := w + 1;
+	end
+	end do
+end
+end
@@ -0,0 +1,40 @@
+//&S-
+//&T-
+//&D-
+
+coldArms;
+
+// compiled again with the counts of a run on the same input: the arm never
+// taken moves out to .text.unlikely, behind a jump there and back
+
+begin
+	var x, multiples, others: integer;
+	read x;
+	multiples := 0;
+	others := 0;
+	for i := 0 to 30 do
+	begin
+		if x < 0 then
+		begin
+			print x;
+			x := 0 - x;
+		end
+		else
+		begin
+		end
+		end if
+		if (x + i) mod 3 = 0 then
+		begin
+			multiples := multiples + 1;
+		end
+		else
+		begin
+			others := others + i;
+		end
+		end if
+	end
+	end do
+	print multiples;
+	print others;
+end
+end
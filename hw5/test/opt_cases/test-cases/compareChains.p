@@ -0,0 +1,129 @@
+//&S-
+//&T-
+//&D-
+
+compareChains;
+
+// an if/else chain comparing one variable with dense constants becomes a
+// jump table, and one with sparse constants a binary search; the values
+// outside the cases take the final else
+
+dense(state: integer): integer
+begin
+	if state = 0 then
+	begin
+		return 10;
+	end
+	else
+	begin
+		if state = 1 then
+		begin
+			return 11;
+		end
+		else
+		begin
+			if state = 2 then
+			begin
+				return 12;
+			end
+			else
+			begin
+				if state = 4 then
+				begin
+					return 14;
+				end
+				else
+				begin
+					if state = 5 then
+					begin
+					    return 15;
+					end
+					else
+					begin
+					    return -1;
+					end
+					end if
+				end
+				end if
+			end
+			end if
+		end
+		end if
+	end
+	end if
+end
+end
+
+sparse(code: integer): integer
+begin
+	if code = 1 then
+	begin
+		return 1;
+	end
+	else
+	begin
+		if code = 10 then
+		begin
+			return 2;
+		end
+		else
+		begin
+			if code = 100 then
+			begin
+				return 3;
+			end
+			else
+			begin
+				if code = 1000 then
+				begin
+					return 4;
+				end
+				else
+				begin
+					if code = 5000 then
+					begin
+					    return 5;
+					end
+					else
+					begin
+					    if code = -20000 then
+					    begin
+					        return 6;
+					    end
+					    else
+					    begin
+					        return 0;
+					    end
+					    end if
+					end
+					end if
+				end
+				end if
+			end
+			end if
+		end
+		end if
+	end
+	end if
+end
+end
+
+begin
+	var x, i, sum: integer;
+	read x;
+	sum := 0;
+	for i := 0 to 7 do
+	begin
+		sum := sum * 10 + dense(i - 1) + 1;
+	end
+	end do
+	print sum;
+	print dense(x - 121);
+	print dense(x);
+	print sparse(1) + sparse(10) + sparse(100) + sparse(1000) + sparse(5000);
+	print sparse(-20000);
+	print sparse(x);
+	print sparse(x - 23);
+	print sparse(-x);
+end
+end
@@ -0,0 +1,50 @@
+//&S-
+//&T-
+//&D-
+
+compress;
+
+// with --compress the short forms of the loads, stores, moves and small
+// immediates through sp and the registers x8-x15 are emitted, and so are
+// those of the jumps to the labels close enough
+
+var total: integer;
+
+step(x, k: integer): integer
+begin
+	var y: integer;
+	y := x * 3 + k;
+	if y > 1000 then
+	begin
+		y := y mod 1000;
+	end
+	else
+	begin
+	end
+	end if
+	return y;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	total := 0;
+	for i := 0 to 20 do
+	begin
+		x := step(x, i);
+		if x mod 2 = 0 then
+		begin
+			total := total + x;
+		end
+		else
+		begin
+			total := total - 1;
+		end
+		end if
+	end
+	end do
+	print x;
+	print total;
+end
+end
@@ -0,0 +1,45 @@
+//&S-
+//&T-
+//&D-
+
+constantBranches;
+
+// the branches on constants are folded, and the code they skip goes away
+
+pick(n: integer): integer
+begin
+	var k, r: integer;
+	k := 4;
+	r := n;
+	if k * 2 > 7 then
+	begin
+		r := r + k;
+	end
+	else
+	begin
+		r := 77777;
+	end
+	end if
+	k := k - 4;
+	while k > 0 do
+	begin
+		r := 88888;
+		k := k - 1;
+	end
+	end do
+	if k = 0 then
+	begin
+		r := r * 2;
+	end
+	end if
+	return r;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	print pick(x);
+	print pick(-3);
+end
+end
@@ -0,0 +1,27 @@
+//&S-
+//&T-
+//&D-
+
+constantImmediates;
+
+// the constants are substituted as immediates and take no storage
+
+var limit: 12;
+var total: integer;
+
+scale(x: integer): integer
+begin
+	var factor: 3;
+	return x * factor + limit;
+end
+end
+
+begin
+	var step: -2;
+	var x: integer;
+	read x;
+	total := scale(x) + step;
+	print total;
+	print limit - step;
+end
+end
@@ -0,0 +1,39 @@
+//&S-
+//&T-
+//&D-
+
+deadCode;
+
+// the functions main can't reach and the globals nothing reads are left out
+
+var used: integer;
+var unused: integer;
+var onlyDead: integer;
+
+live(x: integer): integer
+begin
+	used := used + x;
+	return used;
+end
+end
+
+deadToo(x: integer): integer
+begin
+	return x - 1;
+end
+end
+
+dead(x: integer): integer
+begin
+	onlyDead := x;
+	return dead(deadToo(x));
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	print live(x);
+	print live(1);
+end
+end
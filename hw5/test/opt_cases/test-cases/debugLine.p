@@ -0,0 +1,22 @@
+//&S-
+//&T-
+//&D-
+
+debugLine;
+
+// with -g each statement is mapped to its source line by .loc, so that the
+// addresses of a spike commit log can be attributed to the lines
+
+double(x: integer): integer
+begin
+	return x * 2;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	x := double(x);
+	print x + 1;
+end
+end
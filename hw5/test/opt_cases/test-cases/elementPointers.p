@@ -0,0 +1,67 @@
+//&S-
+//&T-
+//&D-
+
+elementPointers;
+
+// the element addresses indexed by the loop variable are stepped along with
+// it, and a loop variable with no other use is replaced by a comparison with
+// the address past the last iteration
+
+var a, b: array 16 of integer;
+var m: array 4 of array 5 of integer;
+
+fill(v: array 16 of integer; seed: integer)
+begin
+	var i: integer;
+	for i := 0 to 16 do
+	begin
+		v[i] := seed * i - 7;
+	end
+	end do
+end
+end
+
+begin
+	var x, i, j, s: integer;
+	read x;
+	fill(a, x);
+	for i := 0 to 15 do
+	begin
+		b[i + 1] := a[i] + a[i + 1];
+	end
+	end do
+	s := 0;
+	for i := 1 to 16 do
+	begin
+		s := s + b[i];
+	end
+	end do
+	print s;
+	for i := 0 to 4 do
+	begin
+		for j := 0 to 5 do
+		begin
+			m[i][j] := i * 10 + j;
+		end
+		end do
+	end
+	end do
+	s := 0;
+	for j := 0 to 5 do
+	begin
+		for i := 0 to 4 do
+		begin
+			s := s * 3 + m[i][j];
+		end
+		end do
+	end
+	end do
+	print s;
+	for i := 2 to 6 do
+	begin
+		print i + b[i - 1];
+	end
+	end do
+end
+end
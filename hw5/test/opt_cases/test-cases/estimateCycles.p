@@ -0,0 +1,25 @@
+//&S-
+//&T-
+//&D-
+
+estimateCycles;
+
+// --estimate-cycles annotates each block with its cycles and, weighted by
+// the iterations of the loops around it, its cycles per call
+
+begin
+	var x, s: integer;
+	read x;
+	s := 0;
+	for i := 0 to 10 do
+	begin
+		for j := 0 to 10 do
+		begin
+			s := s + x * j;
+		end
+		end do
+	end
+	end do
+	print s;
+end
+end
@@ -0,0 +1,52 @@
+//&S-
+//&T-
+//&D-
+
+functionOrder;
+
+// the functions calling each other in loops are laid out next to each
+// other, away from those called once, whatever order they're declared in
+
+leaf(x: integer): integer
+begin
+	return x * 3 + 1;
+end
+end
+
+once(x: integer): integer
+begin
+	return x - 7;
+end
+end
+
+also(x: integer): integer
+begin
+	return x + 5;
+end
+end
+
+inner(x: integer): integer
+begin
+	var s: integer;
+	s := 0;
+	for i := 0 to 10 do
+	begin
+		s := s + leaf(x + i) mod 100;
+	end
+	end do
+	return s;
+end
+end
+
+begin
+	var x, t: integer;
+	read x;
+	t := once(x);
+	for i := 0 to 10 do
+	begin
+		t := t + inner(t mod 50 + i) mod 1000;
+	end
+	end do
+	print also(t);
+end
+end
@@ -0,0 +1,61 @@
+//&S-
+//&T-
+//&D-
+
+interchange;
+
+// a column-major traversal of a row-major array is interchanged unless a
+// dependence would be reversed, and a transposition has its inner loop tiled
+// (--loop-tile)
+
+var m: array 8 of array 16 of integer;
+var t: array 16 of array 8 of integer;
+
+begin
+	var x, i, j, s: integer;
+	read x;
+	// interchanged, so that each row is walked in order
+	for j := 0 to 16 do
+	begin
+		for i := 0 to 8 do
+		begin
+			m[i][j] := x * i + j;
+		end
+		end do
+	end
+	end do
+	// kept: m[i - 1][j + 1] is written by a later iteration of the outer
+	// loop and an earlier one of the inner loop
+	for j := 0 to 15 do
+	begin
+		for i := 1 to 8 do
+		begin
+			m[i][j] := m[i - 1][j + 1] - m[i][j];
+		end
+		end do
+	end
+	end do
+	// tiled
+	for i := 0 to 8 do
+	begin
+		for j := 0 to 16 do
+		begin
+			t[j][i] := m[i][j] + i;
+		end
+		end do
+	end
+	end do
+	s := 0;
+	for i := 0 to 16 do
+	begin
+		for j := 0 to 8 do
+		begin
+			s := s * 3 + t[i][j];
+		end
+		end do
+	end
+	end do
+	print s;
+	print t[15][7];
+end
+end
@@ -0,0 +1,41 @@
+//&S-
+//&T-
+//&D-
+
+largeFrame;
+
+// the scalars and the loop temporaries of sum come after an array of 600
+// integers in its frame, out of the reach of a 12-bit offset from s0
+
+sum(n: integer): integer
+begin
+	var a: array 600 of integer;
+	var s, k: integer;
+	for i := 0 to 600 do
+	begin
+		a[i] := i * n;
+	end
+	end do
+	s := 0;
+	for i := 0 to 600 do
+	begin
+		s := s + a[i];
+	end
+	end do
+	k := 0;
+	while k < 3 do
+	begin
+		s := s + k;
+		k := k + 1;
+	end
+	end do
+	return s + n;
+end
+end
+
+begin
+	var n: integer;
+	read n;
+	print sum(n);
+end
+end
@@ -0,0 +1,27 @@
+//&S-
+//&T-
+//&D-
+
+latencyModel;
+
+// the instructions are scheduled for the latencies of a model file: the
+// loads and multiplications are moved apart from their uses, so there are
+// no more stalls after the scheduling than before it
+
+var g, h: integer;
+
+square(v: integer): integer
+begin
+	return v * v;
+end
+end
+
+begin
+	var x, y: integer;
+	read x;
+	g := x + 1;
+	h := x - 1;
+	y := g * h + square(x) * 3;
+	print y - h * g;
+end
+end
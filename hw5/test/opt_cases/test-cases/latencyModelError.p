@@ -0,0 +1,13 @@
+//&S-
+//&T-
+//&D-
+
+latencyModelError;
+
+// compiled with a latency model whose cycles aren't a number, which the
+// compiler rejects before it reads the program
+
+begin
+	print 1;
+end
+end
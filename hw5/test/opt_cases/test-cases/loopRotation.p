@@ -0,0 +1,35 @@
+//&S-
+//&T-
+//&D-
+
+loopRotation;
+
+// the loops test their condition at the bottom, with one conditional back
+// edge; a while loop whose condition is false on entry skips the body
+
+begin
+	var x, n, sum, i: integer;
+	read x;
+	n := x mod 10;
+	sum := 0;
+	while n > 0 do
+	begin
+		sum := sum + n;
+		n := n - 1;
+	end
+	end do
+	print sum;
+	while x < 0 do
+	begin
+		print x;
+		x := x + 1;
+	end
+	end do
+	for i := 1 to 5 do
+	begin
+		sum := sum * 2 + i;
+	end
+	end do
+	print sum;
+end
+end
@@ -0,0 +1,67 @@
+//&S-
+//&T-
+//&D-
+
+memoize;
+
+// the pure recursive functions cache their results (--auto-memoize); the
+// calls whose arguments are out of the range of the table are computed
+
+var calls: integer;
+
+fib(n: integer): integer
+begin
+	if n < 2 then
+	begin
+		return n;
+	end
+	end if
+	return fib(n - 1) + fib(n - 2);
+end
+end
+
+paths(r, c: integer): integer
+begin
+	if r < 0 then
+	begin
+		return 0;
+	end
+	end if
+	if c < 0 then
+	begin
+		return 0;
+	end
+	end if
+	if r = 0 then
+	begin
+		return 1;
+	end
+	end if
+	return paths(r - 1, c) + paths(r, c - 1);
+end
+end
+
+counted(n: integer): integer
+begin
+	calls := calls + 1;
+	if n = 0 then
+	begin
+		return 0;
+	end
+	end if
+	return counted(n - 1) + 1;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	print fib(x mod 100);
+	print fib(-5);
+	print paths(x mod 12, 9);
+	print paths(-1, 3);
+	print counted(10);
+	print counted(10);
+	print calls;
+end
+end
@@ -0,0 +1,38 @@
+//&S-
+//&T-
+//&D-
+
+partialEval;
+
+// the statements of the body of the program before the first read run at
+// compile time: what they print is printed from constants, the globals start
+// with their final values, and square, no longer called, is removed
+
+var total: integer;
+
+square(x: integer): integer
+begin
+	return x * x;
+end
+end
+
+begin
+	var x, k: integer;
+	total := 0;
+	for i := 0 to 100 do
+	begin
+		total := total + square(i) mod 7;
+	end
+	end do
+	print total;
+	k := 1;
+	while k < 1000 do
+	begin
+		k := k * 3;
+	end
+	end do
+	print k;
+	read x;
+	print x + total + k;
+end
+end
@@ -0,0 +1,31 @@
+//&S-
+//&T-
+//&D-
+
+profileLayout;
+
+// compiled again with the counts of a run on the same input: the else arm
+// taken more often than the if arm falls through from the condition
+
+begin
+	var x, multiples, others: integer;
+	read x;
+	multiples := 0;
+	others := 0;
+	for i := 0 to 30 do
+	begin
+		if (x + i) mod 3 = 0 then
+		begin
+			multiples := multiples + 1;
+		end
+		else
+		begin
+			others := others + i;
+		end
+		end if
+	end
+	end do
+	print multiples;
+	print others;
+end
+end
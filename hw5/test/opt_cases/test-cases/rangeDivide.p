@@ -0,0 +1,22 @@
+//&S-
+//&T-
+//&D-
+
+rangeDivide;
+
+// the loop variable of a for is in [0, 99), so its divisions by powers of 2
+// are shifts and masks and the others are unsigned; the sum starts from the
+// input, so the loop isn't evaluated at compile time
+
+begin
+	var n, s: integer;
+	read n;
+	s := n;
+	for i := 0 to 99 do
+	begin
+		s := s + i / 4 + i mod 8 + i / 3;
+	end
+	end do
+	print s;
+end
+end
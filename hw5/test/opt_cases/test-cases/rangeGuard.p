@@ -0,0 +1,28 @@
+//&S-
+//&T-
+//&D-
+
+rangeGuard;
+
+// the index checks of --bounds-check are folded away by the value ranges
+// that the guards narrow the index to, even where the index is forwarded
+// from the register it was read into
+
+var a: array 4 of integer;
+
+begin
+	var x: integer;
+	read x;
+	if x >= 120 then
+	begin
+		if x < 124 then
+		begin
+			a[x - 120] := 7;
+			print a[x - 120];
+		end
+		end if
+	end
+	end if
+	print a[3];
+end
+end
@@ -0,0 +1,19 @@
+//&S-
+//&T-
+//&D-
+
+schedule;
+
+// the operand popped off the stack is loaded ahead of the constant it is
+// combined with, so the constant fills the latency of the load
+
+var g, h: integer;
+
+begin
+	var x: integer;
+	read x;
+	g := x + 1;
+	h := x - 1;
+	print g * h;
+end
+end
@@ -0,0 +1,43 @@
+//&S-
+//&T-
+//&D-
+
+sideEffects;
+
+// a call whose result is unused is dropped if the callee has no side
+// effects, and kept if it prints or writes a global
+
+var count: integer;
+
+waste(x: integer): integer
+begin
+	var i: integer;
+	i := x * x;
+	return i + 1;
+end
+end
+
+bump(x: integer): integer
+begin
+	count := count + x;
+	return count;
+end
+end
+
+shout(x: integer): integer
+begin
+	print x;
+	return 0;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	waste(x);
+	bump(x);
+	bump(2);
+	shout(count);
+	print count;
+end
+end
@@ -0,0 +1,37 @@
+//&S-
+//&T-
+//&D-
+
+sizeReport;
+
+// --size-report writes the size and the stack usage of each function to
+// sizeReport.size.json: main passes 9 arguments, one of them on the stack,
+// and the stack depth of countDown is unbounded since it calls itself
+
+sum9(a, b, c, d, e, f, g, h, i: integer): integer
+begin
+	return a + b + c + d + e + f + g + h + i;
+end
+end
+
+countDown(n: integer): integer
+begin
+	if n <= 0 then
+	begin
+		return 0;
+	end
+	else
+	begin
+		return n + countDown(n - 1);
+	end
+	end if
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	print sum9(x, x, x, x, x, x, x, x, x + 1);
+	print countDown(x mod 10);
+end
+end
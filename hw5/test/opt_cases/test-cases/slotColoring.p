@@ -0,0 +1,37 @@
+//&S-
+//&T-
+//&D-
+
+slotColoring;
+
+// the two arrays of work are never live at the same time, so they share
+// their frame slots, and the frame isn't extended past its fixed 128 bytes
+
+work(n: integer): integer
+begin
+	var first: array 20 of integer;
+	var second: array 20 of integer;
+	var x, y, s: integer;
+	x := n * 2;
+	for i := 0 to 20 do
+	begin
+		first[i] := x + i;
+	end
+	end do
+	s := first[19] - first[3];
+	y := n + s;
+	for i := 0 to 20 do
+	begin
+		second[i] := y * i;
+	end
+	end do
+	return s + second[19];
+end
+end
+
+begin
+	var n: integer;
+	read n;
+	print work(n);
+end
+end
@@ -0,0 +1,35 @@
+//&S-
+//&T-
+//&D-
+
+slotForwarding;
+
+// the stores of a local are forwarded to the loads that follow them, and the
+// stores that are overwritten before any load are dropped
+
+mix(a, b: integer): integer
+begin
+	var t, u: integer;
+	t := a * 3;
+	u := t + b;
+	t := u - a;
+	t := t + t;
+	return t * u;
+end
+end
+
+begin
+	var x, y, z: integer;
+	read x;
+	y := x + 1;
+	z := y;
+	y := z * 2;
+	x := y - z;
+	print x;
+	print y;
+	print z;
+	z := 5;
+	z := 6;
+	print z + mix(x, 4);
+end
+end
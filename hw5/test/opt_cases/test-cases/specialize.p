@@ -0,0 +1,24 @@
+//&S-
+//&T-
+//&D-
+
+specialize;
+
+// the call sites passing the same constants share a clone taking only the
+// other arguments, which are still passed on the stack past the eighth one
+
+combine(a, b, c, d, e, f, g, h, i, j: integer): integer
+begin
+	return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * g + 8 * h + 9 * i + 10 * j;
+end
+end
+
+begin
+	var x: integer;
+	read x;
+	print combine(x, 2, 3, 4, 5, 6, 7, 8, 9, x);
+	print combine(x + 1, 2, 3, 4, 5, 6, 7, 8, 9, x + 1);
+	print combine(x, x, x, x, x, x, x, x, x, 1);
+	print combine(x, x, x, x, x, x, x, x, x, x);
+end
+end
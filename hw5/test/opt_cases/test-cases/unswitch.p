@@ -0,0 +1,52 @@
+//&S-
+//&T-
+//&D-
+
+unswitch;
+
+// an if whose condition doesn't change in the loop is tested once before it,
+// and the loop is generated once for each arm
+
+var total: integer;
+
+accumulate(mode, n: integer): integer
+begin
+	var i, sum: integer;
+	sum := 0;
+	for i := 0 to 20 do
+	begin
+		if mode = 1 then
+		begin
+			sum := sum + i;
+		end
+		else
+		begin
+			sum := sum - n;
+		end
+		end if
+		total := total + 1;
+	end
+	end do
+	return sum;
+end
+end
+
+begin
+	var x, k: integer;
+	read x;
+	print accumulate(x mod 2, x);
+	print accumulate(x mod 3, x);
+	k := 0;
+	while k < 5 do
+	begin
+		if x > 100 then
+		begin
+			total := total + 10;
+		end
+		end if
+		k := k + 1;
+	end
+	end do
+	print total;
+end
+end
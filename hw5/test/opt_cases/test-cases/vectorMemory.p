@@ -0,0 +1,39 @@
+//&S-
+//&T-
+//&D-
+
+vectorMemory;
+
+// the vector stores of an element-wise loop write the elements stored before
+// it, so they are loaded again after the loop
+
+var g, c: array 16 of integer;
+
+fill(k: integer): integer
+begin
+	var d: array 16 of integer;
+	d[0] := 5;
+	for i := 0 to 16 do
+	begin
+		d[i] := c[i] + k;
+	end
+	end do
+	return d[0];
+end
+end
+
+begin
+	var k: integer;
+	read k;
+	g[3] := 7;
+	print g[3];
+	for i := 0 to 16 do
+	begin
+		c[i] := i + k;
+		g[i] := i * k;
+	end
+	end do
+	print g[3];
+	print fill(k);
+end
+end
@@ -0,0 +1,34 @@
+//&S-
+//&T-
+//&D-
+
+vectorize;
+
+var a, b, c: array 64 of integer;
+
+begin
+
+var x, s: integer;
+read x;
+for i := 0 to 64 do
+begin
+	a[i] := i * x;
+	b[i] := x - i;
+end
+end do
+for i := 0 to 64 do
+begin
+	c[i] := a[i] + b[i];
+end
+end do
+s := 0;
+for i := 0 to 64 do
+begin
+	s := s + c[i];
+end
+end do
+print s;
+print c[63];
+
+end
+end
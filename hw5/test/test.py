@@ -2,10 +2,25 @@
 
 import subprocess
 import os
+import re
 import shutil
 import sys
 import textwrap
 from argparse import ArgumentParser
+from collections import namedtuple
+
+# the compiler flags of an optimization case, the ISA spike runs it with, and
+# the patterns (regular expressions, matched per line with re.M) its assembly
+# must (contains) and must not (excludes) match; a case with profile set is
+# first compiled with --profile-generate and run, and then compiled again
+# with --profile-use of the counts collected; the patterns its
+# <name>.size.json of --size-report must match (report); the patterns the
+# output of the compiler itself, stdout and stderr, must match (output); with
+# --print-stalls, no function may stall more after the scheduling than before
+# it (stalls); a case the compiler must reject with an error is neither
+# assembled nor run (rejected)
+OptCase = namedtuple("OptCase", ["flags", "isa", "contains", "excludes", "profile", "report", "output", "stalls", "rejected"],
+                     defaults=["RV32", [], [], False, [], [], False, False])
 
 class Grader:
 
@@ -47,6 +62,88 @@ class Grader:
     bonus_case_scores = [0, 2, 2, 3, 3, 3, 3, 3]
     bonus_id_list = bonus_cases.keys()
 
+    # not scored: the optimizations and flags of the compiler keep the output
+    opt_case_dir = "./opt_cases"
+    opt_cases = {
+        1 : "slotForwarding",
+        2 : "constantBranches",
+        3 : "constantImmediates",
+        4 : "deadCode",
+        5 : "sideEffects",
+        6 : "memoize",
+        7 : "specialize",
+        8 : "compareChains",
+        9 : "loopRotation",
+        10 : "unswitch",
+        11 : "aliasLoads",
+        12 : "compress",
+        13 : "schedule",
+        14 : "profileLayout",
+        15 : "functionOrder",
+        16 : "coldArms",
+        17 : "partialEval",
+        18 : "slotColoring",
+        19 : "sizeReport",
+        20 : "estimateCycles",
+        21 : "debugLine",
+        22 : "rangeGuard",
+        23 : "elementPointers",
+        24 : "interchange",
+        25 : "vectorize",
+        26 : "boundsConstant",
+        27 : "boundsOrder",
+        28 : "arrayReference",
+        29 : "arrayAlias",
+        30 : "boundsError",
+        31 : "largeFrame",
+        32 : "boundsCall",
+        33 : "vectorMemory",
+        34 : "rangeDivide",
+        35 : "latencyModel",
+        36 : "latencyModelError",
+        37 : "boundsBenchmark",
+    }
+    opt_case_options = {
+        "slotForwarding" : OptCase("", contains=[r"^    sw t0, -20\(s0\)\n    lw t1, 0\(sp\)$"], excludes=[r"^    li t\d, 5$", r"^    lw t\d, -16\(s0\)\n(?:.*\n)*?    sw t\d, -20\(s0\)$", r"^mix\.spec0:\n(?:(?!    \.size).*\n)*?    sw t\d, -(?:12|16|20)\(s0\)$"]),
+        "constantBranches" : OptCase("", excludes=[r"77777", r"88888"]),
+        "constantImmediates" : OptCase("", excludes=[r"limit", r"factor", r"step"]),
+        "deadCode" : OptCase("--print-removed", contains=[r"^live:"], excludes=[r"^dead:", r"^deadToo:", r"unused", r"onlyDead"]),
+        "sideEffects" : OptCase("", contains=[r"jal ra, bump\b", r"jal ra, shout\b"], excludes=[r"jal ra, waste\b"]),
+        "memoize" : OptCase("--auto-memoize", contains=[r"\bfib\.memo\b", r"\bpaths\.memo\b"], excludes=[r"\bcounted\.memo\b"]),
+        "specialize" : OptCase("", contains=[r"^combine\.spec0:", r"^combine\.spec1:", r"jal ra, combine$"]),
+        "compareChains" : OptCase("", contains=[r"^dense:\n(?:    .*\n)*?    li (\w+), 6\n    bgeu \w+, \1, L\d+\n(?:    .*\n)*?    jr \w+\n", r"(?:    \.word L\d+\n){6}", r"^sparse:\n(?:    .*\n)*?    blt \w+, \w+, (L\d+)\n(?:    (?:li|beq) .*\n){6}    j (L\d+)\n\1:\n(?:    (?:li|beq) .*\n){6}    j \2\n"]),
+        "loopRotation" : OptCase("", contains=[r"(?:[\s\S]*?    \.align 4\n(L\d+):\n(?:    .*\n)*?    b\w+ \w+, \w+, \1\n){3}"], excludes=[r"^(L\d+):\n(?:.*\n)*?    j \1$"]),
+        "unswitch" : OptCase("", contains=[r"^accumulate:\n(?:    .*\n)*?    b\w+ \w+, \w+, L\d+\n(?:.*\n)*?    \.align 4\n(L\d+):\n(?:    .*\n)*?    b\w+ \w+, \w+, \1\n(?:L\d+:\n)*    j (L\d+)\n(?:.*\n)*?    \.align 4\n(L\d+):\n(?:    .*\n)*?    b\w+ \w+, \w+, \3\n(?:L\d+:\n)*\2:\n"]),
+        "aliasLoads" : OptCase("", excludes=[r"la \w+, g\n[\s\S]*la \w+, g\n"]),
+        "compress" : OptCase("--compress", isa="RV32GC", contains=[r"\.option rvc", r"c\.addi16sp sp, -128", r"c\.swsp ra, 124\(sp\)", r"c\.lwsp", r"^    c\.j L\d+$"]),
+        "schedule" : OptCase("", contains=[r"^    lw (\w+), 0\(sp\)\n    li \w+, 1\n    (?:add|sub) \w+, \1, \w+$"]),
+        "profileLayout" : OptCase("", contains=[r"beq \w+, \w+, (L\d+)\nL\d+:\n(?:    .*\n)*?    j L\d+\n\1:\n"], profile=True),
+        "functionOrder" : OptCase("", contains=[r"\.size main, \.-main\n    \.globl inner\n", r"\.size inner, \.-inner\n    \.globl leaf\n"]),
+        "coldArms" : OptCase("", contains=[r"^    \.pushsection \.text\.unlikely\n(L\d+):\n(?:    .*\n)*?    j (L\d+)\n    \.popsection$"], profile=True),
+        "partialEval" : OptCase("", contains=[r"^total:\n    \.word 197\n", r"li a0, 197\n    jal ra, printInt\n", r"li a0, 2187\n    jal ra, printInt\n"], excludes=[r"square", r"\bmul\b"]),
+        "slotColoring" : OptCase("", contains=[r"^work:\n    addi sp, sp, -128\n"], excludes=[r"-(?:1[3-9]\d|[2-9]\d\d|\d{4,})\(s0\)"]),
+        "sizeReport" : OptCase("--size-report", report=[r"\"name\": \"sum9\"", r"\"max_outgoing_args\": 9", r"\"name\": \"countDown\"", r"\"unbounded_recursion\": true"]),
+        "estimateCycles" : OptCase("--estimate-cycles", contains=[r"^main: +# \d+ cycles, \d+\.0 per call$", r"^L\d+: +# (?P<inner>\d+) cycles, (?P=inner)00\.0 per call$", r"^L\d+: +# (?P<outer>\d+) cycles, (?P=outer)0\.0 per call$"]),
+        "debugLine" : OptCase("-g", contains=[r"    \.file 1 \"", r"    \.loc 1 12$", r"    \.loc 1 18$", r"    \.loc 1 19$", r"    \.loc 1 20$"]),
+        "rangeGuard" : OptCase("--bounds-check", excludes=[r"bgeu", r"boundsError"]),
+        "elementPointers" : OptCase("", contains=[r"    \.align 4\n(L\d+):\n(?:    .*\n)*?    addi (\w+), \2, 20\n(?:    .*\n)*?    bne \w+, \w+, \1\n"]),
+        "interchange" : OptCase("--loop-tile=4", contains=[r"    \.align 4\n(L\d+):\n(?:    .*\n)*?    addi (\w+), \2, 4\n(?:    .*\n)*?    li (\w+), 16\n    blt \w+, \3, \1\n", r"    \.align 4\n(L\d+):\n(?:    .*\n)*?    addi (\w+), \2, 64\n(?:    .*\n)*?    bne \w+, \w+, \1\n", r"    li (\w+), 16\n    addi (\w+), \2, 4\n    sw \2, -\d+\(s0\)\n    blt \2, \1, L\d+\n"]),
+        "vectorize" : OptCase("--target-feature=+v", isa="RV32GCV", contains=[r"vle32\.v", r"vse32\.v", r"vredsum\.vs"]),
+        "boundsConstant" : OptCase("--bounds-check"),
+        "boundsOrder" : OptCase("--bounds-check"),
+        "arrayReference" : OptCase(""),
+        "arrayAlias" : OptCase("--target-feature=+v", isa="RV32GCV"),
+        "boundsError" : OptCase("--bounds-check", contains=[r"jal ra, boundsError"]),
+        "largeFrame" : OptCase("", contains=[r"^    add (\w+), s0, \1$"], excludes=[r"-(?:2049|20[5-9]\d|2[1-9]\d\d|[3-9]\d{3}|\d{5,})\(s0\)"]),
+        "boundsCall" : OptCase("--bounds-check", contains=[r"^    jal ra, get\n(?:.*\n)*?    jal ra, get$", r"^    jal ra, twice$"], excludes=[r"jal ra, first$"]),
+        "vectorMemory" : OptCase("--target-feature=+v", isa="RV32GCV", contains=[r"vse32\.v"]),
+        "rangeDivide" : OptCase("--dump-ir", contains=[r"^    srli \w+, \w+, 2$", r"^    andi \w+, \w+, 7$", r"^    divu \w+, \w+, \w+$"], excludes=[r"^    (?:div|rem) "], output=[r"# t0 in \[0, 99\]$", r"^    divu \w+, \w+, \w+ +# t0 in \[0, 33\]$"]),
+        "latencyModel" : OptCase("--latency-model=./opt_cases/latency-models/slowMemory.model --print-stalls", output=[r"^stalls square: \d+ -> \d+$", r"^stalls main: \d+ -> \d+$"], stalls=True),
+        "latencyModelError" : OptCase("--latency-model=./opt_cases/latency-models/malformed.model", output=[r"^Invalid latency model: "], rejected=True),
+        "boundsBenchmark" : OptCase("--bounds-check", output=[r"^bounds-check: 13 checks, 7 removed, 1 hoisted out of loops$"]),
+    }
+    opt_id_list = opt_cases.keys()
+
     diff_result = ""
 
     def __init__(self, compiler, save_path, 
@@ -70,23 +167,29 @@ class Grader:
         if not os.path.exists(self.output_dir):
             os.makedirs(self.output_dir)
 
-    def gen_riscv_code(self, case_type, case_id):
+    def gen_riscv_code(self, case_type, case_id, flags="", log=None):
         if case_type == "basic":
             test_case = "%s/%s/%s.p" % (self.basic_case_dir, "test-cases", self.basic_cases[case_id])
         elif case_type == "advance":
             test_case = "%s/%s/%s.p" % (self.advance_case_dir, "test-cases", self.advance_cases[case_id])
         elif case_type == "bonus":
             test_case = "%s/%s/%s.p" % (self.bonus_case_dir, "test-cases", self.bonus_cases[case_id])
+        elif case_type == "opt":
+            test_case = "%s/%s/%s.p" % (self.opt_case_dir, "test-cases", self.opt_cases[case_id])
       
-        clist = [self.compiler, test_case, "--save-path", self.save_path]
+        clist = [self.compiler, test_case, "--save-path", self.save_path, flags]
         cmd = " ".join(clist)
+        output = open(log, "w") if log else None
         try:
-            proc = subprocess.Popen(cmd, shell=True)
+            proc = subprocess.Popen(cmd, stdout=output, stderr=subprocess.STDOUT if log else None, shell=True)
         except Exception as e:
             print(Colors.RED + "Call of '%s' failed: %s" % (" ".join(clist), e))
             exit(1)
 
-        proc.wait()
+        retcode = proc.wait()
+        if output:
+            output.close()
+        return retcode
 
     def compile_riscv_code(self, case_type, case_id):
         if case_type == "basic":
@@ -98,6 +201,9 @@ class Grader:
         elif case_type == "bonus":
             test_case = "%s/%s.S" % (self.save_path, self.bonus_cases[case_id])
             executable_file = "%s/%s" % (self.executable_file_path, self.bonus_cases[case_id])
+        elif case_type == "opt":
+            test_case = "%s/%s.S" % (self.save_path, self.opt_cases[case_id])
+            executable_file = "%s/%s" % (self.executable_file_path, self.opt_cases[case_id])
 
         clist = ["riscv32-unknown-elf-gcc", test_case, self.io_file, "-o", executable_file]
         cmd = " ".join(clist)
@@ -109,7 +215,7 @@ class Grader:
 
         proc.wait()
 
-    def run_riscv_code(self, case_type, case_id):
+    def run_riscv_code(self, case_type, case_id, isa="RV32"):
         if case_type == "basic":
             output_file = "%s/%s" % (self.code_result_path, self.basic_cases[case_id])
             executable_file = "%s/%s" % (self.executable_file_path, self.basic_cases[case_id])
@@ -119,8 +225,11 @@ class Grader:
         elif case_type == "bonus":
             output_file = "%s/%s" % (self.code_result_path, self.bonus_cases[case_id])
             executable_file = "%s/%s" % (self.executable_file_path, self.bonus_cases[case_id])
+        elif case_type == "opt":
+            output_file = "%s/%s" % (self.code_result_path, self.opt_cases[case_id])
+            executable_file = "%s/%s" % (self.executable_file_path, self.opt_cases[case_id])
 
-        clist = ["echo", "123", "|", "spike", "--isa=RV32", "/risc-v/riscv32-unknown-elf/bin/pk", executable_file]
+        clist = ["echo", "123", "|", "spike", "--isa=%s" % isa, "/risc-v/riscv32-unknown-elf/bin/pk", executable_file]
         cmd = " ".join(clist)
         try:
             proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, shell=True)
@@ -162,6 +271,9 @@ class Grader:
         elif case_type == "bonus":
             output_file = "%s/%s" % (self.code_result_path, self.bonus_cases[case_id])
             solution = "%s/%s/%s" % (self.bonus_case_dir, "sample-solutions", self.bonus_cases[case_id])
+        elif case_type == "opt":
+            output_file = "%s/%s" % (self.code_result_path, self.opt_cases[case_id])
+            solution = "%s/%s/%s" % (self.opt_case_dir, "sample-solutions", self.opt_cases[case_id])
 
         clist = ["diff", "-Z", "-u", output_file, solution, f'--label="your output:({output_file})"', f'--label="answer:({solution})"']
         cmd = " ".join(clist)
@@ -182,6 +294,8 @@ class Grader:
                 self.diff_result += "{}\n".format(self.advance_cases[case_id])
             elif case_type == "bonus":
                 self.diff_result += "{}\n".format(self.bonus_cases[case_id])
+            elif case_type == "opt":
+                self.diff_result += "{}\n".format(self.opt_cases[case_id])
             self.diff_result += "{}\n".format(output)
 
         return retcode == 0
@@ -193,6 +307,83 @@ class Grader:
 
         return self.compare_file_content(case_type, case_id)
 
+    def check_assembly(self, case_id):
+        name = self.opt_cases[case_id]
+        options = self.opt_case_options[name]
+        path = "%s/%s.S" % (self.save_path, name)
+        if not os.path.exists(path):
+            return False
+        with open(path) as assembly:
+            code = assembly.read()
+
+        missing = [pattern for pattern in options.contains if not re.search(pattern, code, re.M)]
+        unexpected = [pattern for pattern in options.excludes if re.search(pattern, code, re.M)]
+        for text in missing:
+            self.diff_result += "{}\nmissing in the assembly: {}\n".format(name, text)
+        for text in unexpected:
+            self.diff_result += "{}\nunexpected in the assembly: {}\n".format(name, text)
+
+        missing_in_report = []
+        if options.report:
+            path = "%s/%s.size.json" % (self.save_path, name)
+            report = ""
+            if os.path.exists(path):
+                with open(path) as report_file:
+                    report = report_file.read()
+            missing_in_report = [pattern for pattern in options.report if not re.search(pattern, report, re.M)]
+            for text in missing_in_report:
+                self.diff_result += "{}\nmissing in the size report: {}\n".format(name, text)
+        return not missing and not unexpected and not missing_in_report
+
+    def check_output(self, case_id):
+        name = self.opt_cases[case_id]
+        options = self.opt_case_options[name]
+        with open("%s/%s.log" % (self.save_path, name)) as log:
+            output = log.read()
+
+        missing = [pattern for pattern in options.output if not re.search(pattern, output, re.M)]
+        for text in missing:
+            self.diff_result += "{}\nmissing in the compiler output: {}\n".format(name, text)
+
+        fewer_stalls = True
+        if options.stalls:
+            stalls = re.findall(r"^stalls \S+: (\d+) -> (\d+)$", output, re.M)
+            fewer_stalls = bool(stalls) and all(int(after) <= int(before) for before, after in stalls)
+            if not fewer_stalls:
+                self.diff_result += "{}\nmore stalls after the scheduling than before it\n".format(name)
+        return not missing and fewer_stalls
+
+    def test_opt_case(self, case_id):
+        name = self.opt_cases[case_id]
+        options = self.opt_case_options[name]
+        flags = options.flags
+
+        if options.profile:
+            # the program dumps the counts to <program name>.profile in the
+            # working directory, appending to what's there
+            profile = "%s.profile" % name
+            if os.path.exists(profile):
+                os.remove(profile)
+            self.gen_riscv_code("opt", case_id, "--profile-generate")
+            self.compile_riscv_code("opt", case_id)
+            self.run_riscv_code("opt", case_id, options.isa)
+            flags += " --profile-use=%s" % profile
+
+        checks_output = options.output or options.stalls or options.rejected
+        log = "%s/%s.log" % (self.save_path, name) if checks_output else None
+        retcode = self.gen_riscv_code("opt", case_id, flags, log)
+        if options.rejected:
+            if retcode == 0:
+                self.diff_result += "{}\naccepted by the compiler\n".format(name)
+            return self.check_output(case_id) and retcode != 0
+
+        self.compile_riscv_code("opt", case_id)
+        self.run_riscv_code("opt", case_id, options.isa)
+
+        ok = self.compare_file_content("opt", case_id)
+        ok = self.check_assembly(case_id) and ok
+        return (self.check_output(case_id) if checks_output else True) and ok
+
     def run(self):
         print("---\tCase\t\tPoints")
 
@@ -229,6 +420,15 @@ class Grader:
             total_score += get_val
             max_score += max_val
 
+        opt_passed = 0
+        for o_id in self.opt_id_list:
+            c_name = self.opt_cases[o_id]
+            print("+++ TESTING opt case %s:" % c_name)
+            ok = self.test_opt_case(o_id)
+            print("---\t%s\t%s" % (c_name, "ok" if ok else "failed"))
+            opt_passed += 1 if ok else 0
+        print("---\tOPT\t\t%d/%d" % (opt_passed, len(self.opt_cases)))
+
         print("---\tTOTAL\t\t%d/%d" % (total_score, max_score))
 
         with open("{}/{}".format(self.output_dir, "score.txt"), "w") as result: